@@ -0,0 +1,116 @@
+#include <dirent.h>
+#include <stdlib.h>  // mkdtemp
+#include <unistd.h>  // rmdir, unlink
+
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "collabserver/server/room/Broadcaster.h"
+#include "collabserver/server/room/CollabServer.h"
+#include "collabserver/server/storage/Durability.h"
+
+/*
+ * Commit throughput of a persisted room for each durability level. Operations
+ * are committed by groups, each group is synced once (as the server does for
+ * a batch of requests). GROUP_SYNC with groups of 1 is one fsync per
+ * operation.
+ *
+ * Usage: collabserver-bench-durability [nbOperations] [groupSize] [bufferSize]
+ */
+
+using namespace collabserver;
+
+typedef std::chrono::steady_clock Clock;
+
+class NullBroadcaster : public Broadcaster {
+   public:
+    void sendOperationToUser(const OperationInfo& op, unsigned int id) override {}
+    void broadcastOperationToRoom(const OperationInfo& op, unsigned int id) override {}
+    void sendSnapshotToUser(const SnapshotInfo& snapshot, unsigned int id) override {}
+    void sendOperationToStream(const OperationInfo& op, unsigned int id) override {}
+    void sendSnapshotToStream(const SnapshotInfo& snapshot, unsigned int id) override {}
+};
+
+// Remove a directory with its files and subdirectories (room logs and their segments)
+static void removeDirectory(const std::string& path) {
+    DIR* dir = ::opendir(path.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    while (const struct dirent* entry = ::readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        const std::string child = path + "/" + name;
+        if (::unlink(child.c_str()) != 0) {
+            removeDirectory(child);
+        }
+    }
+    ::closedir(dir);
+    ::rmdir(path.c_str());
+}
+
+static double benchDurability(const Durability durability, const int nbOps, const int groupSize,
+                              const std::size_t bufferSize) {
+    char storageDir[] = "/tmp/collabserver-bench-XXXXXX";
+    if (::mkdtemp(storageDir) == nullptr) {
+        return 0;
+    }
+
+    double elapsed = 0;
+    {
+        NullBroadcaster broadcaster;
+        CollabServer server(broadcaster);
+        server.enableStorage(storageDir, durability);
+        const unsigned int roomID = 1;
+        const unsigned int userID = 1;
+        server.createNewRoom(roomID);
+        server.registerUser(userID);
+        server.userJoinRoom(userID, roomID);
+
+        OperationInfo op;
+        op.roomID = roomID;
+        op.userID = userID;
+        op.opTypeID = 1;
+        op.buffer.assign(bufferSize, 'x');
+
+        const Clock::time_point start = Clock::now();
+        for (int k = 0; k < nbOps; ++k) {
+            server.commitOperationInRoom(op, roomID);
+            if ((k + 1) % groupSize == 0 || k + 1 == nbOps) {
+                server.syncRooms();
+            }
+        }
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }  // Room logs closed before their files are removed
+    removeDirectory(storageDir);
+    return static_cast<double>(nbOps) / elapsed;
+}
+
+static void printResult(const char* name, const int groupSize, const double opsPerSec) {
+    std::printf("%-12s %10d %14.0f\n", name, groupSize, opsPerSec);
+}
+
+int main(int argc, char** argv) {
+    const int nbOps = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    const int groupSize = (argc > 2) ? std::atoi(argv[2]) : 64;
+    const int bufferSize = (argc > 3) ? std::atoi(argv[3]) : 64;
+    if (nbOps <= 0 || groupSize <= 0 || bufferSize < 0) {
+        std::fprintf(stderr, "Usage: %s [nbOperations] [groupSize] [bufferSize]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t size = static_cast<std::size_t>(bufferSize);
+    std::printf("Operations: %d, buffer size: %d bytes\n", nbOps, bufferSize);
+    std::printf("%-12s %10s %14s\n", "Durability", "Group size", "ops/sec");
+    printResult("none", groupSize, benchDurability(Durability::NONE, nbOps, groupSize, size));
+    printResult("async", groupSize, benchDurability(Durability::ASYNC, nbOps, groupSize, size));
+    printResult("group-sync", groupSize, benchDurability(Durability::GROUP_SYNC, nbOps, groupSize, size));
+    printResult("group-sync", 1, benchDurability(Durability::GROUP_SYNC, nbOps, 1, size));
+    return EXIT_SUCCESS;
+}
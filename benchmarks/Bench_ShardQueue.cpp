@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "collabserver/server/utils/BlockingQueue.h"
+#include "collabserver/server/utils/Mailbox.h"
+
+/*
+ * Hand-off between producers (network thread) and one consumer (shard
+ * worker): Mailbox (lock-free MPSCQueue + eventfd) versus BlockingQueue
+ * (mutex + condition variable).
+ *
+ * Usage: collabserver-bench-shardqueue [nbProducers] [nbItemsPerProducer]
+ */
+
+using namespace collabserver;
+
+typedef std::chrono::steady_clock Clock;
+
+static const std::size_t local_batchSize = 64;
+
+struct Item {
+    int64_t timestamp = 0;  // Push time (ns). 0 means stop.
+};
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct Result {
+    double opsPerSec;
+    int64_t p50;
+    int64_t p99;
+};
+
+static Result computeResult(std::vector<int64_t>& latencies, const int64_t elapsedNs) {
+    std::sort(latencies.begin(), latencies.end());
+    Result result;
+    result.opsPerSec = static_cast<double>(latencies.size()) * 1e9 / static_cast<double>(elapsedNs);
+    result.p50 = latencies[latencies.size() / 2];
+    result.p99 = latencies[(latencies.size() * 99) / 100];
+    return result;
+}
+
+template <typename PushFunction>
+static std::vector<std::thread> startProducers(const int nbProducers, const int nbItems, PushFunction push) {
+    std::vector<std::thread> producers;
+    for (int p = 0; p < nbProducers; ++p) {
+        producers.emplace_back([nbItems, push] {
+            for (int k = 0; k < nbItems; ++k) {
+                Item item;
+                item.timestamp = nowNs();
+                push(item);
+            }
+        });
+    }
+    return producers;
+}
+
+static Result benchMailbox(const int nbProducers, const int nbItems) {
+    Mailbox<Item> mailbox(4096);
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<std::size_t>(nbProducers) * nbItems);
+
+    const int64_t start = nowNs();
+    auto producers = startProducers(nbProducers, nbItems, [&mailbox](Item item) { mailbox.push(item); });
+
+    Item batch[local_batchSize];
+    while (latencies.size() < latencies.capacity()) {
+        const std::size_t count = mailbox.waitBatch(batch, local_batchSize);
+        const int64_t now = nowNs();
+        for (std::size_t k = 0; k < count; ++k) {
+            latencies.push_back(now - batch[k].timestamp);
+        }
+    }
+    const int64_t elapsed = nowNs() - start;
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    return computeResult(latencies, elapsed);
+}
+
+static Result benchBlockingQueue(const int nbProducers, const int nbItems) {
+    BlockingQueue<Item> queue;
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<std::size_t>(nbProducers) * nbItems);
+
+    const int64_t start = nowNs();
+    auto producers = startProducers(nbProducers, nbItems, [&queue](Item item) { queue.push(item); });
+
+    while (latencies.size() < latencies.capacity()) {
+        Item item = queue.pop();
+        latencies.push_back(nowNs() - item.timestamp);
+    }
+    const int64_t elapsed = nowNs() - start;
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    return computeResult(latencies, elapsed);
+}
+
+static void printResult(const char* name, const Result& result) {
+    std::printf("%-28s %14.0f %12lld %12lld\n", name, result.opsPerSec, static_cast<long long>(result.p50),
+                static_cast<long long>(result.p99));
+}
+
+int main(int argc, char** argv) {
+    const int nbProducers = (argc > 1) ? std::atoi(argv[1]) : 2;
+    const int nbItems = (argc > 2) ? std::atoi(argv[2]) : 500000;
+    if (nbProducers <= 0 || nbItems <= 0) {
+        std::fprintf(stderr, "Usage: %s [nbProducers] [nbItemsPerProducer]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("Producers: %d, items per producer: %d\n", nbProducers, nbItems);
+    std::printf("%-28s %14s %12s %12s\n", "Queue", "ops/sec", "p50 (ns)", "p99 (ns)");
+    printResult("Mailbox (MPSC + eventfd)", benchMailbox(nbProducers, nbItems));
+    printResult("BlockingQueue (mutex + cv)", benchBlockingQueue(nbProducers, nbItems));
+    return EXIT_SUCCESS;
+}
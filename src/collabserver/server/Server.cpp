@@ -1,40 +1,188 @@
 #include "collabserver/server/Server.h"
 
+#include <algorithm>  // std::max
 #include <cassert>
+#include <cerrno>
+#include <exception>
+#include <memory>
+#include <utility>  // std::move
 #include <zmq.hpp>
 
 #include "collabserver/network/messaging/MessageFactory.h"
 #include "collabserver/network/socket/ZMQSocket.h"
+#include "collabserver/server/network/FrameBatch.h"
+#include "collabserver/server/network/MessageCodec.h"
+#include "collabserver/server/network/MsgRoomOperationAck.h"
+#include "collabserver/server/network/Outbox.h"
+#include "collabserver/server/network/PublisherPool.h"
+#include "collabserver/server/network/PublisherSocket.h"
+#include "collabserver/server/network/RouterSocket.h"
+#include "collabserver/server/network/ServerMessages.h"
+#include "collabserver/server/storage/RoomLog.h"
 #include "collabserver/server/utils/Log.h"
 
 namespace collabserver {
 
+// Max number of frames waiting in an outbox (Room workers wait if full).
+static const std::size_t local_outboxCapacity = 16384;
+
+// Max time a network thread waits before checking whether server is stopped.
+static const long local_pollTimeoutMs = 100;
+
+/**
+ * \brief
+ * ROUTER socket and the thread handling its requests (See Server).
+ */
+struct RequestPlane {
+    // Operation acknowledged once synced
+    struct PendingAck {
+        std::string client;
+        unsigned int roomID;
+        std::size_t sequence;
+    };
+
+    const char* name;
+    RouterSocket router;
+    Outbox outbox;  // Responses from room workers (and broadcasts if the plane owns the PUB socket)
+    FrameBatch batch;
+    std::string currentClient;             // Identity of the client being handled
+    bool isBatching = false;               // Responses and broadcasts are delayed until the end of the batch
+    std::vector<PendingAck> pendingAcks;   // Operations acknowledged once synced (batch only)
+
+    RequestPlane(const char* planeName, zmq::context_t& context)
+        : name(planeName), router(context), outbox(local_outboxCapacity) {}
+};
+
 static ZMQSocket* local_socketREP = nullptr;
-static ZMQSocket* local_socketPUB = nullptr;
+static zmq::context_t* local_context = nullptr;
+static PublisherSocket* local_socketPUB = nullptr;
+static PublisherPool* local_publisherPool = nullptr;  // More than one publisher only
+static Publisher* local_publisher = nullptr;          // Where broadcasts are sent (PUB socket or pool)
+static RequestPlane* local_controlPlane = nullptr;
+static RequestPlane* local_dataPlane = nullptr;
+
+// Plane handled by the calling thread (nullptr: REP mode)
+static thread_local RequestPlane* local_plane = nullptr;
 
-Server::Server() {
+Server::Server() : Server(ServerConfig()) {}
+
+Server::Server(const ServerConfig& config) {
     ZMQSocketConfig configREP = {ZMQ_REP, &(MessageFactory::getInstance())};
-    ZMQSocketConfig configPUB = {ZMQ_PUB, &(MessageFactory::getInstance())};
 
-    _collabserver = new CollabServer(*this);
     local_socketREP = new ZMQSocket(configREP);
-    local_socketPUB = new ZMQSocket(configPUB);
+    local_context = new zmq::context_t();
+    local_socketPUB = new PublisherSocket(*local_context);
+    local_publisher = local_socketPUB;
+    local_controlPlane = new RequestPlane("control", *local_context);
+    local_dataPlane = new RequestPlane("data", *local_context);
 
-    assert(_collabserver != nullptr);
     assert(local_socketREP != nullptr);
+    assert(local_context != nullptr);
     assert(local_socketPUB != nullptr);
+    assert(local_controlPlane != nullptr);
+    assert(local_dataPlane != nullptr);
+
+    _port = config.port;
+    _dataPort = config.dataPort;
+    _routerMode = config.routerMode;
+    _hasDataPlane = config.splitPlanes;
+    _batchSize = config.batchSize;
+    if (_batchSize > 0 || _hasDataPlane) {
+        _routerMode = true;  // REP can't have more than one request at a time
+    }
+    _roomConfig.window = config.broadcastWindow;
+    _roomConfig.storageDir = config.storageDir;
+    _roomConfig.durability = config.durability;
+    _roomConfig.history = config.history;
+    _roomConfig.sequenceNumbers = config.sequenceNumbers || config.sharedCatchUps;  // Shared: placed by sequence
+    _roomConfig.coalescing = config.coalescing;
+    _roomConfig.compressHistory = config.compressHistory;
+    if (config.dedupBuffers) {
+        _roomConfig.bufferPool = std::make_shared<BufferPool>();  // Shared by all rooms
+    }
+    _roomConfig.historyBytes = std::make_shared<std::atomic<std::size_t>>(0);  // Shared by all rooms
+    _roomConfig.hibernateAfterSec = config.hibernateAfterSec;
+    _roomConfig.hibernationDir = config.hibernationDir;
+    _roomConfig.catchUpBundleBytes = config.catchUpBundleBytes;
+    _roomConfig.sharedCatchUps = config.sharedCatchUps;
+    _roomConfig.echoSuppression = config.echoSuppression;
+    if (config.hibernateAfterSec > 0 && config.storageDir.empty() && config.hibernationDir.empty()) {
+        LOG << "Hibernation needs a directory for the history in memory (rooms stay loaded)\n";
+    }
+    _rooms = new RoomHandler(*this, _roomConfig);
+    _collabserver = &_rooms->getCollabServer();
+    if (_roomConfig.window.delayUs > 0) {
+        _routerMode = true;  // Window is flushed when no request is waiting
+    }
+    if (config.echoSuppression) {
+        _routerMode = true;  // Senders are acknowledged with a MsgRoomOperationAck
+    }
+
+    if (config.nbPublishers > 1) {
+        local_publisherPool = new PublisherPool(config.nbPublishers, local_outboxCapacity);
+        local_publisher = local_publisherPool;
+    }
+
+    // Plane that owns the PUB socket also forwards the broadcasts of workers
+    _broadcasts = _hasDataPlane ? &local_dataPlane->outbox : &local_controlPlane->outbox;
+
+    _roomQueueSize = config.shardQueueSize;
+    if (config.nbStealingWorkers > 0) {
+        _routerMode = true;  // Responses from workers are sent asynchronously
+        _scheduler = new TaskScheduler(config.nbStealingWorkers);
+    } else if (config.nbRoomShards > 0) {
+        _routerMode = true;
+        _shards.reserve(config.nbRoomShards);
+        for (unsigned int k = 0; k < config.nbRoomShards; ++k) {
+            _shards.push_back(new ShardWorker(k, *_broadcasts, config.shardQueueSize, _roomConfig));
+        }
+    }
+
+    if (!_roomConfig.storageDir.empty()) {
+        this->restoreRooms();
+    }
 }
 
-Server::Server(const ServerConfig& config) : Server() { _port = config.port; }
+void Server::restoreRooms() {
+    if (!this->hasRoomWorkers()) {
+        _collabserver->enableStorage(_roomConfig.storageDir, _roomConfig.durability);
+        const std::size_t count = _collabserver->restoreRooms();
+        LOG << count << " room(s) restored from " << _roomConfig.storageDir << "\n";
+        return;
+    }
+
+    // Room workers restore a room when it is joined. IDs are registered now
+    // so that the join requests are routed.
+    const std::vector<unsigned int> roomIDs = RoomLog::listRoomIDs(_roomConfig.storageDir);
+    for (const unsigned int roomID : roomIDs) {
+        _shardedRooms.insert(roomID);
+        Room::ROOM_ID_COUNTER = std::max(Room::ROOM_ID_COUNTER, roomID);
+    }
+    LOG << roomIDs.size() << " room(s) found in " << _roomConfig.storageDir << "\n";
+}
 
 Server::~Server() {
-    assert(_collabserver != nullptr);
+    assert(_rooms != nullptr);
     assert(local_socketREP != nullptr);
+    assert(local_context != nullptr);
     assert(local_socketPUB != nullptr);
+    assert(local_controlPlane != nullptr);
+    assert(local_dataPlane != nullptr);
     this->stop();
-    delete _collabserver;
+    for (ShardWorker* shard : _shards) {
+        delete shard;
+    }
+    delete _scheduler;  // Stopped first, pending tasks may use the strands
+    for (auto& it : _roomStrands) {
+        delete it.second;
+    }
+    delete _rooms;
     delete local_socketREP;
     delete local_socketPUB;
+    delete local_publisherPool;
+    delete local_controlPlane;
+    delete local_dataPlane;
+    delete local_context;
 }
 
 void Server::start() {
@@ -48,57 +196,545 @@ void Server::start() {
     _isRunning = true;
 
     LOG << "Starting network server\n";
-    LOG << "Binding REP socket: (" << _address << ", " << _port << ")\n";
-    LOG << "Binding PUB socket: (" << _address << ", " << COLLAB_SOCKET_SUB_PORT << ")\n";
-    local_socketREP->bind(_address.c_str(), _port);
-    local_socketPUB->bind(_address.c_str(), COLLAB_SOCKET_SUB_PORT);
+    if (_routerMode) {
+        LOG << "Binding ROUTER socket: (" << _address << ", " << _port << ")\n";
+        local_controlPlane->router.bind(_address.c_str(), _port);
+    } else {
+        LOG << "Binding REP socket: (" << _address << ", " << _port << ")\n";
+        local_socketREP->bind(_address.c_str(), _port);
+    }
+    if (_hasDataPlane) {
+        LOG << "Binding data ROUTER socket: (" << _address << ", " << _dataPort << ")\n";
+        local_dataPlane->router.bind(_address.c_str(), _dataPort);
+    }
+    if (local_publisherPool != nullptr) {
+        for (std::size_t k = 0; k < local_publisherPool->size(); ++k) {
+            uint16_t port = COLLAB_SOCKET_SUB_PORT;
+            if (k > 0) {
+                port = static_cast<uint16_t>(COLLAB_EXTRA_PUB_PORT + k - 1);
+            }
+            LOG << "Binding PUB socket " << k << ": (" << _address << ", " << port << ")\n";
+            local_publisherPool->bind(k, _address.c_str(), port);
+        }
+        local_publisherPool->start();
+    } else {
+        LOG << "Binding PUB socket: (" << _address << ", " << COLLAB_SOCKET_SUB_PORT << ")\n";
+        local_socketPUB->bind(_address.c_str(), COLLAB_SOCKET_SUB_PORT);
+    }
     LOG << "Sockets successfully binded\n";
 
+    for (ShardWorker* shard : _shards) {
+        shard->start();
+    }
+    if (_scheduler != nullptr) {
+        _scheduler->start();
+    }
+    if (_hasDataPlane) {
+        _dataThread = std::thread([this]() {
+            try {
+                this->runRouterLoop(*local_dataPlane);
+            } catch (const std::exception& exception) {
+                LOG << "Data plane crashed with exception: " << exception.what() << "\n";
+                this->stop();
+            }
+        });
+    }
+
+    if (_routerMode) {
+        this->runRouterLoop(*local_controlPlane);
+    } else {
+        this->runReplyLoop();
+    }
+
+    if (_dataThread.joinable()) {
+        _dataThread.join();
+    }
+    for (ShardWorker* shard : _shards) {
+        shard->stop();
+    }
+    if (_scheduler != nullptr) {
+        _scheduler->stop();
+    }
+    local_controlPlane->outbox.forward(local_controlPlane->router, *local_publisher);
+    local_dataPlane->outbox.forward(local_dataPlane->router, *local_publisher);
+    if (local_publisherPool != nullptr) {
+        local_publisherPool->stop();  // Once all broadcasts are sent
+    }
+
+    LOG << "Unbinding sockets\n";
+    if (_routerMode) {
+        local_controlPlane->router.unbind();
+    } else {
+        local_socketREP->unbind();
+    }
+    if (_hasDataPlane) {
+        local_dataPlane->router.unbind();
+    }
+}
+
+void Server::stop() {
+    LOG << "Server stop requested\n";
+    this->_isRunning = false;
+}
+
+void Server::runReplyLoop() {
     while (_isRunning) {
         LOG << "Waiting for any message...\n";
         Message* msg = local_socketREP->receiveMessage();
         assert(msg != nullptr);
         this->handleMessage(*msg);
         MessageFactory::getInstance().freeMessage(msg);
+
+        // DevNote: REP socket can't be polled here, history is sent once the
+        // response is gone (Router mode interleaves it with requests).
+        while (this->continueCatchUps()) {
+        }
+        while (this->continueCoalescing()) {
+        }
+        this->hibernateIdleRooms();
     }
+}
 
-    LOG << "Unbinding sockets\n";
-    local_socketREP->unbind();
+void Server::runRouterLoop(RequestPlane& plane) {
+    local_plane = &plane;
+
+    zmq::pollitem_t items[] = {
+        {plane.router.handle(), 0, ZMQ_POLLIN, 0},
+        {nullptr, plane.outbox.fd(), ZMQ_POLLIN, 0},
+    };
+
+    LOG << "Waiting for any message (" << plane.name << " plane)...\n";
+    while (_isRunning) {
+        // DevNote: poll wakes up now and then to check whether server is
+        // stopped (SIGINT is only received by one of the network threads).
+        const bool hasCatchUps = &plane == local_controlPlane && this->continueCatchUps();
+        const bool hasCoalescing = &plane == local_controlPlane && !hasCatchUps && this->continueCoalescing();
+        const bool hasBroadcasts = this->flushBroadcasts(plane, false);
+        if (&plane == local_controlPlane) {
+            this->hibernateIdleRooms();
+        }
+        const bool canWait = plane.outbox.prepareWait() && !hasCatchUps && !hasCoalescing && !hasBroadcasts;
+        try {
+            zmq::poll(items, 2, canWait ? local_pollTimeoutMs : 0);
+        } catch (const zmq::error_t& error) {
+            plane.outbox.finishWait(false);
+            if (error.num() == EINTR) {
+                continue;
+            }
+            throw;
+        }
+        plane.outbox.finishWait((items[1].revents & ZMQ_POLLIN) != 0);
+
+        // Responses and broadcasts from room workers
+        plane.outbox.forward(plane.router, *local_publisher);
+        if (!(items[0].revents & ZMQ_POLLIN)) {
+            if (hasBroadcasts) {
+                this->flushBroadcasts(plane, true);  // Idle: nothing to wait for
+            }
+            continue;
+        }
+
+        if (_batchSize > 0) {
+            this->handleRouterBatch(plane);
+        } else {
+            Message* msg = plane.router.receiveMessage(plane.currentClient);
+            this->handleRouterMessage(plane, msg);
+        }
+    }
 }
 
-void Server::stop() {
-    LOG << "Server stop requested\n";
-    this->_isRunning = false;
+bool Server::continueCatchUps() {
+    // DevNote: with room workers, catch-up is done by the workers.
+    // Checked before the lock: catch-ups are only added by joins, which are
+    // handled by the control plane (this thread) when planes are split.
+    if (this->hasRoomWorkers() || !_collabserver->hasPendingCatchUps()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(_roomsMutex, std::defer_lock);
+    if (_hasDataPlane) {
+        lock.lock();
+    }
+    _collabserver->continueCatchUps(COLLAB_CATCH_UP_SLICE_SIZE);
+    if (!_collabserver->hasPendingCatchUps()) {
+        const HistoryStats stats = _collabserver->getHistoryStats();
+        LOG << "Catch-ups done. History reads: " << stats.hotReads << " from memory, " << stats.encodedReads
+            << " already encoded, " << stats.coldReads << " from files (hit rate " << stats.getHitRate() * 100
+            << "%), " << stats.sharedReads << " saved by shared catch-ups, " << stats.dropped
+            << " operations dropped by coalescing\n";
+        return false;
+    }
+    return true;
+}
+
+bool Server::continueCoalescing() {
+    // DevNote: same as catch-ups, done by the room workers if any. Unlike
+    // catch-ups, checked under the lock: the data plane adds rooms to coalesce
+    // on each commit.
+    if (this->hasRoomWorkers()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(_roomsMutex, std::defer_lock);
+    if (_hasDataPlane) {
+        lock.lock();
+    }
+    if (!_collabserver->hasPendingCoalescing()) {
+        return false;
+    }
+    _collabserver->continueCoalescing(COLLAB_COALESCING_SLICE_SIZE);
+    return _collabserver->hasPendingCoalescing();
+}
+
+void Server::hibernateIdleRooms() {
+    if (_roomConfig.hibernateAfterSec == 0 || !_shards.empty()) {
+        return;  // Shard workers check their rooms on their own
+    }
+    if (_scheduler != nullptr) {
+        // DevNote: strands have no timer, each one is asked now and then.
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now < _nextStrandsHibernation) {
+            return;
+        }
+        _nextStrandsHibernation = now + std::chrono::milliseconds(COLLAB_HIBERNATION_CHECK_MS);
+        std::unique_lock<std::mutex> lock(_roomsMutex, std::defer_lock);
+        if (_hasDataPlane) {
+            lock.lock();  // Strands are created by both planes
+        }
+        std::size_t count = 0;
+        for (auto it = _roomStrands.begin(); it != _roomStrands.end();) {
+            RoomStrand* strand = it->second;
+            if (strand->canHibernate()) {
+                strand->hibernateIdleRoom();
+                ++it;
+            } else if (strand->isUnloaded()) {
+                // Only network threads post to strands: none can start meanwhile
+                _hibernatedRooms.insert(it->first);
+                delete strand;
+                it = _roomStrands.erase(it);
+                ++count;
+            } else {
+                ++it;  // Room not loaded yet, or being unloaded
+            }
+        }
+        if (count > 0) {
+            LOG << count << " room strand(s) of unloaded rooms destroyed, " << _roomStrands.size() << " left\n";
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_roomsMutex, std::defer_lock);
+    if (_hasDataPlane) {
+        lock.lock();
+    }
+    const std::size_t count = _rooms->hibernateIdleRooms();
+    if (count > 0) {
+        LOG << count << " idle room(s) unloaded, " << _collabserver->getNbRooms() << " still loaded\n";
+    }
+}
+
+bool Server::flushBroadcasts(RequestPlane& plane, const bool isIdle) {
+    // DevNote: window belongs to the plane that commits the operations.
+    RequestPlane* owner = _hasDataPlane ? local_dataPlane : local_controlPlane;
+    if (_roomConfig.window.delayUs == 0 || this->hasRoomWorkers() || &plane != owner) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(_roomsMutex, std::defer_lock);
+    if (_hasDataPlane) {
+        lock.lock();  // Joins flush the window from the control plane
+    }
+    _rooms->flushBroadcasts(isIdle);
+    return _rooms->hasPendingBroadcasts();
+}
+
+void Server::handleRouterBatch(RequestPlane& plane) {
+    // DevNote: drains what is already readable (never blocks). Responses and
+    // broadcasts are only encoded meanwhile, and sent all together at the end.
+    plane.isBatching = true;
+    std::size_t count = 0;
+    Message* msg = nullptr;
+    while (count < _batchSize && plane.router.tryReceiveMessage(plane.currentClient, msg)) {
+        this->handleRouterMessage(plane, msg);
+        ++count;
+    }
+    plane.isBatching = false;
+
+    this->syncOperations(plane);
+    plane.batch.flush(plane.router, *local_publisher);
+    LOG << "Batch of " << count << " message(s) handled (" << plane.name << " plane)\n";
+}
+
+void Server::syncOperations(RequestPlane& plane) {
+    // DevNote: one sync for all the operations of the batch (group commit).
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    std::unique_lock<std::mutex> lock(_roomsMutex, std::defer_lock);
+    if (_hasDataPlane) {
+        lock.lock();
+    }
+    if (!_collabserver->hasUnsyncedRooms() && plane.pendingAcks.empty()) {
+        return;
+    }
+    const bool isSynced = _collabserver->syncRooms();
+    if (lock.owns_lock()) {
+        lock.unlock();
+    }
+    if (plane.pendingAcks.empty()) {
+        return;
+    }
+
+    Message* response = factory.newMessage(isSynced ? MessageFactory::MSG_EMPTY : MessageFactory::MSG_ERROR);
+    for (const RequestPlane::PendingAck& ack : plane.pendingAcks) {
+        if (isSynced && _roomConfig.echoSuppression) {
+            plane.batch.addResponse(ack.client, MsgRoomOperationAck(ack.roomID, ack.sequence));
+        } else {
+            plane.batch.addResponse(ack.client, *response);
+        }
+    }
+    factory.freeMessage(response);
+    LOG << plane.pendingAcks.size() << " operation(s) acknowledged after sync (" << plane.name << " plane)\n";
+    plane.pendingAcks.clear();
+}
+
+void Server::handleRouterMessage(RequestPlane& plane, Message* msg) {
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    const bool isWrongPlane = msg != nullptr && &plane == local_dataPlane &&
+                              msg->getType() != MessageFactory::MSG_ROOM_OPERATION &&
+                              msg->getType() != MSG_ROOM_SNAPSHOT;
+    if (msg == nullptr || isWrongPlane) {
+        // REQ client waits for a response, even if its request was garbage.
+        LOG << "Invalid message received on " << plane.name << " plane (dropped)\n";
+        Message* response = factory.newMessage(MessageFactory::MSG_ERROR);
+        this->sendResponse(*response);
+        factory.freeMessage(response);
+        MessageCodec::freeMessage(msg);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_roomsMutex, std::defer_lock);
+    if (_hasDataPlane) {
+        lock.lock();
+    }
+    if (this->hasRoomWorkers() && this->dispatchToShard(plane, msg)) {
+        return;  // Now owned by the shard (or already freed)
+    }
+    this->handleMessage(*msg);
+    MessageCodec::freeMessage(msg);
+}
+
+void Server::sendResponse(const Message& msg) {
+    if (local_plane == nullptr) {
+        local_socketREP->sendMessage(msg);
+    } else if (local_plane->isBatching) {
+        local_plane->batch.addResponse(local_plane->currentClient, msg);
+    } else {
+        local_plane->router.sendMessage(local_plane->currentClient, msg);
+    }
+}
+
+void Server::publish(const std::string& topic, const Message& msg) {
+    if (this->prepareBroadcast()) {
+        local_dataPlane->outbox.sendBroadcastNoWait(topic, msg);
+    } else if (local_plane != nullptr && local_plane->isBatching) {
+        local_plane->batch.addBroadcast(topic, msg);
+    } else {
+        local_publisher->sendMessage(topic, msg);
+    }
+}
+
+void Server::publishFrame(const std::string& topic, std::string frame) {
+    if (this->prepareBroadcast()) {
+        local_dataPlane->outbox.sendBroadcastFrameNoWait(topic, std::move(frame));
+    } else if (local_plane != nullptr && local_plane->isBatching) {
+        local_plane->batch.addBroadcastFrame(topic, frame);
+    } else {
+        local_publisher->sendFrame(topic, frame.data(), frame.size());
+    }
+}
+
+bool Server::isGroupCommit() const { return local_plane != nullptr && local_plane->isBatching; }
+
+void Server::deferAck(const unsigned int roomID, const std::size_t sequence) {
+    // Acknowledged at the end of the batch (See syncOperations)
+    local_plane->pendingAcks.push_back({local_plane->currentClient, roomID, sequence});
+}
+
+bool Server::prepareBroadcast() {
+    if (!_hasDataPlane) {
+        return false;
+    }
+    if (local_plane != local_dataPlane) {
+        // DevNote: PUB socket belongs to the data plane thread. Rooms mutex is
+        // held, the outbox keeps the commit order between both planes. Never
+        // waits: data plane thread may be waiting for the mutex.
+        return true;
+    }
+    // Data plane thread publishes itself, after what was handed over before
+    // (its outbox is never pushed by the thread that forwards it).
+    local_dataPlane->outbox.forward(local_dataPlane->router, *local_publisher);
+    return false;
 }
 
 // -----------------------------------------------------------------------------
-// Message handling
+// Shards
 // -----------------------------------------------------------------------------
 
-void Server::handleMessage(const Message& msg) {
-    switch (msg.getType()) {
-        // Connection
-        case MessageFactory::MSG_CONNECTION_REQUEST:
-            this->handleMessage(static_cast<const MsgConnectionRequest&>(msg));
+bool Server::hasRoomWorkers() const { return _scheduler != nullptr || !_shards.empty(); }
+
+bool Server::postToRoomWorker(const unsigned int roomID, ShardRequest& request, const bool wait) {
+    assert(this->hasRoomWorkers());
+
+    if (_scheduler != nullptr) {
+        auto it = _roomStrands.find(roomID);
+        if (it == _roomStrands.end()) {
+            const bool isHibernated = _hibernatedRooms.erase(roomID) == 1;
+            RoomStrand* strand =
+                new RoomStrand(roomID, *_scheduler, *_broadcasts, _roomQueueSize, isHibernated, _roomConfig);
+            it = _roomStrands.emplace(roomID, strand).first;
+        }
+        if (wait) {
+            it->second->post(request);
+            return true;
+        }
+        return it->second->tryPost(request);
+    }
+
+    ShardWorker* shard = _shards[roomID % _shards.size()];
+    if (wait) {
+        shard->post(request);
+        return true;
+    }
+    return shard->tryPost(request);
+}
+
+bool Server::dispatchToShard(RequestPlane& plane, Message* msg) {
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    // DevNote: requests are validated here (network thread knows users and
+    // rooms), so that _userRooms stays in sync with what shards do. Requests
+    // within a room (operation, snapshot, history) are only accepted from the
+    // users in that room: room workers assume it.
+    // State is only updated once the shard accepted the request.
+    ShardRequest request;
+    request.client = plane.currentClient;
+    request.outbox = &plane.outbox;
+    request.msg = msg;
+
+    unsigned int userID = 0;
+    unsigned int roomID = 0;
+    bool isValid = false;
+
+    switch (msg->getType()) {
+        case MessageFactory::MSG_CREA_DATA_REQUEST:
+            userID = static_cast<MsgCreaDataRequest*>(msg)->getUserID();
+            isValid = _collabserver->hasUser(userID) && _userRooms.count(userID) == 0;
+            if (isValid) {
+                roomID = ++Room::ROOM_ID_COUNTER;
+                request.roomID = roomID;
+            }
             break;
-        case MessageFactory::MSG_DISCONNECT_REQUEST:
-            this->handleMessage(static_cast<const MsgDisconnectRequest&>(msg));
+
+        case MessageFactory::MSG_JOIN_DATA_REQUEST:
+            userID = static_cast<MsgJoinDataRequest*>(msg)->getUserID();
+            roomID = static_cast<MsgJoinDataRequest*>(msg)->getDataID();
+            isValid = _collabserver->hasUser(userID) && _userRooms.count(userID) == 0 &&
+                      _shardedRooms.count(roomID) == 1;
             break;
 
-        // Data
+        case MessageFactory::MSG_LEAVE_DATA_REQUEST:
+            userID = static_cast<MsgLeaveDataRequest*>(msg)->getUserID();
+            isValid = _userRooms.count(userID) == 1;
+            if (isValid) {
+                roomID = _userRooms[userID];
+            }
+            break;
+
+        case MessageFactory::MSG_ROOM_OPERATION:
+            userID = static_cast<MsgRoomOperation*>(msg)->getUserID();
+            roomID = static_cast<MsgRoomOperation*>(msg)->getRoomID();
+            isValid = _userRooms.count(userID) == 1 && _userRooms[userID] == roomID;
+            break;
+
+        case MSG_ROOM_RESUME_REQUEST:
+            userID = static_cast<MsgRoomResumeRequest*>(msg)->getUserID();
+            roomID = static_cast<MsgRoomResumeRequest*>(msg)->getRoomID();
+            isValid = _collabserver->hasUser(userID) && _userRooms.count(userID) == 0 &&
+                      _shardedRooms.count(roomID) == 1;
+            break;
+
+        case MSG_ROOM_HISTORY_REQUEST:
+            userID = static_cast<MsgRoomHistoryRequest*>(msg)->getUserID();
+            roomID = static_cast<MsgRoomHistoryRequest*>(msg)->getRoomID();
+            isValid = _userRooms.count(userID) == 1 && _userRooms[userID] == roomID;
+            break;
+
+        case MSG_ROOM_SNAPSHOT:
+            userID = static_cast<MsgRoomSnapshot*>(msg)->getSnapshot().userID;
+            roomID = static_cast<MsgRoomSnapshot*>(msg)->getSnapshot().roomID;
+            isValid = _userRooms.count(userID) == 1 && _userRooms[userID] == roomID;
+            break;
+
+        case MessageFactory::MSG_DISCONNECT_REQUEST: {
+            // User must leave its room first (no response for this one).
+            // Disconnect itself is done by the regular handler.
+            userID = static_cast<MsgDisconnectRequest*>(msg)->getUserID();
+            auto it = _userRooms.find(userID);
+            if (it != _userRooms.end()) {
+                ShardRequest leave;
+                leave.msg = factory.newMessage(MessageFactory::MSG_LEAVE_DATA_REQUEST);
+                static_cast<MsgLeaveDataRequest*>(leave.msg)->setUserID(userID);
+                this->postToRoomWorker(it->second, leave, true);
+                _userRooms.erase(it);
+            }
+            return false;
+        }
+
+        default:
+            return false;
+    }
+
+    if (!isValid) {
+        LOG << "(UserID=" << userID << "): Invalid request for room (RoomID=" << roomID << ")\n";
+    } else if (!this->postToRoomWorker(roomID, request, false)) {
+        LOG << "(UserID=" << userID << "): Shard is overloaded, request dropped (RoomID=" << roomID << ")\n";
+        isValid = false;
+    }
+
+    if (!isValid) {
+        Message* response = factory.newMessage(MessageFactory::MSG_ERROR);
+        this->sendResponse(*response);
+        factory.freeMessage(response);
+        MessageCodec::freeMessage(msg);
+        return true;
+    }
+
+    switch (msg->getType()) {
         case MessageFactory::MSG_CREA_DATA_REQUEST:
-            this->handleMessage(static_cast<const MsgCreaDataRequest&>(msg));
+            _shardedRooms.insert(roomID);
+            _userRooms[userID] = roomID;
             break;
         case MessageFactory::MSG_JOIN_DATA_REQUEST:
-            this->handleMessage(static_cast<const MsgJoinDataRequest&>(msg));
+        case MSG_ROOM_RESUME_REQUEST:
+            _userRooms[userID] = roomID;
             break;
         case MessageFactory::MSG_LEAVE_DATA_REQUEST:
-            this->handleMessage(static_cast<const MsgLeaveDataRequest&>(msg));
+            _userRooms.erase(userID);
             break;
+    }
+    return true;
+}
 
-        // Room
-        case MessageFactory::MSG_ROOM_OPERATION:
-            this->handleMessage(static_cast<const MsgRoomOperation&>(msg));
+// -----------------------------------------------------------------------------
+// Message handling
+// -----------------------------------------------------------------------------
+
+void Server::handleMessage(const Message& msg) {
+    switch (msg.getType()) {
+        // Connection
+        case MessageFactory::MSG_CONNECTION_REQUEST:
+            this->handleMessage(static_cast<const MsgConnectionRequest&>(msg));
+            break;
+        case MessageFactory::MSG_DISCONNECT_REQUEST:
+            this->handleMessage(static_cast<const MsgDisconnectRequest&>(msg));
             break;
 
         // Various
@@ -107,7 +743,9 @@ void Server::handleMessage(const Message& msg) {
             break;
 
         default:
-            LOG << "Unknown msg or invalid type (TypeID=" << msg.getType() << ")\n";
+            if (!_rooms->handleMessage(msg)) {
+                LOG << "Unknown msg or invalid type (TypeID=" << msg.getType() << ")\n";
+            }
             break;
     }
 }
@@ -128,11 +766,11 @@ void Server::handleMessage(const MsgConnectionRequest& msg) {
         LOG << "(UserID=" << userID << "): New user successfully created\n";
         response = factory.newMessage(MessageFactory::MSG_CONNECTION_SUCCESS);
         static_cast<MsgConnectionSuccess*>(response)->setUserID(userID);
-        local_socketREP->sendMessage(*response);
+        this->sendResponse(*response);
     } else {
         LOG << "ERROR: Unable to create a new user in CollabServer\n";
         response = factory.newMessage(MessageFactory::MSG_ERROR);
-        local_socketREP->sendMessage(*response);
+        this->sendResponse(*response);
     }
     factory.freeMessage(response);
 }
@@ -148,85 +786,15 @@ void Server::handleMessage(const MsgDisconnectRequest& msg) {
     if (success) {
         LOG << "(UserID=" << userID << "): User successfully disconnect\n";
         response = factory.newMessage(MessageFactory::MSG_DISCONNECT_SUCCESS);
-        local_socketREP->sendMessage(*response);
+        this->sendResponse(*response);
     } else {
         LOG << "(UserID=" << userID << "): Unable to disconnect user\n";
         response = factory.newMessage(MessageFactory::MSG_ERROR);
-        local_socketREP->sendMessage(*response);
+        this->sendResponse(*response);
     }
     factory.freeMessage(response);
 }
 
-// -----------------------------------------------------------------------------
-// Message handling (Data msg)
-// -----------------------------------------------------------------------------
-
-void Server::handleMessage(const MsgCreaDataRequest& msg) {
-    LOG << "Message received (MsgCreaDataRequest)\n";
-    MessageFactory& factory = MessageFactory::getInstance();
-
-    unsigned int userID = static_cast<MsgCreaDataRequest>(msg).getUserID();
-    const Room* room = _collabserver->createNewRoom();
-    unsigned int roomID = (room != nullptr) ? room->getRoomID() : -1;
-
-    Message* response = nullptr;
-    if (room != nullptr && _collabserver->userJoinRoom(userID, roomID)) {
-        LOG << "(UserID=" << userID << "): Room successfully created (RoomID=" << roomID << ")\n";
-        response = factory.newMessage(MessageFactory::MSG_CREA_DATA_SUCCESS);
-        static_cast<MsgCreaDataSuccess*>(response)->setDataID(roomID);
-        local_socketREP->sendMessage(*response);
-    } else {
-        LOG << "(UserID=" << userID << "): Unable to create new room\n";
-        response = factory.newMessage(MessageFactory::MSG_ERROR);
-        local_socketREP->sendMessage(*response);
-    }
-
-    factory.freeMessage(response);
-}
-
-void Server::handleMessage(const MsgJoinDataRequest& msg) {
-    LOG << "Message received (MsgJoinDataRequest)\n";
-    MessageFactory& factory = MessageFactory::getInstance();
-
-    unsigned int userID = static_cast<MsgJoinDataRequest>(msg).getUserID();
-    unsigned int roomID = static_cast<MsgJoinDataRequest>(msg).getDataID();
-
-    bool success = _collabserver->userJoinRoom(userID, roomID);
-    Message* response = nullptr;
-    if (success) {
-        LOG << "(UserID=" << userID << "): User successfully joined room (RoomID=" << roomID << ")\n";
-        response = factory.newMessage(MessageFactory::MSG_JOIN_DATA_SUCCESS);
-        local_socketREP->sendMessage(*response);
-    } else {
-        LOG << "(UserID=" << userID << "): Unable to join room (RoomID=" << roomID << ")\n";
-        response = factory.newMessage(MessageFactory::MSG_ERROR);
-        local_socketREP->sendMessage(*response);
-    }
-
-    factory.freeMessage(response);
-}
-
-void Server::handleMessage(const MsgLeaveDataRequest& msg) {
-    LOG << "Message received (MsgLeaveDataRequest)\n";
-    MessageFactory& factory = MessageFactory::getInstance();
-
-    unsigned int userID = static_cast<MsgLeaveDataRequest>(msg).getUserID();
-    bool success = _collabserver->userLeaveCurrentRoom(userID);
-
-    Message* response = nullptr;
-    if (success) {
-        LOG << "(UserID=" << userID << "): Successfully left his room\n";
-        response = factory.newMessage(MessageFactory::MSG_LEAVE_DATA_SUCCESS);
-        local_socketREP->sendMessage(*response);
-    } else {
-        LOG << "(UserID=" << userID << "): Unable to left his room\n";
-        response = factory.newMessage(MessageFactory::MSG_ERROR);
-        local_socketREP->sendMessage(*response);
-    }
-
-    factory.freeMessage(response);
-}
-
 // -----------------------------------------------------------------------------
 // Message handling (Various msg)
 // -----------------------------------------------------------------------------
@@ -242,82 +810,9 @@ void Server::handleMessage(const MsgUgly& msg) {
 
     Message* response = factory.newMessage(MessageFactory::MSG_UGLY);
     static_cast<MsgUgly*>(response)->setResponse(isUgly);
-    local_socketREP->sendMessage(*response);
-
-    factory.freeMessage(response);
-}
-
-// -----------------------------------------------------------------------------
-// Message handling (Room msg)
-// -----------------------------------------------------------------------------
-
-void Server::handleMessage(const MsgRoomOperation& msg) {
-    LOG << "Message received (MsgRoomOperation)\n";
-    MessageFactory& factory = MessageFactory::getInstance();
-
-    OperationInfo op;
-    op.roomID = static_cast<const MsgRoomOperation>(msg).getRoomID();
-    op.userID = static_cast<const MsgRoomOperation>(msg).getUserID();
-    op.opTypeID = static_cast<const MsgRoomOperation>(msg).getOpTypeID();
-    op.buffer = static_cast<const MsgRoomOperation>(msg).getOperationBuffer();
-
-    // It's just aliases for visibility
-    const unsigned int roomID = op.roomID;
-    const unsigned int userID = op.userID;
-
-    bool success = _collabserver->commitOperationInRoom(op, roomID);
-
-    Message* response = nullptr;
-    if (success) {
-        // DevNote: REP Pattern requires a response, here, this is a dummy response.
-        LOG << "(UserID=" << userID << "): Successfully broadcasted operation (RoomID=" << roomID << ")\n";
-        response = factory.newMessage(MessageFactory::MSG_EMPTY);
-        local_socketREP->sendMessage(*response);
-    } else {
-        LOG << "(UserID=" << userID << "): Unable to broadcast operation (RoomID=" << roomID << ")\n";
-        response = factory.newMessage(MessageFactory::MSG_ERROR);
-        local_socketREP->sendMessage(*response);
-    }
+    this->sendResponse(*response);
 
     factory.freeMessage(response);
 }
 
-// -----------------------------------------------------------------------------
-// Broadcaster methods
-// -----------------------------------------------------------------------------
-
-void Server::sendOperationToUser(const OperationInfo& op, unsigned int id) {
-    MessageFactory& factory = MessageFactory::getInstance();
-
-    LOG << "(RoomID=" << op.roomID << "): Sending operation to user (UserID=" << id << ")\n";
-
-    Message* msg = factory.newMessage(MessageFactory::MSG_ROOM_OPERATION);
-
-    static_cast<MsgRoomOperation*>(msg)->setRoomID(op.roomID);
-    static_cast<MsgRoomOperation*>(msg)->setUserID(op.userID);
-    static_cast<MsgRoomOperation*>(msg)->setOpTypeID(op.opTypeID);
-    static_cast<MsgRoomOperation*>(msg)->setOperationBuffer(op.buffer);
-
-    local_socketPUB->sendMessage(*msg);
-
-    factory.freeMessage(msg);
-}
-
-void Server::broadcastOperationToRoom(const OperationInfo& op, unsigned int id) {
-    MessageFactory& factory = MessageFactory::getInstance();
-
-    LOG << "(UserID=" << op.userID << "): Broadcasting operation in room (roomID=" << id << ")\n";
-
-    Message* msg = factory.newMessage(MessageFactory::MSG_ROOM_OPERATION);
-
-    static_cast<MsgRoomOperation*>(msg)->setRoomID(op.roomID);
-    static_cast<MsgRoomOperation*>(msg)->setUserID(op.userID);
-    static_cast<MsgRoomOperation*>(msg)->setOpTypeID(op.opTypeID);
-    static_cast<MsgRoomOperation*>(msg)->setOperationBuffer(op.buffer);
-
-    local_socketPUB->sendMessage(*msg);
-
-    factory.freeMessage(msg);
-}
-
 }  // namespace collabserver
@@ -1,35 +1,207 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>  // std::size_t
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "collabserver/network/messaging/Message.h"
 #include "collabserver/network/messaging/MessageList.h"
-#include "collabserver/server/room/Broadcaster.h"
+#include "collabserver/server/network/BroadcastWindow.h"
+#include "collabserver/server/room/CoalescingRegistry.h"
 #include "collabserver/server/room/CollabServer.h"
+#include "collabserver/server/room/HistoryBudget.h"
+#include "collabserver/server/scheduler/TaskScheduler.h"
+#include "collabserver/server/shard/RoomHandler.h"
+#include "collabserver/server/shard/RoomSink.h"
+#include "collabserver/server/shard/RoomStrand.h"
+#include "collabserver/server/shard/ShardWorker.h"
+#include "collabserver/server/storage/Durability.h"
 #include "collabserver/server/utils/constants.h"
 
 namespace collabserver {
 
 struct ServerConfig {
-    uint16_t port;
+    uint16_t port = COLLAB_DEFAULT_SERVER_PORT;    // Control plane (or all requests if planes are not split)
+    uint16_t dataPort = COLLAB_DEFAULT_DATA_PORT;  // Data plane (room operations), if planes are split
+    bool splitPlanes = false;                      // Receive room operations on dataPort, with their own thread
+    bool routerMode = false;                       // Receive requests on a ROUTER socket instead of REP
+    unsigned int nbRoomShards = 0;                 // Worker threads owning the rooms (0: rooms on network thread)
+    unsigned int shardQueueSize = 4096;            // Max pending requests per shard (per room with work stealing)
+    unsigned int nbStealingWorkers = 0;            // Work-stealing threads running per-room tasks (0: disabled)
+    unsigned int batchSize = 0;                    // Max requests drained per loop iteration (0: no batching)
+    BroadcastWindowConfig broadcastWindow;         // Micro-batching of room broadcasts (disabled by default)
+    std::string storageDir;                        // Persist room history in this directory (empty: memory only)
+    Durability durability = Durability::NONE;      // Persisted before acknowledging an operation (with storageDir)
+    HistoryBudget history;                         // Memory allowed for the room histories (without storageDir)
+    bool sequenceNumbers = false;                  // Publish operations with their sequence number
+    bool dedupBuffers = false;                     // Store identical buffers once (History in memory, all rooms)
+    bool compressHistory = false;                  // Compress older operations by blocks (History in memory)
+    unsigned int hibernateAfterSec = 0;            // Unload the rooms empty for this long (0: never)
+    std::string hibernationDir;                    // Archives of the unloaded rooms (History in memory)
+    std::size_t catchUpBundleBytes = 0;            // Operations kept encoded per room for catch-ups (0: none)
+    bool sharedCatchUps = false;                   // Users joining a room together share one catch-up
+    bool echoSuppression = false;                  // Operations not published back to their sender (acknowledged)
+    unsigned int nbPublishers = 1;                 // PUB sockets and threads sharing the broadcasts (by topic)
+    // Rules dropping superseded operations from the histories in memory (nullptr: none)
+    std::shared_ptr<const CoalescingRegistry> coalescing;
 };
 
+struct RequestPlane;
+
 /**
  * \brief
  * Server for network communication.
  *
+ * Requests are received either on a REP socket (default) or on a ROUTER
+ * socket (router mode). REP requires the server to send exactly one
+ * response before receiving the next request. ROUTER doesn't: requests from
+ * all clients are queued and each response is routed back using the client
+ * identity. Message handlers are the same in both modes.
+ *
+ * Rooms may be handled by worker threads instead of the network thread.
+ * Either way, room requests are handled by a RoomHandler (Same responses and
+ * broadcasts). Network thread keeps the users and routes room messages to
+ * the room workers. This requires the router mode. Two worker modes:
+ *  - Fixed shards: rooms partitioned across threads by room ID (ShardWorker).
+ *  - Work stealing: each room is a serialized task stream (RoomStrand) that
+ *    any idle thread may run. Better for skewed room load.
+ *
+ * In batch mode (router only), each loop iteration drains all readable
+ * requests (up to batchSize) without blocking, handles them, then sends all
+ * responses and broadcasts together.
+ *
+ * Room broadcasts may be delayed a little (broadcastWindow, router only) so
+ * that operations committed in a row in the same room are published as one
+ * frame (See BroadcastWindow). Pending operations are published as soon as
+ * no request is waiting.
+ *
+ * Room history is sent to joining users by slices, between requests, by the
+ * thread that owns the room (control plane thread or room worker). A long
+ * history doesn't delay the other requests. A user that rejoins after a
+ * disconnection (MsgRoomResumeRequest, router only) only receives the
+ * operations after the last sequence number it has. With sequenceNumbers,
+ * operations are published as MsgRoomOperationBatch (even alone) so that
+ * users know the sequence number of each one. A user in a room may also
+ * fetch its history by pages (MsgRoomHistoryRequest, router only), encoded
+ * from where the room keeps it.
+ *
+ * Requests may be split in two planes (router only), each with its own port
+ * and thread. Control plane (port) handles sessions and room lifecycle. Data
+ * plane (dataPort) handles room operations and snapshots only. A flood of operations then
+ * never delays a connection or a join. Both threads share the rooms (locked)
+ * or the room workers. The data plane thread owns the PUB socket, broadcasts
+ * from the control plane are handed over through its outbox.
+ *
+ * Room history may be persisted (storageDir, one RoomLog per room). Rooms
+ * found in storageDir are restored at startup, by the room workers on their
+ * first join request. With GROUP_SYNC durability, an operation is
+ * acknowledged once on disk. Operations handled in the same batch (or by the
+ * same room worker in a row) share one flush (group commit). Broadcasts to
+ * the other users are not held until then (See Durability).
+ *
+ * Otherwise, room history is kept in memory. With a history budget, the
+ * oldest operations of the rooms over budget are spilled to temporary files
+ * (budget per room, and for all rooms, shared by the room workers). The part
+ * of the catch-up history read from memory is logged (hit rate). With
+ * coalescing rules, operations superseded by a later one are dropped from
+ * the history in memory when the room owner has nothing else to do (See
+ * CoalescingRegistry). Live broadcasts are not concerned. With dedupBuffers,
+ * identical operation buffers are stored once for all rooms (See
+ * BufferPool), the dedup ratio of a room is logged when a user joins it.
+ * With compressHistory, older operations are compressed by blocks of
+ * OperationLog::CHUNK_SIZE and decompressed when read (catch-up).
+ *
+ * With hibernateAfterSec, rooms empty for that long are unloaded by their
+ * owner: history in memory is saved in hibernationDir (See RoomArchive),
+ * persisted rooms are only dropped from memory. The next join request loads
+ * the room again, sequence numbers are kept. In work stealing mode, the
+ * RoomStrand of an unloaded room is destroyed too.
+ *
+ * With catchUpBundleBytes, the room owner keeps the latest operations of each
+ * room encoded since their commit (See CatchUpBundle). Catch-up then sends
+ * each slice of history as one MsgRoomOperationBatch made of these bytes,
+ * without encoding anything again. Older operations are sent one by one.
+ *
+ * With sharedCatchUps, users joining a room while others are catching up
+ * share their stream (catch-up topic, See Topic::catchUp): the history is
+ * read and published once for all of them. Implies sequenceNumbers, users
+ * place the operations received by several topics by sequence number.
+ *
+ * With echoSuppression, a committed operation is published to the other
+ * users of its room only, on their user topic (not delayed by
+ * broadcastWindow). Its sender already applied it: the response to its
+ * request is a MsgRoomOperationAck with the sequence number of the operation
+ * instead. Worth it for small rooms (e.g., pairing), a large room is better
+ * served by one publish on its room topic. Implies router mode.
+ *
+ * With more than one publisher (nbPublishers), broadcasts are spread across
+ * as many PUB sockets, each sending from its own thread (See PublisherPool).
+ * A topic is published by publisher ID % nbPublishers: the first one on port
+ * COLLAB_SOCKET_SUB_PORT, the next ones from COLLAB_EXTRA_PUB_PORT. Messages
+ * are still encoded by the thread that publishes them (network thread or
+ * room worker), publisher threads only send.
+ *
  * \par Default settings
  *  - port: 4242
+ *  - dataPort: 4244
+ *  - splitPlanes: false
+ *  - routerMode: false
+ *  - nbRoomShards: 0
+ *  - shardQueueSize: 4096
+ *  - nbStealingWorkers: 0 (Takes precedence over nbRoomShards)
+ *  - batchSize: 0
+ *  - storageDir: empty (history in memory only)
+ *  - durability: NONE
+ *  - history: no spillDir (whole history in memory)
+ *  - sequenceNumbers: false
+ *  - coalescing: nullptr (all operations kept)
+ *  - dedupBuffers: false
+ *  - compressHistory: false
+ *  - hibernateAfterSec: 0 (rooms stay loaded)
+ *  - hibernationDir: empty
+ *  - catchUpBundleBytes: 0 (catch-up sends the operations one by one)
+ *  - sharedCatchUps: false
+ *  - echoSuppression: false
+ *  - nbPublishers: 1 (network thread owns the PUB socket)
  */
-class Server : public Broadcaster {
+class Server : public RoomSink {
    private:
-    bool _isRunning = false;
+    std::atomic<bool> _isRunning{false};
     std::string _address = "*";
     uint16_t _port = COLLAB_DEFAULT_SERVER_PORT;
+    uint16_t _dataPort = COLLAB_DEFAULT_DATA_PORT;
+    bool _routerMode = false;
+    bool _hasDataPlane = false;
+    std::size_t _batchSize = 0;
 
    private:
-    CollabServer* _collabserver = nullptr;
+    std::thread _dataThread;
+    std::mutex _roomsMutex;               // Split planes: one thread at a time uses the rooms (or routes to workers)
+    Outbox* _broadcasts = nullptr;        // Outbox of the plane that owns the PUB socket
+    RoomShardConfig _roomConfig;          // Room workers have their own window and storage
+
+   private:
+    RoomHandler* _rooms = nullptr;          // Rooms on the network thread (Window delays their broadcasts)
+    CollabServer* _collabserver = nullptr;  // Users (and rooms) of _rooms
+
+   private:
+    // Room workers (Accessed by network threads only)
+    std::vector<ShardWorker*> _shards;
+    TaskScheduler* _scheduler = nullptr;
+    std::unordered_map<unsigned int, RoomStrand*> _roomStrands;
+    std::size_t _roomQueueSize = 0;                             // Max pending requests per RoomStrand
+    std::unordered_set<unsigned int> _hibernatedRooms;          // Rooms of the destroyed RoomStrands
+    std::unordered_set<unsigned int> _shardedRooms;             // All rooms created in workers
+    std::unordered_map<unsigned int, unsigned int> _userRooms;  // UserID -> RoomID
+    std::chrono::steady_clock::time_point _nextStrandsHibernation;
 
    public:
     Server();
@@ -40,19 +212,32 @@ class Server : public Broadcaster {
     void start();
     void stop();
 
+   private:
+    void runReplyLoop();
+    void runRouterLoop(RequestPlane& plane);
+    void handleRouterBatch(RequestPlane& plane);
+    void handleRouterMessage(RequestPlane& plane, Message* msg);
+    void sendResponse(const Message& msg) override;
+    bool prepareBroadcast();
+    void publish(const std::string& topic, const Message& msg) override;
+    void publishFrame(const std::string& topic, std::string frame) override;
+    bool isGroupCommit() const override;
+    void deferAck(const unsigned int roomID, const std::size_t sequence) override;
+    bool continueCatchUps();
+    bool continueCoalescing();
+    void hibernateIdleRooms();
+    bool flushBroadcasts(RequestPlane& plane, const bool isIdle);
+    void syncOperations(RequestPlane& plane);
+    bool hasRoomWorkers() const;
+    void restoreRooms();
+    bool dispatchToShard(RequestPlane& plane, Message* msg);
+    bool postToRoomWorker(const unsigned int roomID, ShardRequest& request, const bool wait);
+
    private:
     void handleMessage(const Message& msg);
     void handleMessage(const MsgConnectionRequest& msg);
     void handleMessage(const MsgDisconnectRequest& msg);
-    void handleMessage(const MsgCreaDataRequest& msg);
-    void handleMessage(const MsgJoinDataRequest& msg);
-    void handleMessage(const MsgLeaveDataRequest& msg);
-    void handleMessage(const MsgRoomOperation& msg);
     void handleMessage(const MsgUgly& msg);
-
-   private:
-    void sendOperationToUser(const OperationInfo& op, unsigned int id) override;
-    void broadcastOperationToRoom(const OperationInfo& op, unsigned int id) override;
 };
 
 }  // namespace collabserver
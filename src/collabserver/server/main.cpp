@@ -1,7 +1,11 @@
 #include <csignal>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
 
 #include "collabserver/server/Server.h"
 #include "collabserver/server/utils/Log.h"
@@ -13,10 +17,171 @@ static void handleInterrupt(int i) {
     server_ptr->stop();
 }
 
+static void local_printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [OPTIONS]\n"
+              << "  --router                   --batch N              --split-planes\n"
+              << "  --data-port PORT           --broadcast-window US  --broadcast-bytes N\n"
+              << "  --storage DIR              --durability LEVEL     --sequence-numbers\n"
+              << "  --spill-dir DIR            --room-history-bytes N --room-history-ops N\n"
+              << "  --history-bytes N          --coalesce TYPE[:N]    --dedup-buffers\n"
+              << "  --compress-history         --hibernate-after SECONDS\n"
+              << "  --hibernate-dir DIR        --catch-up-bundle N    --shared-catch-ups\n"
+              << "  --echo-suppression         --shards N             --shard-queue N\n"
+              << "  --publishers N             --work-stealing N\n"
+              << "(See README for the details of each option)\n";
+}
+
+static int local_usageError(const char* program, const std::string& arg, const std::string& value) {
+    LOG << "Invalid value for " << arg << ": '" << value << "'\n";
+    local_printUsage(program);
+    return EXIT_FAILURE;
+}
+
+/*
+ * Parse a decimal number. Unlike std::stoul, never throws, rejects the signs
+ * (std::stoul wraps "-1" around), the trailing characters and the values out
+ * of [min, max of T] (instead of truncating them).
+ */
+template <typename T>
+static bool local_parseNumber(const std::string& text, T& value, const T min = 0) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned long long number = 0;
+    for (const char digit : text) {
+        const unsigned int d = static_cast<unsigned int>(digit - '0');
+        if (number > (std::numeric_limits<unsigned long long>::max() - d) / 10) {
+            return false;
+        }
+        number = number * 10 + d;
+    }
+    if (number < static_cast<unsigned long long>(min) ||
+        number > static_cast<unsigned long long>(std::numeric_limits<T>::max())) {
+        return false;
+    }
+    value = static_cast<T>(number);
+    return true;
+}
+
 int main(int argc, char** argv) {
     signal(SIGINT, &handleInterrupt);
 
-    collabserver::Server server;
+    collabserver::ServerConfig config;
+    std::shared_ptr<collabserver::CoalescingRegistry> coalescing;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--router") {
+            config.routerMode = true;
+        } else if (arg == "--split-planes") {
+            config.splitPlanes = true;
+        } else if (arg == "--data-port" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.dataPort, uint16_t(1))) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--shards" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.nbRoomShards)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--work-stealing" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.nbStealingWorkers)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--batch" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.batchSize)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--broadcast-window" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.broadcastWindow.delayUs)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--broadcast-bytes" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.broadcastWindow.maxBytes)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--storage" && i + 1 < argc) {
+            config.storageDir = argv[++i];
+        } else if (arg == "--durability" && i + 1 < argc) {
+            const std::string level = argv[++i];
+            if (level == "none") {
+                config.durability = collabserver::Durability::NONE;
+            } else if (level == "async") {
+                config.durability = collabserver::Durability::ASYNC;
+            } else if (level == "group-sync") {
+                config.durability = collabserver::Durability::GROUP_SYNC;
+            } else {
+                LOG << "Unknown durability: " << level << " (none, async or group-sync)\n";
+                local_printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--compress-history") {
+            config.compressHistory = true;
+        } else if (arg == "--hibernate-after" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.hibernateAfterSec)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--hibernate-dir" && i + 1 < argc) {
+            config.hibernationDir = argv[++i];
+        } else if (arg == "--catch-up-bundle" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.catchUpBundleBytes)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--shared-catch-ups") {
+            config.sharedCatchUps = true;
+        } else if (arg == "--echo-suppression") {
+            config.echoSuppression = true;
+        } else if (arg == "--dedup-buffers") {
+            config.dedupBuffers = true;
+        } else if (arg == "--sequence-numbers") {
+            config.sequenceNumbers = true;
+        } else if (arg == "--spill-dir" && i + 1 < argc) {
+            config.history.spillDir = argv[++i];
+        } else if (arg == "--room-history-bytes" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.history.roomMaxBytes)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--room-history-ops" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.history.roomMaxOps)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--history-bytes" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.history.serverMaxBytes)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--coalesce" && i + 1 < argc) {
+            // TYPE (latest operation of the type kept) or TYPE:N (per first N bytes of the buffer)
+            const std::string rule = argv[++i];
+            const std::size_t separator = rule.find(':');
+            if (!coalescing) {
+                coalescing = std::make_shared<collabserver::CoalescingRegistry>();
+                config.coalescing = coalescing;
+            }
+            unsigned int opTypeID = 0;
+            std::size_t prefixSize = 0;
+            if (!local_parseNumber(rule.substr(0, separator), opTypeID) ||
+                (separator != std::string::npos && !local_parseNumber(rule.substr(separator + 1), prefixSize))) {
+                return local_usageError(argv[0], arg, rule);
+            }
+            if (separator == std::string::npos) {
+                coalescing->registerRule(opTypeID, collabserver::CoalescingRegistry::byType());
+            } else {
+                coalescing->registerRule(opTypeID, collabserver::CoalescingRegistry::byPrefix(prefixSize));
+            }
+        } else if (arg == "--publishers" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.nbPublishers)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else if (arg == "--shard-queue" && i + 1 < argc) {
+            if (!local_parseNumber(argv[++i], config.shardQueueSize)) {
+                return local_usageError(argv[0], arg, argv[i]);
+            }
+        } else {
+            LOG << "Unknown argument (or missing value): " << arg << "\n";
+            local_printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    collabserver::Server server(config);
     server_ptr = &server;
 
     LOG << "Starts CollabServer\n";
@@ -0,0 +1,69 @@
+#include "collabserver/server/network/BroadcastWindow.h"
+
+#include <utility>  // std::move
+
+namespace collabserver {
+
+// Bytes counted for each operation in addition to its buffer (IDs, framing).
+static const std::size_t local_opOverhead = 16;
+
+BroadcastWindow::BroadcastWindow(const BroadcastWindowConfig& config, Sink sink)
+    : _delay(config.delayUs), _maxBytes(config.maxBytes), _sink(std::move(sink)) {}
+
+void BroadcastWindow::add(const OperationInfo& op) {
+    PendingRoom& room = _rooms[op.roomID];
+    if (room.operations.empty()) {
+        room.openedAt = Clock::now();
+        _openedRooms.push_back({op.roomID, room.openedAt});
+        ++_nbPendingRooms;
+    }
+    room.operations.push_back(op);
+    room.nbBytes += op.buffer.size() + local_opOverhead;
+
+    if (_maxBytes > 0 && room.nbBytes >= _maxBytes) {
+        this->flush(op.roomID, room);
+    }
+}
+
+void BroadcastWindow::flushRoom(const unsigned int roomID) {
+    auto it = _rooms.find(roomID);
+    if (it != _rooms.end()) {
+        this->flush(roomID, it->second);
+    }
+}
+
+void BroadcastWindow::flushExpired() {
+    const Clock::time_point now = Clock::now();
+    while (!_openedRooms.empty()) {
+        const OpenedRoom opened = _openedRooms.front();
+        auto it = _rooms.find(opened.roomID);
+        const bool isStale = it == _rooms.end() || it->second.operations.empty() ||
+                             it->second.openedAt != opened.openedAt;
+        if (!isStale) {
+            if (now - opened.openedAt < _delay) {
+                break;  // Next ones were opened later
+            }
+            this->flush(opened.roomID, it->second);
+        }
+        _openedRooms.pop_front();
+    }
+}
+
+void BroadcastWindow::flushAll() {
+    for (const OpenedRoom& opened : _openedRooms) {
+        this->flushRoom(opened.roomID);
+    }
+    _openedRooms.clear();
+}
+
+void BroadcastWindow::flush(const unsigned int roomID, PendingRoom& room) {
+    if (room.operations.empty()) {
+        return;
+    }
+    _sink(roomID, room.operations);
+    room.operations.clear();
+    room.nbBytes = 0;
+    --_nbPendingRooms;
+}
+
+}  // namespace collabserver
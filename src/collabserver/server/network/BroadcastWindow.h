@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>  // std::size_t
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "collabserver/server/room/OperationInfo.h"
+
+namespace collabserver {
+
+struct BroadcastWindowConfig {
+    unsigned int delayUs = 0;      // Max time an operation may wait before being published (0: disabled)
+    std::size_t maxBytes = 16384;  // Publish once pending operations of a room reach this size (0: no limit)
+};
+
+/**
+ * \brief
+ * Micro-batching of the operations broadcasted in the rooms.
+ *
+ * Operations committed in a room are kept for a short time and published
+ * together (one frame for several operations). A room is flushed once its
+ * oldest pending operation is older than delayUs, or once its pending
+ * operations reach maxBytes. Owner must also flush everything as soon as it
+ * has no more requests to handle (idle): latency is only added while busy.
+ *
+ * Not thread safe (Owned by the thread that commits operations).
+ */
+class BroadcastWindow {
+   public:
+    /**
+     * Called with the pending operations of a room (in commit order).
+     * Operations may be moved by the callee.
+     */
+    typedef std::function<void(const unsigned int roomID, std::vector<OperationInfo>& operations)> Sink;
+
+   private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct PendingRoom {
+        std::vector<OperationInfo> operations;
+        std::size_t nbBytes = 0;
+        Clock::time_point openedAt;  // Commit time of the oldest pending operation
+    };
+
+    struct OpenedRoom {
+        unsigned int roomID;
+        Clock::time_point openedAt;  // Entry is stale if room was flushed since
+    };
+
+    const std::chrono::microseconds _delay;
+    const std::size_t _maxBytes;
+    Sink _sink;
+    std::unordered_map<unsigned int, PendingRoom> _rooms;
+    std::deque<OpenedRoom> _openedRooms;  // Opening order (so, deadline order)
+    std::size_t _nbPendingRooms = 0;
+
+   public:
+    /**
+     * Create an empty window.
+     *
+     * \param config Window limits.
+     * \param sink Where to publish flushed operations.
+     */
+    BroadcastWindow(const BroadcastWindowConfig& config, Sink sink);
+
+    BroadcastWindow(const BroadcastWindow& other) = delete;
+    BroadcastWindow& operator=(const BroadcastWindow& other) = delete;
+
+   public:
+    /**
+     * Add a committed operation. Flush its room if maxBytes is reached.
+     *
+     * \param op Operation to broadcast (op.roomID is used).
+     */
+    void add(const OperationInfo& op);
+
+    /**
+     * Flush the pending operations of a room (if any).
+     *
+     * \param roomID ID of the room.
+     */
+    void flushRoom(const unsigned int roomID);
+
+    /**
+     * Flush the rooms whose oldest pending operation is older than delayUs.
+     */
+    void flushExpired();
+
+    /**
+     * Flush all pending operations (e.g., owner is idle).
+     */
+    void flushAll();
+
+    /**
+     * Check whether there is no pending operation.
+     *
+     * \return True if nothing to flush, otherwise, return false.
+     */
+    bool isEmpty() const { return _nbPendingRooms == 0; }
+
+    /**
+     * Check whether operations are delayed at all (delayUs not 0).
+     *
+     * \return True if enabled, otherwise, return false.
+     */
+    bool isEnabled() const { return _delay.count() > 0; }
+
+   private:
+    void flush(const unsigned int roomID, PendingRoom& room);
+};
+
+}  // namespace collabserver
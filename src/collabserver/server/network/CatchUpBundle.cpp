@@ -0,0 +1,92 @@
+#include "collabserver/server/network/CatchUpBundle.h"
+
+#include <algorithm>  // std::max, std::min
+#include <cassert>
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+const std::size_t CatchUpBundle::BLOCK_SIZE;
+
+CatchUpBundle::CatchUpBundle(const unsigned int roomID, const std::size_t maxBytes)
+    : _roomID(roomID), _maxBytes(maxBytes) {}
+
+void CatchUpBundle::append(const OperationInfo& op) {
+    assert(op.sequence > 0);
+    const std::size_t index = op.sequence - 1;
+    if (index != _size) {
+        _blocks.clear();
+        _bytes = 0;
+        _first = index;
+        _size = index;
+    }
+
+    // DevNote: blocks are aligned on BLOCK_SIZE (except the first one), so
+    // that the block of an index is found without a search.
+    if (_blocks.empty() || index % BLOCK_SIZE == 0) {
+        _blocks.emplace_back();
+        _blocks.back().first = index;
+    }
+    _encoder.str(std::string());
+    MsgPack::packUint(_encoder, op.userID);
+    MsgPack::packUint(_encoder, op.opTypeID);
+    MsgPack::packStr(_encoder, op.buffer);
+    const std::string encoded = _encoder.str();
+
+    Block& block = _blocks.back();
+    block.offsets.push_back(static_cast<uint32_t>(block.data.size()));
+    block.data.append(encoded);
+    _bytes += encoded.size();
+    ++_size;
+
+    while (_bytes > _maxBytes && _blocks.size() > 1) {
+        _bytes -= _blocks.front().data.size();
+        _blocks.pop_front();
+        _first = _blocks.front().first;
+    }
+}
+
+void CatchUpBundle::discard(const std::size_t position) {
+    if (position >= _size) {
+        _blocks.clear();
+        _bytes = 0;
+        _first = _size;
+        return;
+    }
+    while (_blocks.size() > 1 && _blocks[1].first <= position) {
+        _bytes -= _blocks.front().data.size();
+        _blocks.pop_front();
+    }
+    _first = std::max(_first, position);
+}
+
+bool CatchUpBundle::encode(const std::size_t first, const std::size_t last, std::string& out) const {
+    if (!this->covers(first, last)) {
+        return false;
+    }
+
+    // Same fields as MsgRoomOperationBatch::serialize
+    std::stringstream header;
+    header.put(static_cast<char>(MSG_ROOM_OPERATION_BATCH));
+    MsgPack::packUint(header, _roomID);
+    MsgPack::packUint(header, first + 1);
+    MsgPack::packUint(header, last - first);
+    out = header.str();
+
+    const std::size_t firstBlock = _blocks.front().first / BLOCK_SIZE;
+    std::size_t index = first;
+    while (index < last) {
+        const Block& block = _blocks[index / BLOCK_SIZE - firstBlock];
+        const std::size_t end = std::min(last, block.first + block.offsets.size());
+        const std::size_t begin = block.offsets[index - block.first];
+        const std::size_t stop = (end - block.first < block.offsets.size()) ? block.offsets[end - block.first]
+                                                                             : block.data.size();
+        out.append(block.data, begin, stop - begin);
+        index = end;
+    }
+    return true;
+}
+
+}  // namespace collabserver
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <deque>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "collabserver/server/room/OperationInfo.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Latest operations of a room, already encoded for the users catching up.
+ *
+ * Operations are encoded once, when committed (See append), as in the body of
+ * a MsgRoomOperationBatch. Sending a slice of history is then one frame made
+ * of a small header and a copy of the encoded bytes (See encode), whatever
+ * the number of users joining.
+ *
+ * Encoded operations are kept by blocks of BLOCK_SIZE. When over its max
+ * bytes, the oldest blocks are released: older operations are not covered
+ * anymore (sent one by one by the room instead).
+ */
+class CatchUpBundle {
+   public:
+    static const std::size_t BLOCK_SIZE = 256;
+
+   private:
+    struct Block {
+        std::size_t first;              // Index of its first operation
+        std::string data;               // Encoded operations, one after the other
+        std::vector<uint32_t> offsets;  // Offset of each operation in data
+    };
+
+    unsigned int _roomID;
+    std::size_t _maxBytes;
+    std::size_t _first = 0;  // Index of the first covered operation
+    std::size_t _size = 0;   // Index after the last covered operation
+    std::size_t _bytes = 0;  // Size of the encoded operations kept
+    std::deque<Block> _blocks;
+    std::stringstream _encoder;  // Reused for each append
+
+   public:
+    /**
+     * Create an empty bundle.
+     *
+     * \param roomID ID of the room.
+     * \param maxBytes Max size of the encoded operations (The block being
+     *                 filled is always kept).
+     */
+    CatchUpBundle(const unsigned int roomID, const std::size_t maxBytes);
+
+    CatchUpBundle(const CatchUpBundle& other) = delete;
+    CatchUpBundle& operator=(const CatchUpBundle& other) = delete;
+
+   public:
+    /**
+     * Encode a committed operation. If it doesn't follow the last one (e.g.,
+     * room loaded again), previous operations are released first.
+     *
+     * \param op Operation to add (Sequence number set).
+     */
+    void append(const OperationInfo& op);
+
+    /**
+     * Release the operations before the given position (e.g., replaced by a
+     * snapshot). Only whole blocks are freed.
+     *
+     * \param position Operations before this index are not covered anymore.
+     */
+    void discard(const std::size_t position);
+
+    /**
+     * Build the MsgRoomOperationBatch frame with the given operations (See
+     * MessageCodec for the frame layout).
+     *
+     * \param first Index of the first operation.
+     * \param last Index after the last operation.
+     * \param out Buffer where to place the frame (Previous content discarded).
+     * \return True if built, false if not covered (Nothing built).
+     */
+    bool encode(const std::size_t first, const std::size_t last, std::string& out) const;
+
+    /**
+     * Check whether all the given operations are encoded.
+     *
+     * \param first Index of the first operation.
+     * \param last Index after the last operation.
+     * \return True if covered, otherwise, return false.
+     */
+    bool covers(const std::size_t first, const std::size_t last) const {
+        return first < last && first >= _first && last <= _size;
+    }
+
+    /**
+     * Index of the first covered operation.
+     *
+     * \return Index.
+     */
+    std::size_t getFirstIndex() const { return _first; }
+
+    /**
+     * Index after the last covered operation.
+     *
+     * \return Index.
+     */
+    std::size_t size() const { return _size; }
+
+    /**
+     * Size of the encoded operations kept.
+     *
+     * \return Number of bytes.
+     */
+    std::size_t getBytes() const { return _bytes; }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,50 @@
+#include "collabserver/server/network/FrameBatch.h"
+
+#include "collabserver/server/network/MessageCodec.h"
+
+namespace collabserver {
+
+bool FrameBatch::addResponse(const std::string& client, const Message& msg) {
+    return this->add(client, std::string(), msg);
+}
+
+bool FrameBatch::addBroadcast(const std::string& topic, const Message& msg) {
+    return this->add(std::string(), topic, msg);
+}
+
+void FrameBatch::addBroadcastFrame(const std::string& topic, const std::string& frame) {
+    this->addFrame(std::string(), topic, frame);
+}
+
+bool FrameBatch::add(const std::string& client, const std::string& topic, const Message& msg) {
+    if (!MessageCodec::encode(msg, _frame)) {
+        return false;
+    }
+    this->addFrame(client, topic, _frame);
+    return true;
+}
+
+void FrameBatch::addFrame(const std::string& client, const std::string& topic, const std::string& frame) {
+    Entry entry;
+    entry.client = client;
+    entry.topic = topic;
+    entry.offset = _data.size();
+    entry.size = frame.size();
+    _data.append(frame);
+    _entries.push_back(entry);
+}
+
+void FrameBatch::flush(RouterSocket& router, Publisher& publisher) {
+    for (const Entry& entry : _entries) {
+        const char* frame = _data.data() + entry.offset;
+        if (entry.client.empty()) {
+            publisher.sendFrame(entry.topic, frame, entry.size);
+        } else {
+            router.sendFrame(entry.client, frame, entry.size);
+        }
+    }
+    _entries.clear();
+    _data.clear();
+}
+
+}  // namespace collabserver
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+#include <vector>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/server/network/Publisher.h"
+#include "collabserver/server/network/RouterSocket.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Responses and broadcasts encoded now but sent later, all together.
+ *
+ * All encoded frames are placed one after the other in the same buffer, which
+ * is reused between batches (no allocation once warmed up).
+ * Order is kept on flush.
+ */
+class FrameBatch {
+   private:
+    struct Entry {
+        std::string client;  // Empty for broadcasts
+        std::string topic;   // Broadcasts only
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    std::string _data;
+    std::string _frame;  // Reused buffer for encoding
+    std::vector<Entry> _entries;
+
+   public:
+    /**
+     * Add a response for the given client.
+     *
+     * \param client Identity of the recipient client (Not empty).
+     * \param msg Response to send.
+     * \return True if successfully encoded, otherwise, return false.
+     */
+    bool addResponse(const std::string& client, const Message& msg);
+
+    /**
+     * Add a message to publish to the subscribers of the topic.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param msg Message to publish.
+     * \return True if successfully encoded, otherwise, return false.
+     */
+    bool addBroadcast(const std::string& topic, const Message& msg);
+
+    /**
+     * Add a frame already encoded (See MessageCodec) to publish to the
+     * subscribers of the topic.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param frame Encoded frame to publish.
+     */
+    void addBroadcastFrame(const std::string& topic, const std::string& frame);
+
+    /**
+     * Send all frames (in added order) and clear the batch.
+     *
+     * \param router Socket where to send responses.
+     * \param publisher Where to publish broadcasts.
+     */
+    void flush(RouterSocket& router, Publisher& publisher);
+
+    /**
+     * Check whether batch has no frame.
+     *
+     * \return True if empty, otherwise, return false.
+     */
+    bool isEmpty() const { return _entries.empty(); }
+
+   private:
+    bool add(const std::string& client, const std::string& topic, const Message& msg);
+    void addFrame(const std::string& client, const std::string& topic, const std::string& frame);
+};
+
+}  // namespace collabserver
@@ -0,0 +1,91 @@
+#include "collabserver/server/network/MessageCodec.h"
+
+#include <sstream>
+
+#include "collabserver/network/messaging/MessageFactory.h"
+#include "collabserver/server/network/MsgRoomCatchUpDone.h"
+#include "collabserver/server/network/MsgRoomHistoryPage.h"
+#include "collabserver/server/network/MsgRoomHistoryRequest.h"
+#include "collabserver/server/network/MsgRoomOperationAck.h"
+#include "collabserver/server/network/MsgRoomOperationBatch.h"
+#include "collabserver/server/network/MsgRoomResumeRequest.h"
+#include "collabserver/server/network/MsgRoomSnapshot.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+// Type IDs are small enough to fit in a msgpack positive fixint (one byte).
+static const int local_maxFixInt = 0x7f;
+
+bool MessageCodec::encode(const Message& msg, std::string& out) {
+    const int type = msg.getType();
+    if (type < 0 || type > local_maxFixInt) {
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer.put(static_cast<char>(type));
+    if (!msg.serialize(buffer)) {
+        return false;
+    }
+    out = buffer.str();
+    return true;
+}
+
+Message* MessageCodec::decode(const void* data, std::size_t size) {
+    if (data == nullptr || size == 0) {
+        return nullptr;
+    }
+
+    const char* bytes = static_cast<const char*>(data);
+    const int type = static_cast<unsigned char>(bytes[0]);
+    if (type > local_maxFixInt) {
+        return nullptr;
+    }
+
+    Message* msg = MessageCodec::newMessage(type);
+    if (msg == nullptr) {
+        return nullptr;
+    }
+
+    std::stringstream buffer(std::string(bytes + 1, size - 1));
+    if (!msg->unserialize(buffer)) {
+        MessageCodec::freeMessage(msg);
+        return nullptr;
+    }
+    return msg;
+}
+
+Message* MessageCodec::newMessage(const int type) {
+    switch (type) {
+        case MSG_ROOM_OPERATION_BATCH:
+            return new MsgRoomOperationBatch();
+        case MSG_ROOM_SNAPSHOT:
+            return new MsgRoomSnapshot();
+        case MSG_ROOM_RESUME_REQUEST:
+            return new MsgRoomResumeRequest();
+        case MSG_ROOM_HISTORY_REQUEST:
+            return new MsgRoomHistoryRequest();
+        case MSG_ROOM_HISTORY_PAGE:
+            return new MsgRoomHistoryPage();
+        case MSG_ROOM_OPERATION_ACK:
+            return new MsgRoomOperationAck();
+        case MSG_ROOM_CATCH_UP_DONE:
+            return new MsgRoomCatchUpDone();
+        default:
+            return MessageFactory::getInstance().newMessage(type);
+    }
+}
+
+void MessageCodec::freeMessage(Message* msg) {
+    if (msg == nullptr) {
+        return;
+    }
+    if (msg->getType() >= MSG_ROOM_OPERATION_BATCH) {
+        delete msg;  // Not created by MessageFactory
+    } else {
+        MessageFactory::getInstance().freeMessage(msg);
+    }
+}
+
+}  // namespace collabserver
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+
+#include "collabserver/network/messaging/Message.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Encode / decode messages for the sockets owned by the server.
+ *
+ * ZMQSocket does the encoding internally and only exposes whole messages.
+ * Sockets that need to deal with raw frames (ROUTER envelopes, topics etc.)
+ * use this codec instead. Frame layout is the same as ZMQSocket:
+ * the message type (msgpack positive fixint) followed by the message body.
+ *
+ * Messages defined by the server (See ServerMessageType) are known by this
+ * codec only. A decoded message must be freed with MessageCodec::freeMessage.
+ */
+class MessageCodec {
+   public:
+    /**
+     * Encode a message into the given buffer.
+     * Previous content of the buffer is discarded (capacity is kept).
+     *
+     * \param msg Message to encode.
+     * \param out Buffer where to place the encoded frame.
+     * \return True if successfully encoded, otherwise, return false.
+     */
+    static bool encode(const Message& msg, std::string& out);
+
+    /**
+     * Decode a frame into a new message.
+     * The returned message must be freed with MessageFactory::freeMessage.
+     *
+     * \param data Pointer to the encoded frame.
+     * \param size Size of the frame in bytes.
+     * \return Pointer to the created message or nullptr if invalid frame.
+     */
+    static Message* decode(const void* data, std::size_t size);
+
+    /**
+     * Create a new message of the given type (MessageFactory type or
+     * ServerMessageType).
+     * The returned message must be freed with MessageCodec::freeMessage.
+     *
+     * \param type Type of message.
+     * \return Pointer to the created message or nullptr if unknown type.
+     */
+    static Message* newMessage(const int type);
+
+    /**
+     * Free a message created by newMessage or decode (Do nothing if nullptr).
+     *
+     * \param msg Message to free.
+     */
+    static void freeMessage(Message* msg);
+};
+
+}  // namespace collabserver
@@ -0,0 +1,118 @@
+#include "collabserver/server/network/MsgPack.h"
+
+namespace collabserver {
+
+// Strings read from the network can't be bigger (Garbage size is not allocated).
+static const uint64_t local_maxStrSize = 64 * 1024 * 1024;
+
+void MsgPack::packUint(std::ostream& out, const uint64_t value) {
+    if (value <= 0x7f) {
+        out.put(static_cast<char>(value));  // positive fixint
+    } else if (value <= 0xff) {
+        out.put(static_cast<char>(0xcc));
+        MsgPack::writeBigEndian(out, value, 1);
+    } else if (value <= 0xffff) {
+        out.put(static_cast<char>(0xcd));
+        MsgPack::writeBigEndian(out, value, 2);
+    } else if (value <= 0xffffffff) {
+        out.put(static_cast<char>(0xce));
+        MsgPack::writeBigEndian(out, value, 4);
+    } else {
+        out.put(static_cast<char>(0xcf));
+        MsgPack::writeBigEndian(out, value, 8);
+    }
+}
+
+void MsgPack::packStr(std::ostream& out, const std::string& value) {
+    MsgPack::packStr(out, value.data(), value.size());
+}
+
+void MsgPack::packStr(std::ostream& out, const char* data, const std::size_t size) {
+    if (size <= 31) {
+        out.put(static_cast<char>(0xa0 | size));  // fixstr
+    } else if (size <= 0xff) {
+        out.put(static_cast<char>(0xd9));
+        MsgPack::writeBigEndian(out, size, 1);
+    } else if (size <= 0xffff) {
+        out.put(static_cast<char>(0xda));
+        MsgPack::writeBigEndian(out, size, 2);
+    } else {
+        out.put(static_cast<char>(0xdb));
+        MsgPack::writeBigEndian(out, size, 4);
+    }
+    out.write(data, size);
+}
+
+bool MsgPack::unpackUint(std::istream& in, uint64_t& value) {
+    const int marker = in.get();
+    if (marker == std::istream::traits_type::eof()) {
+        return false;
+    }
+    if (marker <= 0x7f) {
+        value = static_cast<uint64_t>(marker);
+        return true;
+    }
+    switch (marker) {
+        case 0xcc:
+            return MsgPack::readBigEndian(in, value, 1);
+        case 0xcd:
+            return MsgPack::readBigEndian(in, value, 2);
+        case 0xce:
+            return MsgPack::readBigEndian(in, value, 4);
+        case 0xcf:
+            return MsgPack::readBigEndian(in, value, 8);
+        default:
+            return false;
+    }
+}
+
+bool MsgPack::unpackStr(std::istream& in, std::string& value) {
+    const int marker = in.get();
+    if (marker == std::istream::traits_type::eof()) {
+        return false;
+    }
+
+    uint64_t size = 0;
+    bool isValid = true;
+    if ((marker & 0xe0) == 0xa0) {
+        size = static_cast<uint64_t>(marker & 0x1f);  // fixstr
+    } else if (marker == 0xd9 || marker == 0xc4) {
+        isValid = MsgPack::readBigEndian(in, size, 1);
+    } else if (marker == 0xda || marker == 0xc5) {
+        isValid = MsgPack::readBigEndian(in, size, 2);
+    } else if (marker == 0xdb || marker == 0xc6) {
+        isValid = MsgPack::readBigEndian(in, size, 4);
+    } else {
+        return false;
+    }
+    if (!isValid || size > local_maxStrSize) {
+        return false;
+    }
+
+    value.resize(static_cast<std::size_t>(size));
+    if (size == 0) {
+        return true;
+    }
+    in.read(&value[0], static_cast<std::streamsize>(size));
+    return static_cast<uint64_t>(in.gcount()) == size;
+}
+
+void MsgPack::writeBigEndian(std::ostream& out, const uint64_t value, const int nbBytes) {
+    for (int k = nbBytes - 1; k >= 0; --k) {
+        out.put(static_cast<char>((value >> (8 * k)) & 0xff));
+    }
+}
+
+bool MsgPack::readBigEndian(std::istream& in, uint64_t& value, const int nbBytes) {
+    value = 0;
+    for (int k = 0; k < nbBytes; ++k) {
+        const int byte = in.get();
+        if (byte == std::istream::traits_type::eof()) {
+            return false;
+        }
+        value = (value << 8) | static_cast<uint64_t>(byte);
+    }
+    return true;
+}
+
+}  // namespace collabserver
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Minimal msgpack writer / reader for the messages defined by this server.
+ *
+ * Only unsigned integers and strings are supported. Output is the same as
+ * msgpack-c (used by collabserver-network messages), so clients may decode
+ * these messages with any msgpack implementation.
+ */
+class MsgPack {
+   public:
+    /**
+     * Write an unsigned integer (Smallest msgpack format).
+     *
+     * \param out Stream where to write.
+     * \param value Value to write.
+     */
+    static void packUint(std::ostream& out, const uint64_t value);
+
+    /**
+     * Write a string (msgpack str format, content is not checked).
+     *
+     * \param out Stream where to write.
+     * \param value Value to write.
+     */
+    static void packStr(std::ostream& out, const std::string& value);
+
+    /**
+     * Write a string from raw bytes (e.g., a record in a file mapping).
+     *
+     * \param out Stream where to write.
+     * \param data Bytes to write.
+     * \param size Number of bytes.
+     */
+    static void packStr(std::ostream& out, const char* data, const std::size_t size);
+
+    /**
+     * Read an unsigned integer.
+     *
+     * \param in Stream where to read.
+     * \param value Set with the read value.
+     * \return True if successfully read, otherwise, return false.
+     */
+    static bool unpackUint(std::istream& in, uint64_t& value);
+
+    /**
+     * Read a string (msgpack str or bin format).
+     *
+     * \param in Stream where to read.
+     * \param value Set with the read value.
+     * \return True if successfully read, otherwise, return false.
+     */
+    static bool unpackStr(std::istream& in, std::string& value);
+
+   private:
+    static void writeBigEndian(std::ostream& out, const uint64_t value, const int nbBytes);
+    static bool readBigEndian(std::istream& in, uint64_t& value, const int nbBytes);
+};
+
+}  // namespace collabserver
@@ -0,0 +1,37 @@
+#include "collabserver/server/network/MsgRoomCatchUpDone.h"
+
+#include <cstdint>
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+MsgRoomCatchUpDone::MsgRoomCatchUpDone(const unsigned int roomID, const unsigned int userID,
+                                       const std::size_t sequence)
+    : _roomID(roomID), _userID(userID), _sequence(sequence) {}
+
+bool MsgRoomCatchUpDone::serialize(std::stringstream& buffer) const {
+    MsgPack::packUint(buffer, _roomID);
+    MsgPack::packUint(buffer, _userID);
+    MsgPack::packUint(buffer, _sequence);
+    return true;
+}
+
+bool MsgRoomCatchUpDone::unserialize(std::stringstream& buffer) {
+    uint64_t roomID = 0;
+    uint64_t userID = 0;
+    uint64_t sequence = 0;
+    if (!MsgPack::unpackUint(buffer, roomID) || !MsgPack::unpackUint(buffer, userID) ||
+        !MsgPack::unpackUint(buffer, sequence)) {
+        return false;
+    }
+    _roomID = static_cast<unsigned int>(roomID);
+    _userID = static_cast<unsigned int>(userID);
+    _sequence = static_cast<std::size_t>(sequence);
+    return true;
+}
+
+int MsgRoomCatchUpDone::getType() const { return MSG_ROOM_CATCH_UP_DONE; }
+
+}  // namespace collabserver
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <sstream>
+
+#include "collabserver/network/messaging/Message.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * End of the catch-up of a user joining a room.
+ *
+ * Published after the last operation of the history sent to the user, on
+ * the same topic (user topic, or catch-up topic if shared). The user then has
+ * all the operations up to the given sequence number. Operations after it
+ * come live, on the room topic: a joining user buffers the live operations
+ * received until then, and applies them after its history.
+ *
+ * \par Fields
+ *  - roomID (uint)
+ *  - userID (uint, recipient: catch-up topic is shared by several users)
+ *  - sequence (uint, sequence number of the last operation of the history)
+ */
+class MsgRoomCatchUpDone : public Message {
+   private:
+    unsigned int _roomID = 0;
+    unsigned int _userID = 0;
+    std::size_t _sequence = 0;
+
+   public:
+    MsgRoomCatchUpDone() = default;
+
+    /**
+     * Create an end of catch-up.
+     *
+     * \param roomID ID of the room.
+     * \param userID ID of the user who caught up.
+     * \param sequence Sequence number of the last operation of the history.
+     */
+    MsgRoomCatchUpDone(const unsigned int roomID, const unsigned int userID, const std::size_t sequence);
+
+   public:
+    bool serialize(std::stringstream& buffer) const override;
+    bool unserialize(std::stringstream& buffer) override;
+    int getType() const override;
+
+   public:
+    unsigned int getRoomID() const { return _roomID; }
+    unsigned int getUserID() const { return _userID; }
+    std::size_t getSequence() const { return _sequence; }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,72 @@
+#include "collabserver/server/network/MsgRoomHistoryPage.h"
+
+#include <cstdint>
+#include <string>
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+MsgRoomHistoryPage::MsgRoomHistoryPage(const unsigned int roomID, const std::size_t firstSequence,
+                                       const std::size_t lastSequence)
+    : _roomID(roomID), _firstSequence(firstSequence), _lastSequence(lastSequence) {}
+
+void MsgRoomHistoryPage::addOperation(const std::size_t sequence, const LogRecord& record) {
+    MsgPack::packUint(_encoded, sequence);
+    MsgPack::packUint(_encoded, record.userID);
+    MsgPack::packUint(_encoded, record.opTypeID);
+    MsgPack::packStr(_encoded, record.buffer, record.bufferSize);
+    ++_nbOperations;
+}
+
+bool MsgRoomHistoryPage::serialize(std::stringstream& buffer) const {
+    MsgPack::packUint(buffer, _roomID);
+    MsgPack::packUint(buffer, _firstSequence);
+    MsgPack::packUint(buffer, _lastSequence);
+    MsgPack::packUint(buffer, _nextSequence);
+    MsgPack::packUint(buffer, _nbOperations);
+    const std::string encoded = _encoded.str();
+    buffer.write(encoded.data(), encoded.size());
+    return true;
+}
+
+bool MsgRoomHistoryPage::unserialize(std::stringstream& buffer) {
+    uint64_t roomID = 0;
+    uint64_t firstSequence = 0;
+    uint64_t lastSequence = 0;
+    uint64_t nextSequence = 0;
+    uint64_t count = 0;
+    if (!MsgPack::unpackUint(buffer, roomID) || !MsgPack::unpackUint(buffer, firstSequence) ||
+        !MsgPack::unpackUint(buffer, lastSequence) || !MsgPack::unpackUint(buffer, nextSequence) ||
+        !MsgPack::unpackUint(buffer, count)) {
+        return false;
+    }
+
+    _roomID = static_cast<unsigned int>(roomID);
+    _firstSequence = static_cast<std::size_t>(firstSequence);
+    _lastSequence = static_cast<std::size_t>(lastSequence);
+    _nextSequence = static_cast<std::size_t>(nextSequence);
+    _operations.clear();
+    for (uint64_t k = 0; k < count; ++k) {
+        uint64_t sequence = 0;
+        uint64_t userID = 0;
+        uint64_t opTypeID = 0;
+        OperationInfo op;
+        if (!MsgPack::unpackUint(buffer, sequence) || !MsgPack::unpackUint(buffer, userID) ||
+            !MsgPack::unpackUint(buffer, opTypeID) || !MsgPack::unpackStr(buffer, op.buffer)) {
+            return false;
+        }
+        op.roomID = _roomID;
+        op.userID = static_cast<unsigned int>(userID);
+        op.opTypeID = static_cast<unsigned int>(opTypeID);
+        op.sequence = static_cast<std::size_t>(sequence);
+        _operations.push_back(op);
+    }
+    _nbOperations = _operations.size();
+    return true;
+}
+
+int MsgRoomHistoryPage::getType() const { return MSG_ROOM_HISTORY_PAGE; }
+
+}  // namespace collabserver
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <sstream>
+#include <vector>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/server/room/OperationInfo.h"
+#include "collabserver/server/storage/LogRecord.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Page of the history of a room, response to MsgRoomHistoryRequest.
+ *
+ * Operations are in commit order. Dropped ones (See Room::coalesce) are not
+ * in the page, sequence numbers may therefore skip some values. Operations
+ * before firstSequence were replaced by a snapshot.
+ *
+ * Server side, operations are encoded as added (See addOperation), from
+ * where the history keeps them. They are only decoded by unserialize (See
+ * getOperations).
+ *
+ * \par Fields
+ *  - roomID (uint)
+ *  - firstSequence (uint, first sequence number kept by the room)
+ *  - lastSequence (uint, last sequence number of the room, 0: none)
+ *  - nextSequence (uint, first sequence number after this page)
+ *  - number of operations (uint)
+ *  - for each operation: sequence (uint), userID (uint), opTypeID (uint), buffer (str)
+ */
+class MsgRoomHistoryPage : public Message {
+   private:
+    unsigned int _roomID = 0;
+    std::size_t _firstSequence = 0;
+    std::size_t _lastSequence = 0;
+    std::size_t _nextSequence = 0;
+    std::size_t _nbOperations = 0;
+    std::stringstream _encoded;              // Operations added (Server side)
+    std::vector<OperationInfo> _operations;  // Operations decoded (Client side)
+
+   public:
+    MsgRoomHistoryPage() = default;
+
+    /**
+     * Create an empty page.
+     *
+     * \param roomID ID of the room.
+     * \param firstSequence First sequence number kept by the room.
+     * \param lastSequence Last sequence number of the room.
+     */
+    MsgRoomHistoryPage(const unsigned int roomID, const std::size_t firstSequence, const std::size_t lastSequence);
+
+   public:
+    bool serialize(std::stringstream& buffer) const override;
+    bool unserialize(std::stringstream& buffer) override;
+    int getType() const override;
+
+   public:
+    /**
+     * Encode an operation at the end of the page.
+     *
+     * \param sequence Sequence number of the operation.
+     * \param record The operation (Buffer is only read during the call).
+     */
+    void addOperation(const std::size_t sequence, const LogRecord& record);
+
+    void setNextSequence(const std::size_t sequence) { _nextSequence = sequence; }
+
+   public:
+    unsigned int getRoomID() const { return _roomID; }
+    std::size_t getFirstSequence() const { return _firstSequence; }
+    std::size_t getLastSequence() const { return _lastSequence; }
+    std::size_t getNextSequence() const { return _nextSequence; }
+    std::size_t getNbOperations() const { return _nbOperations; }
+    const std::vector<OperationInfo>& getOperations() const { return _operations; }
+};
+
+}  // namespace collabserver
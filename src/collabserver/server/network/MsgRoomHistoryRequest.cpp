@@ -0,0 +1,45 @@
+#include "collabserver/server/network/MsgRoomHistoryRequest.h"
+
+#include <cstdint>
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+MsgRoomHistoryRequest::MsgRoomHistoryRequest(const unsigned int userID, const unsigned int roomID,
+                                             const std::size_t fromSequence, const std::size_t toSequence,
+                                             const std::size_t maxBytes)
+    : _userID(userID), _roomID(roomID), _fromSequence(fromSequence), _toSequence(toSequence), _maxBytes(maxBytes) {}
+
+bool MsgRoomHistoryRequest::serialize(std::stringstream& buffer) const {
+    MsgPack::packUint(buffer, _userID);
+    MsgPack::packUint(buffer, _roomID);
+    MsgPack::packUint(buffer, _fromSequence);
+    MsgPack::packUint(buffer, _toSequence);
+    MsgPack::packUint(buffer, _maxBytes);
+    return true;
+}
+
+bool MsgRoomHistoryRequest::unserialize(std::stringstream& buffer) {
+    uint64_t userID = 0;
+    uint64_t roomID = 0;
+    uint64_t fromSequence = 0;
+    uint64_t toSequence = 0;
+    uint64_t maxBytes = 0;
+    if (!MsgPack::unpackUint(buffer, userID) || !MsgPack::unpackUint(buffer, roomID) ||
+        !MsgPack::unpackUint(buffer, fromSequence) || !MsgPack::unpackUint(buffer, toSequence) ||
+        !MsgPack::unpackUint(buffer, maxBytes)) {
+        return false;
+    }
+    _userID = static_cast<unsigned int>(userID);
+    _roomID = static_cast<unsigned int>(roomID);
+    _fromSequence = static_cast<std::size_t>(fromSequence);
+    _toSequence = static_cast<std::size_t>(toSequence);
+    _maxBytes = static_cast<std::size_t>(maxBytes);
+    return true;
+}
+
+int MsgRoomHistoryRequest::getType() const { return MSG_ROOM_HISTORY_REQUEST; }
+
+}  // namespace collabserver
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <sstream>
+
+#include "collabserver/network/messaging/Message.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Fetch a page of the history of a room (e.g., older operations, loaded
+ * while the user scrolls back).
+ *
+ * The user must be in the room. Response is MsgRoomHistoryPage, with the
+ * operations kept from the given sequence number, until the page is full
+ * (See maxBytes). Next page starts at its next sequence number. Response is
+ * MSG_ERROR if user is not in the room.
+ *
+ * \par Fields
+ *  - userID (uint)
+ *  - roomID (uint)
+ *  - fromSequence (uint, first sequence number to fetch, 0: first kept)
+ *  - toSequence (uint, last sequence number to fetch, 0: latest)
+ *  - maxBytes (uint, max size of the operation buffers, 0: server max)
+ */
+class MsgRoomHistoryRequest : public Message {
+   private:
+    unsigned int _userID = 0;
+    unsigned int _roomID = 0;
+    std::size_t _fromSequence = 0;
+    std::size_t _toSequence = 0;
+    std::size_t _maxBytes = 0;
+
+   public:
+    MsgRoomHistoryRequest() = default;
+
+    /**
+     * Create a history request.
+     *
+     * \param userID ID of the user.
+     * \param roomID ID of the room.
+     * \param fromSequence First sequence number to fetch (0: first kept).
+     * \param toSequence Last sequence number to fetch (0: latest).
+     * \param maxBytes Max size of the operation buffers (0: server max).
+     */
+    MsgRoomHistoryRequest(const unsigned int userID, const unsigned int roomID, const std::size_t fromSequence,
+                          const std::size_t toSequence, const std::size_t maxBytes);
+
+   public:
+    bool serialize(std::stringstream& buffer) const override;
+    bool unserialize(std::stringstream& buffer) override;
+    int getType() const override;
+
+   public:
+    unsigned int getUserID() const { return _userID; }
+    unsigned int getRoomID() const { return _roomID; }
+    std::size_t getFromSequence() const { return _fromSequence; }
+    std::size_t getToSequence() const { return _toSequence; }
+    std::size_t getMaxBytes() const { return _maxBytes; }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,32 @@
+#include "collabserver/server/network/MsgRoomOperationAck.h"
+
+#include <cstdint>
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+MsgRoomOperationAck::MsgRoomOperationAck(const unsigned int roomID, const std::size_t sequence)
+    : _roomID(roomID), _sequence(sequence) {}
+
+bool MsgRoomOperationAck::serialize(std::stringstream& buffer) const {
+    MsgPack::packUint(buffer, _roomID);
+    MsgPack::packUint(buffer, _sequence);
+    return true;
+}
+
+bool MsgRoomOperationAck::unserialize(std::stringstream& buffer) {
+    uint64_t roomID = 0;
+    uint64_t sequence = 0;
+    if (!MsgPack::unpackUint(buffer, roomID) || !MsgPack::unpackUint(buffer, sequence)) {
+        return false;
+    }
+    _roomID = static_cast<unsigned int>(roomID);
+    _sequence = static_cast<std::size_t>(sequence);
+    return true;
+}
+
+int MsgRoomOperationAck::getType() const { return MSG_ROOM_OPERATION_ACK; }
+
+}  // namespace collabserver
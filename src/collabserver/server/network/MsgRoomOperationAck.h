@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <sstream>
+
+#include "collabserver/network/messaging/Message.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Acknowledgement of a room operation, sent to its sender instead of the
+ * operation itself (echo suppression).
+ *
+ * Response to MsgRoomOperation when the server doesn't publish operations
+ * back to their sender. Sender already applied the operation, it only
+ * learns its place in the history.
+ *
+ * \par Fields
+ *  - roomID (uint)
+ *  - sequence (uint, sequence number of the committed operation)
+ */
+class MsgRoomOperationAck : public Message {
+   private:
+    unsigned int _roomID = 0;
+    std::size_t _sequence = 0;
+
+   public:
+    MsgRoomOperationAck() = default;
+
+    /**
+     * Create an acknowledgement.
+     *
+     * \param roomID ID of the room.
+     * \param sequence Sequence number of the committed operation.
+     */
+    MsgRoomOperationAck(const unsigned int roomID, const std::size_t sequence);
+
+   public:
+    bool serialize(std::stringstream& buffer) const override;
+    bool unserialize(std::stringstream& buffer) override;
+    int getType() const override;
+
+   public:
+    unsigned int getRoomID() const { return _roomID; }
+    std::size_t getSequence() const { return _sequence; }
+};
+
+}  // namespace collabserver
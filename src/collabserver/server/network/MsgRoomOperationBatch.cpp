@@ -0,0 +1,56 @@
+#include "collabserver/server/network/MsgRoomOperationBatch.h"
+
+#include <cstdint>
+#include <utility>  // std::move
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+MsgRoomOperationBatch::MsgRoomOperationBatch(const unsigned int roomID, std::vector<OperationInfo> operations)
+    : _roomID(roomID), _operations(std::move(operations)) {}
+
+bool MsgRoomOperationBatch::serialize(std::stringstream& buffer) const {
+    MsgPack::packUint(buffer, _roomID);
+    MsgPack::packUint(buffer, _operations.empty() ? 0 : _operations.front().sequence);
+    MsgPack::packUint(buffer, _operations.size());
+    for (const OperationInfo& op : _operations) {
+        MsgPack::packUint(buffer, op.userID);
+        MsgPack::packUint(buffer, op.opTypeID);
+        MsgPack::packStr(buffer, op.buffer);
+    }
+    return true;
+}
+
+bool MsgRoomOperationBatch::unserialize(std::stringstream& buffer) {
+    uint64_t roomID = 0;
+    uint64_t sequence = 0;
+    uint64_t count = 0;
+    if (!MsgPack::unpackUint(buffer, roomID) || !MsgPack::unpackUint(buffer, sequence) ||
+        !MsgPack::unpackUint(buffer, count)) {
+        return false;
+    }
+
+    _roomID = static_cast<unsigned int>(roomID);
+    _operations.clear();
+    for (uint64_t k = 0; k < count; ++k) {
+        uint64_t userID = 0;
+        uint64_t opTypeID = 0;
+        OperationInfo op;
+        if (!MsgPack::unpackUint(buffer, userID) || !MsgPack::unpackUint(buffer, opTypeID) ||
+            !MsgPack::unpackStr(buffer, op.buffer)) {
+            return false;
+        }
+        op.roomID = _roomID;
+        op.userID = static_cast<unsigned int>(userID);
+        op.opTypeID = static_cast<unsigned int>(opTypeID);
+        op.sequence = (sequence > 0) ? static_cast<std::size_t>(sequence + k) : 0;
+        _operations.push_back(op);
+    }
+    return true;
+}
+
+int MsgRoomOperationBatch::getType() const { return MSG_ROOM_OPERATION_BATCH; }
+
+}  // namespace collabserver
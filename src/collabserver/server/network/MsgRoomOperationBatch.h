@@ -0,0 +1,49 @@
+#pragma once
+
+#include <sstream>
+#include <vector>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/server/room/OperationInfo.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Several operations committed in the same room, published as one frame.
+ *
+ * Operations are in commit order, their sequence numbers follow each other.
+ *
+ * \par Fields
+ *  - roomID (uint)
+ *  - sequence number of the first operation (uint, 0 if not known)
+ *  - number of operations (uint)
+ *  - for each operation: userID (uint), opTypeID (uint), buffer (str)
+ */
+class MsgRoomOperationBatch : public Message {
+   private:
+    unsigned int _roomID = 0;
+    std::vector<OperationInfo> _operations;
+
+   public:
+    MsgRoomOperationBatch() = default;
+
+    /**
+     * Create a batch with the given operations.
+     *
+     * \param roomID ID of the room.
+     * \param operations Operations of the room (in commit order).
+     */
+    MsgRoomOperationBatch(const unsigned int roomID, std::vector<OperationInfo> operations);
+
+   public:
+    bool serialize(std::stringstream& buffer) const override;
+    bool unserialize(std::stringstream& buffer) override;
+    int getType() const override;
+
+   public:
+    unsigned int getRoomID() const { return _roomID; }
+    const std::vector<OperationInfo>& getOperations() const { return _operations; }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,37 @@
+#include "collabserver/server/network/MsgRoomResumeRequest.h"
+
+#include <cstdint>
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+MsgRoomResumeRequest::MsgRoomResumeRequest(const unsigned int userID, const unsigned int roomID,
+                                           const std::size_t sequence)
+    : _userID(userID), _roomID(roomID), _sequence(sequence) {}
+
+bool MsgRoomResumeRequest::serialize(std::stringstream& buffer) const {
+    MsgPack::packUint(buffer, _userID);
+    MsgPack::packUint(buffer, _roomID);
+    MsgPack::packUint(buffer, _sequence);
+    return true;
+}
+
+bool MsgRoomResumeRequest::unserialize(std::stringstream& buffer) {
+    uint64_t userID = 0;
+    uint64_t roomID = 0;
+    uint64_t sequence = 0;
+    if (!MsgPack::unpackUint(buffer, userID) || !MsgPack::unpackUint(buffer, roomID) ||
+        !MsgPack::unpackUint(buffer, sequence)) {
+        return false;
+    }
+    _userID = static_cast<unsigned int>(userID);
+    _roomID = static_cast<unsigned int>(roomID);
+    _sequence = static_cast<std::size_t>(sequence);
+    return true;
+}
+
+int MsgRoomResumeRequest::getType() const { return MSG_ROOM_RESUME_REQUEST; }
+
+}  // namespace collabserver
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <sstream>
+
+#include "collabserver/network/messaging/Message.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Join a room again, after a disconnection, without receiving the whole
+ * history again.
+ *
+ * The user only receives the operations after the given sequence number
+ * (Snapshot first if the next ones were discarded). Response is
+ * MSG_JOIN_DATA_SUCCESS or MSG_ERROR (e.g., sequence after the last
+ * operation of the room).
+ *
+ * \par Fields
+ *  - userID (uint)
+ *  - roomID (uint)
+ *  - sequence (uint, last sequence number received by the user, 0: none)
+ */
+class MsgRoomResumeRequest : public Message {
+   private:
+    unsigned int _userID = 0;
+    unsigned int _roomID = 0;
+    std::size_t _sequence = 0;
+
+   public:
+    MsgRoomResumeRequest() = default;
+
+    /**
+     * Create a resume request.
+     *
+     * \param userID ID of the user.
+     * \param roomID ID of the room to join.
+     * \param sequence Last sequence number received by the user.
+     */
+    MsgRoomResumeRequest(const unsigned int userID, const unsigned int roomID, const std::size_t sequence);
+
+   public:
+    bool serialize(std::stringstream& buffer) const override;
+    bool unserialize(std::stringstream& buffer) override;
+    int getType() const override;
+
+   public:
+    unsigned int getUserID() const { return _userID; }
+    unsigned int getRoomID() const { return _roomID; }
+    std::size_t getSequence() const { return _sequence; }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,36 @@
+#include "collabserver/server/network/MsgRoomSnapshot.h"
+
+#include <cstdint>
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+MsgRoomSnapshot::MsgRoomSnapshot(const SnapshotInfo& snapshot) : _snapshot(snapshot) {}
+
+bool MsgRoomSnapshot::serialize(std::stringstream& buffer) const {
+    MsgPack::packUint(buffer, _snapshot.roomID);
+    MsgPack::packUint(buffer, _snapshot.userID);
+    MsgPack::packUint(buffer, _snapshot.position);
+    MsgPack::packStr(buffer, _snapshot.buffer);
+    return true;
+}
+
+bool MsgRoomSnapshot::unserialize(std::stringstream& buffer) {
+    uint64_t roomID = 0;
+    uint64_t userID = 0;
+    uint64_t position = 0;
+    if (!MsgPack::unpackUint(buffer, roomID) || !MsgPack::unpackUint(buffer, userID) ||
+        !MsgPack::unpackUint(buffer, position) || !MsgPack::unpackStr(buffer, _snapshot.buffer)) {
+        return false;
+    }
+    _snapshot.roomID = static_cast<unsigned int>(roomID);
+    _snapshot.userID = static_cast<unsigned int>(userID);
+    _snapshot.position = static_cast<std::size_t>(position);
+    return true;
+}
+
+int MsgRoomSnapshot::getType() const { return MSG_ROOM_SNAPSHOT; }
+
+}  // namespace collabserver
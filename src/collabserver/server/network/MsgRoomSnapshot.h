@@ -0,0 +1,47 @@
+#pragma once
+
+#include <sstream>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/server/room/SnapshotInfo.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Snapshot of a room data (See SnapshotInfo).
+ *
+ * Sent by a user to install a snapshot in its room (Response is MSG_EMPTY or
+ * MSG_ERROR). Sent by the server to a joining user, before the operations
+ * that follow the snapshot.
+ *
+ * \par Fields
+ *  - roomID (uint)
+ *  - userID (uint)
+ *  - position (uint, number of operations included in the snapshot)
+ *  - buffer (str, serialized data)
+ */
+class MsgRoomSnapshot : public Message {
+   private:
+    SnapshotInfo _snapshot;
+
+   public:
+    MsgRoomSnapshot() = default;
+
+    /**
+     * Create a message for the given snapshot.
+     *
+     * \param snapshot Snapshot to send.
+     */
+    MsgRoomSnapshot(const SnapshotInfo& snapshot);
+
+   public:
+    bool serialize(std::stringstream& buffer) const override;
+    bool unserialize(std::stringstream& buffer) override;
+    int getType() const override;
+
+   public:
+    const SnapshotInfo& getSnapshot() const { return _snapshot; }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,103 @@
+#include "collabserver/server/network/Outbox.h"
+
+#include <utility>  // std::move
+
+#include "collabserver/server/network/MessageCodec.h"
+
+namespace collabserver {
+
+// Max number of frames taken from the mailbox at once.
+static const std::size_t local_forwardBatchSize = 64;
+
+Outbox::Outbox(const std::size_t capacity) : _frames(capacity), _pending(local_forwardBatchSize) {}
+
+void Outbox::sendResponse(const std::string& client, const Message& msg) {
+    this->push(client, std::string(), msg);
+}
+
+void Outbox::sendBroadcast(const std::string& topic, const Message& msg) { this->push(std::string(), topic, msg); }
+
+void Outbox::sendBroadcastFrame(const std::string& topic, std::string data) {
+    Frame frame;
+    frame.topic = topic;
+    frame.data = std::move(data);
+    _frames.push(std::move(frame));
+}
+
+void Outbox::sendBroadcastNoWait(const std::string& topic, const Message& msg) {
+    Frame frame;
+    if (!MessageCodec::encode(msg, frame.data)) {
+        return;
+    }
+    frame.topic = topic;
+    this->pushNoWait(frame);
+}
+
+void Outbox::sendBroadcastFrameNoWait(const std::string& topic, std::string data) {
+    Frame frame;
+    frame.topic = topic;
+    frame.data = std::move(data);
+    this->pushNoWait(frame);
+}
+
+void Outbox::pushNoWait(Frame& frame) {
+    // DevNote: once a frame overflowed, the next ones follow it until the
+    // network thread takes them (order kept). Mailbox full means the network
+    // thread has frames to forward, it checks the overflow list right after.
+    std::lock_guard<std::mutex> lock(_overflowMutex);
+    if (_overflow.empty() && _frames.tryPush(frame)) {
+        return;
+    }
+    _overflow.push_back(std::move(frame));
+    _hasOverflow.store(true);
+}
+
+void Outbox::push(const std::string& client, const std::string& topic, const Message& msg) {
+    Frame frame;
+    if (!MessageCodec::encode(msg, frame.data)) {
+        return;
+    }
+    frame.client = client;
+    frame.topic = topic;
+    _frames.push(std::move(frame));
+}
+
+void Outbox::forward(RouterSocket& router, Publisher& publisher) {
+    std::size_t count = 0;
+    while ((count = _frames.tryPopBatch(_pending.data(), _pending.size())) > 0) {
+        for (std::size_t k = 0; k < count; ++k) {
+            const Frame& frame = _pending[k];
+            if (frame.client.empty()) {
+                publisher.sendFrame(frame.topic, frame.data.data(), frame.data.size());
+            } else {
+                router.sendFrame(frame.client, frame.data.data(), frame.data.size());
+            }
+        }
+    }
+
+    if (!_hasOverflow.load()) {
+        return;
+    }
+    std::vector<Frame> overflow;
+    {
+        std::lock_guard<std::mutex> lock(_overflowMutex);
+        overflow.swap(_overflow);
+        _hasOverflow.store(false);
+    }
+    for (const Frame& frame : overflow) {
+        publisher.sendFrame(frame.topic, frame.data.data(), frame.data.size());
+    }
+}
+
+bool Outbox::prepareWait() {
+    if (!_frames.prepareWait()) {
+        return false;
+    }
+    if (_hasOverflow.load()) {
+        _frames.finishWait(false);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace collabserver
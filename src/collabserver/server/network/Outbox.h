@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/server/network/Publisher.h"
+#include "collabserver/server/network/RouterSocket.h"
+#include "collabserver/server/utils/Mailbox.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Responses and broadcasts sent by worker threads, forwarded by a network
+ * thread.
+ *
+ * Worker threads don't own the client facing sockets. Messages are encoded by
+ * the worker and pushed into a lock-free mailbox. The network thread polls
+ * fd() along with its sockets and forwards the frames as is.
+ *
+ * All workers share the same outbox, which is one FIFO: a room moving from a
+ * worker thread to another (See RoomStrand) keeps its broadcasts in commit
+ * order.
+ *
+ * A thread that must never wait (e.g., holds a lock the network thread may
+ * be waiting for) publishes with the NoWait methods instead. When the
+ * mailbox is full, its frames are kept in an unbounded overflow list,
+ * forwarded after the frames already in the mailbox.
+ */
+class Outbox {
+   private:
+    struct Frame {
+        std::string client;  // Empty for broadcasts
+        std::string topic;   // Broadcasts only
+        std::string data;
+    };
+
+    Mailbox<Frame> _frames;
+    std::vector<Frame> _pending;  // Reused buffer for forward
+    std::mutex _overflowMutex;
+    std::vector<Frame> _overflow;           // NoWait frames pushed while mailbox was full
+    std::atomic<bool> _hasOverflow{false};  // Set with _overflowMutex held
+
+   public:
+    /**
+     * Create an empty outbox.
+     *
+     * \param capacity Max number of pending frames (Senders wait if full).
+     */
+    explicit Outbox(const std::size_t capacity);
+
+    Outbox(const Outbox& other) = delete;
+    Outbox& operator=(const Outbox& other) = delete;
+
+   public:
+    /**
+     * Send a response to a client (through the network thread ROUTER).
+     * Thread safe.
+     *
+     * \param client Identity of the recipient client.
+     * \param msg Response to send.
+     */
+    void sendResponse(const std::string& client, const Message& msg);
+
+    /**
+     * Publish a message to the subscribers of the topic (through the network
+     * thread PUB). Thread safe.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param msg Message to publish.
+     */
+    void sendBroadcast(const std::string& topic, const Message& msg);
+
+    /**
+     * Publish a frame already encoded (See MessageCodec) to the subscribers
+     * of the topic. Thread safe.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param data Encoded frame to publish.
+     */
+    void sendBroadcastFrame(const std::string& topic, std::string data);
+
+    /**
+     * Publish a message to the subscribers of the topic, never waits (kept
+     * in the overflow list if mailbox is full). Thread safe. Frames keep
+     * their order for one sender.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param msg Message to publish.
+     */
+    void sendBroadcastNoWait(const std::string& topic, const Message& msg);
+
+    /**
+     * Publish a frame already encoded (See MessageCodec), never waits (See
+     * sendBroadcastNoWait). Thread safe.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param data Encoded frame to publish.
+     */
+    void sendBroadcastFrameNoWait(const std::string& topic, std::string data);
+
+    /**
+     * Forward all pending responses and broadcasts. Never blocks.
+     * Network thread only.
+     *
+     * \param router Socket where to send responses.
+     * \param publisher Where to publish broadcasts.
+     */
+    void forward(RouterSocket& router, Publisher& publisher);
+
+    /**
+     * Network thread is about to poll fd() (See Mailbox::prepareWait).
+     *
+     * \return True if it may wait, false if frames are already pending.
+     */
+    bool prepareWait();
+
+    /**
+     * End a poll started with prepareWait (See Mailbox::finishWait).
+     *
+     * \param isNotified True if fd() was polled readable.
+     */
+    void finishWait(const bool isNotified) { _frames.finishWait(isNotified); }
+
+    /**
+     * File descriptor to poll (e.g., with zmq::poll).
+     *
+     * \return File descriptor.
+     */
+    int fd() const { return _frames.fd(); }
+
+   private:
+    void push(const std::string& client, const std::string& topic, const Message& msg);
+    void pushNoWait(Frame& frame);
+};
+
+}  // namespace collabserver
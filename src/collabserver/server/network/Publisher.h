@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+
+#include "collabserver/network/messaging/Message.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Where broadcasts are published (See PublisherSocket and PublisherPool).
+ *
+ * Each message is published with its topic (See Topic). Messages of the same
+ * topic are published in order, messages of different topics may not be.
+ */
+class Publisher {
+   public:
+    virtual ~Publisher() = default;
+
+   public:
+    /**
+     * Publish a message to the subscribers of the topic.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param msg Message to publish.
+     * \return True if successfully encoded and published, otherwise, false.
+     */
+    virtual bool sendMessage(const std::string& topic, const Message& msg) = 0;
+
+    /**
+     * Publish an already encoded message (See MessageCodec).
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param data Pointer to the encoded frame.
+     * \param size Size of the frame in bytes.
+     */
+    virtual void sendFrame(const std::string& topic, const void* data, std::size_t size) = 0;
+};
+
+}  // namespace collabserver
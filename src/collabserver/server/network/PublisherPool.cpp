@@ -0,0 +1,91 @@
+#include "collabserver/server/network/PublisherPool.h"
+
+#include <cassert>
+#include <functional>  // std::ref
+#include <utility>     // std::move
+
+#include "collabserver/server/network/MessageCodec.h"
+#include "collabserver/server/network/Topic.h"
+#include "collabserver/server/utils/Log.h"
+
+namespace collabserver {
+
+// Max number of frames taken from the mailbox at once.
+static const std::size_t local_sendBatchSize = 64;
+
+PublisherPool::PublisherPool(const std::size_t nbPublishers, const std::size_t capacity)
+    : _context(static_cast<int>(nbPublishers)) {
+    assert(nbPublishers > 0);
+    _lanes.reserve(nbPublishers);
+    for (std::size_t k = 0; k < nbPublishers; ++k) {
+        _lanes.emplace_back(new Lane(_context, capacity));
+    }
+}
+
+PublisherPool::~PublisherPool() { this->stop(); }
+
+void PublisherPool::bind(const std::size_t index, const char* address, const uint16_t port) {
+    assert(index < _lanes.size());
+    assert(!_lanes[index]->thread.joinable());
+    _lanes[index]->socket.bind(address, port);
+}
+
+void PublisherPool::start() {
+    for (std::unique_ptr<Lane>& lane : _lanes) {
+        assert(!lane->thread.joinable());
+        lane->thread = std::thread(&PublisherPool::run, std::ref(*lane));
+    }
+}
+
+void PublisherPool::stop() {
+    for (std::unique_ptr<Lane>& lane : _lanes) {
+        if (lane->thread.joinable()) {
+            lane->frames.push(Frame());
+            lane->thread.join();
+        }
+    }
+}
+
+bool PublisherPool::sendMessage(const std::string& topic, const Message& msg) {
+    std::string data;
+    if (!MessageCodec::encode(msg, data)) {
+        return false;
+    }
+    this->push(topic, std::move(data));
+    return true;
+}
+
+void PublisherPool::sendFrame(const std::string& topic, const void* data, std::size_t size) {
+    this->push(topic, std::string(static_cast<const char*>(data), size));
+}
+
+std::size_t PublisherPool::getIndex(const std::string& topic) const { return Topic::getID(topic) % _lanes.size(); }
+
+void PublisherPool::push(const std::string& topic, std::string data) {
+    assert(!topic.empty());
+    Frame frame;
+    frame.topic = topic;
+    frame.data = std::move(data);
+    _lanes[this->getIndex(topic)]->frames.push(std::move(frame));
+}
+
+void PublisherPool::run(Lane& lane) {
+    LOG << "Publisher thread started\n";
+
+    Frame batch[local_sendBatchSize];
+    bool isRunning = true;
+    while (isRunning) {
+        const std::size_t count = lane.frames.waitBatch(batch, local_sendBatchSize);
+        for (std::size_t k = 0; k < count; ++k) {
+            if (batch[k].topic.empty()) {
+                isRunning = false;  // Frames pushed before were all sent
+                break;
+            }
+            lane.socket.sendFrame(batch[k].topic, batch[k].data.data(), batch[k].data.size());
+        }
+    }
+
+    LOG << "Publisher thread stopped\n";
+}
+
+}  // namespace collabserver
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/server/network/Publisher.h"
+#include "collabserver/server/network/PublisherSocket.h"
+#include "collabserver/server/utils/Mailbox.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Broadcasts spread across several PUB sockets, each with its own thread.
+ *
+ * A topic always goes through the same publisher: index is the ID of the
+ * topic modulo the number of publishers (See getIndex). All topics of a room
+ * (room and catch-up topics) then share one publisher. Subscribers connect
+ * to the publishers of the topics they need.
+ *
+ * Messages are encoded by the calling thread and pushed into the lock-free
+ * mailbox of their publisher. Its thread sends them in order. Publishers have
+ * their own ZeroMQ context, with one I/O thread per publisher, so that
+ * sending to many subscribers is spread across cores too.
+ */
+class PublisherPool : public Publisher {
+   private:
+    struct Frame {
+        std::string topic;  // Empty: stop the thread
+        std::string data;
+    };
+
+    struct Lane {
+        PublisherSocket socket;
+        Mailbox<Frame> frames;
+        std::thread thread;
+
+        Lane(zmq::context_t& context, const std::size_t capacity) : socket(context), frames(capacity) {}
+    };
+
+    zmq::context_t _context;                    // Destroyed once all sockets are closed
+    std::vector<std::unique_ptr<Lane>> _lanes;  // One per publisher
+
+   public:
+    /**
+     * Create the publishers. Threads are not started yet.
+     *
+     * \param nbPublishers Number of PUB sockets and threads (At least 1).
+     * \param capacity Max number of pending frames per publisher (Senders
+     *                 wait if full).
+     */
+    PublisherPool(const std::size_t nbPublishers, const std::size_t capacity);
+
+    /**
+     * Stop the threads (if running).
+     */
+    ~PublisherPool();
+
+    PublisherPool(const PublisherPool& other) = delete;
+    PublisherPool& operator=(const PublisherPool& other) = delete;
+
+   public:
+    /**
+     * Bind the socket of a publisher (tcp). Threads must not be started yet.
+     *
+     * \param index Index of the publisher.
+     * \param address IP address or interface ("*" for all interfaces).
+     * \param port Port to bind.
+     */
+    void bind(const std::size_t index, const char* address, const uint16_t port);
+
+    /**
+     * Start the publisher threads.
+     */
+    void start();
+
+    /**
+     * Stop the publisher threads once all pending frames are sent.
+     * Block until stopped.
+     */
+    void stop();
+
+    /**
+     * Publish a message to the subscribers of the topic. Thread safe.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param msg Message to publish.
+     * \return True if successfully encoded and queued, otherwise, false.
+     */
+    bool sendMessage(const std::string& topic, const Message& msg) override;
+
+    /**
+     * Publish an already encoded message (See MessageCodec). Thread safe.
+     * Frame is copied.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param data Pointer to the encoded frame.
+     * \param size Size of the frame in bytes.
+     */
+    void sendFrame(const std::string& topic, const void* data, std::size_t size) override;
+
+    /**
+     * Index of the publisher of a topic.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \return Index of the publisher.
+     */
+    std::size_t getIndex(const std::string& topic) const;
+
+    /**
+     * Number of publishers.
+     *
+     * \return Number of publishers.
+     */
+    std::size_t size() const { return _lanes.size(); }
+
+   private:
+    void push(const std::string& topic, std::string data);
+    static void run(Lane& lane);
+};
+
+}  // namespace collabserver
@@ -0,0 +1,34 @@
+#include "collabserver/server/network/PublisherSocket.h"
+
+#include "collabserver/server/network/MessageCodec.h"
+
+namespace collabserver {
+
+PublisherSocket::PublisherSocket(zmq::context_t& context) : _socket(context, ZMQ_PUB) {}
+
+void PublisherSocket::bind(const char* address, const uint16_t port) {
+    _endpoint = "tcp://" + std::string(address) + ":" + std::to_string(port);
+    _socket.bind(_endpoint);
+}
+
+void PublisherSocket::unbind() {
+    if (!_endpoint.empty()) {
+        _socket.unbind(_endpoint);
+        _endpoint.clear();
+    }
+}
+
+bool PublisherSocket::sendMessage(const std::string& topic, const Message& msg) {
+    if (!MessageCodec::encode(msg, _frame)) {
+        return false;
+    }
+    this->sendFrame(topic, _frame.data(), _frame.size());
+    return true;
+}
+
+void PublisherSocket::sendFrame(const std::string& topic, const void* data, std::size_t size) {
+    _socket.send(zmq::buffer(topic), zmq::send_flags::sndmore);
+    _socket.send(zmq::const_buffer(data, size), zmq::send_flags::none);
+}
+
+}  // namespace collabserver
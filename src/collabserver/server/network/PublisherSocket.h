@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <string>
+#include <zmq.hpp>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/server/network/Publisher.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * ZeroMQ PUB socket that may publish whole messages or already encoded frames.
+ *
+ * Already encoded frames are useful when a message has been encoded by
+ * another thread (See Outbox). Each message is published with its topic (See
+ * Topic).
+ *
+ * \warning
+ * Like any ZeroMQ socket, this is not thread safe.
+ */
+class PublisherSocket : public Publisher {
+   private:
+    zmq::socket_t _socket;
+    std::string _endpoint;
+    std::string _frame;  // Reused buffer for encoded messages
+
+   public:
+    /**
+     * Create a new PUB socket.
+     *
+     * \param context ZeroMQ context that owns the socket.
+     */
+    PublisherSocket(zmq::context_t& context);
+
+    PublisherSocket(const PublisherSocket& other) = delete;
+    PublisherSocket& operator=(const PublisherSocket& other) = delete;
+
+   public:
+    /**
+     * Bind the socket on the given address and port (tcp).
+     *
+     * \param address IP address or interface ("*" for all interfaces).
+     * \param port Port to bind.
+     */
+    void bind(const char* address, const uint16_t port);
+
+    /**
+     * Unbind the socket. Do nothing if not binded.
+     */
+    void unbind();
+
+    /**
+     * Publish a message to the subscribers of the topic.
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param msg Message to publish.
+     * \return True if successfully encoded and published, otherwise, false.
+     */
+    bool sendMessage(const std::string& topic, const Message& msg) override;
+
+    /**
+     * Publish an already encoded message (See MessageCodec).
+     *
+     * \param topic Topic of the message (See Topic).
+     * \param data Pointer to the encoded frame.
+     * \param size Size of the frame in bytes.
+     */
+    void sendFrame(const std::string& topic, const void* data, std::size_t size) override;
+};
+
+}  // namespace collabserver
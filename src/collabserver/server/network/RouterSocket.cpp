@@ -0,0 +1,68 @@
+#include "collabserver/server/network/RouterSocket.h"
+
+#include "collabserver/server/network/MessageCodec.h"
+
+namespace collabserver {
+
+RouterSocket::RouterSocket(zmq::context_t& context) : _socket(context, ZMQ_ROUTER) {}
+
+void RouterSocket::bind(const char* address, const uint16_t port) {
+    _endpoint = "tcp://" + std::string(address) + ":" + std::to_string(port);
+    _socket.bind(_endpoint);
+}
+
+void RouterSocket::unbind() {
+    if (!_endpoint.empty()) {
+        _socket.unbind(_endpoint);
+        _endpoint.clear();
+    }
+}
+
+Message* RouterSocket::receiveMessage(std::string& identity) {
+    zmq::message_t frame;
+    _socket.recv(frame);
+    return this->receiveBody(frame, identity);
+}
+
+bool RouterSocket::tryReceiveMessage(std::string& identity, Message*& msg) {
+    zmq::message_t frame;
+    if (!_socket.recv(frame, zmq::recv_flags::dontwait)) {
+        return false;
+    }
+    msg = this->receiveBody(frame, identity);
+    return true;
+}
+
+Message* RouterSocket::receiveBody(zmq::message_t& frame, std::string& identity) {
+    identity.assign(static_cast<const char*>(frame.data()), frame.size());
+
+    // Skip the empty delimiter, first non empty frame is the body.
+    // Any extra frame is ignored (but must still be read).
+    // Remaining frames of a multipart message are always already there.
+    Message* msg = nullptr;
+    bool hasBody = false;
+    while (frame.more()) {
+        _socket.recv(frame);
+        if (!hasBody && frame.size() > 0) {
+            hasBody = true;
+            msg = MessageCodec::decode(frame.data(), frame.size());
+        }
+    }
+    return msg;
+}
+
+bool RouterSocket::sendMessage(const std::string& identity, const Message& msg) {
+    if (!MessageCodec::encode(msg, _frame)) {
+        return false;
+    }
+    this->sendFrame(identity, _frame.data(), _frame.size());
+    return true;
+}
+
+void RouterSocket::sendFrame(const std::string& identity, const void* data, std::size_t size) {
+    _socket.send(zmq::buffer(identity), zmq::send_flags::sndmore);
+    _socket.send(zmq::const_buffer(nullptr, 0), zmq::send_flags::sndmore);
+    _socket.send(zmq::const_buffer(data, size), zmq::send_flags::none);
+}
+
+}  // namespace collabserver
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <string>
+#include <zmq.hpp>
+
+#include "collabserver/network/messaging/Message.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * ZeroMQ ROUTER socket that deals with whole messages.
+ *
+ * Unlike a REP socket, ROUTER doesn't force a strict receive / send
+ * alternation. Requests from all clients are queued by ZeroMQ and each
+ * response is routed back to its client using the identity given on receive.
+ * This means a response may be sent later on, after other requests have been
+ * received.
+ *
+ * Expects clients to use REQ sockets (envelope is identity, empty delimiter,
+ * body).
+ *
+ * \warning
+ * Like any ZeroMQ socket, this is not thread safe.
+ */
+class RouterSocket {
+   private:
+    zmq::socket_t _socket;
+    std::string _endpoint;
+    std::string _frame;  // Reused buffer for encoded messages
+
+   public:
+    /**
+     * Create a new ROUTER socket.
+     *
+     * \param context ZeroMQ context that owns the socket.
+     */
+    RouterSocket(zmq::context_t& context);
+
+    RouterSocket(const RouterSocket& other) = delete;
+    RouterSocket& operator=(const RouterSocket& other) = delete;
+
+   public:
+    /**
+     * Bind the socket on the given address and port (tcp).
+     *
+     * \param address IP address or interface ("*" for all interfaces).
+     * \param port Port to bind.
+     */
+    void bind(const char* address, const uint16_t port);
+
+    /**
+     * Unbind the socket. Do nothing if not binded.
+     */
+    void unbind();
+
+    /**
+     * Block until a request is received.
+     * Returned message must be freed with MessageFactory::freeMessage.
+     *
+     * \param identity Set with the identity of the client that sent the request.
+     * \return Pointer to the received message or nullptr if invalid frame.
+     */
+    Message* receiveMessage(std::string& identity);
+
+    /**
+     * Receive a request if any is pending. Never blocks.
+     * Returned message must be freed with MessageFactory::freeMessage.
+     *
+     * \param identity Set with the identity of the client that sent the request.
+     * \param msg Set with the received message or nullptr if invalid frame.
+     * \return True if a request was received, false if none was pending.
+     */
+    bool tryReceiveMessage(std::string& identity, Message*& msg);
+
+    /**
+     * Send a message to the given client.
+     * Never blocks: ROUTER silently drops the message if client is unknown
+     * or can't keep up.
+     *
+     * \param identity Identity of the recipient client.
+     * \param msg Message to send.
+     * \return True if message was queued, otherwise, return false.
+     */
+    bool sendMessage(const std::string& identity, const Message& msg);
+
+    /**
+     * Send an already encoded message (See MessageCodec) to the given client.
+     *
+     * \param identity Identity of the recipient client.
+     * \param data Pointer to the encoded frame.
+     * \param size Size of the frame in bytes.
+     */
+    void sendFrame(const std::string& identity, const void* data, std::size_t size);
+
+    /**
+     * Underlying ZeroMQ socket handle (e.g., for zmq::poll).
+     *
+     * \return Socket handle.
+     */
+    void* handle() { return _socket.handle(); }
+
+   private:
+    Message* receiveBody(zmq::message_t& frame, std::string& identity);
+};
+
+}  // namespace collabserver
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Type IDs of the messages only known by this server.
+ *
+ * These messages are not in the collabserver-network MessageFactory. IDs are
+ * kept away from the MessageFactory ones and fit in one byte (See
+ * MessageCodec). Fields are msgpack encoded (See MsgPack).
+ *
+ * Only the sockets owned by the server (ROUTER, PUB) know these messages.
+ * Clients may send them in router mode only.
+ */
+enum ServerMessageType : int {
+    MSG_ROOM_OPERATION_BATCH = 100,
+    MSG_ROOM_SNAPSHOT = 101,
+    MSG_ROOM_RESUME_REQUEST = 102,
+    MSG_ROOM_HISTORY_REQUEST = 103,
+    MSG_ROOM_HISTORY_PAGE = 104,
+    MSG_ROOM_OPERATION_ACK = 105,
+    MSG_ROOM_CATCH_UP_DONE = 106,
+};
+
+}  // namespace collabserver
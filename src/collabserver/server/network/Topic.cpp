@@ -0,0 +1,30 @@
+#include "collabserver/server/network/Topic.h"
+
+namespace collabserver {
+
+std::string Topic::user(const unsigned int userID) { return Topic::make('u', userID); }
+
+std::string Topic::room(const unsigned int roomID) { return Topic::make('r', roomID); }
+
+std::string Topic::catchUp(const unsigned int roomID) { return Topic::make('c', roomID); }
+
+unsigned int Topic::getID(const std::string& topic) {
+    if (topic.size() != 5) {
+        return 0;
+    }
+    return (static_cast<unsigned int>(static_cast<unsigned char>(topic[1])) << 24) |
+           (static_cast<unsigned int>(static_cast<unsigned char>(topic[2])) << 16) |
+           (static_cast<unsigned int>(static_cast<unsigned char>(topic[3])) << 8) |
+           static_cast<unsigned int>(static_cast<unsigned char>(topic[4]));
+}
+
+std::string Topic::make(const char kind, const unsigned int id) {
+    std::string topic(5, kind);
+    topic[1] = static_cast<char>((id >> 24) & 0xff);
+    topic[2] = static_cast<char>((id >> 16) & 0xff);
+    topic[3] = static_cast<char>((id >> 8) & 0xff);
+    topic[4] = static_cast<char>(id & 0xff);
+    return topic;
+}
+
+}  // namespace collabserver
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Topics of the messages published on the PUB socket.
+ *
+ * Each published message is sent as two frames: the topic, then the encoded
+ * message. Subscribers only subscribe to the topics they need. ZeroMQ filters
+ * on the publisher side, unrelated messages are never sent to them.
+ *
+ * Topics have a fixed size (kind + 4 bytes big endian ID), so that no topic is
+ * a prefix of another one.
+ *  - User topic: 'u' + userID. Messages for one user only (e.g., catch-up).
+ *  - Room topic: 'r' + roomID. Operations broadcasted in the room. Clients
+ *    subscribe to their room topic when joining (and unsubscribe when
+ *    leaving), traffic of the other rooms never reaches them.
+ *  - Catch-up topic: 'c' + roomID. History sent once to all the users
+ *    catching up together in the room (shared catch-up). Clients subscribe
+ *    before sending their join request and unsubscribe once caught up.
+ */
+class Topic {
+   public:
+    /**
+     * Topic of the messages sent to one user only.
+     *
+     * \param userID ID of the recipient user.
+     * \return Topic frame.
+     */
+    static std::string user(const unsigned int userID);
+
+    /**
+     * Topic of the messages sent to all users of a room.
+     *
+     * \param roomID ID of the room.
+     * \return Topic frame.
+     */
+    static std::string room(const unsigned int roomID);
+
+    /**
+     * Topic of the history shared by the users joining a room together.
+     *
+     * \param roomID ID of the room.
+     * \return Topic frame.
+     */
+    static std::string catchUp(const unsigned int roomID);
+
+    /**
+     * ID of the user or room a topic is about.
+     *
+     * \param topic Topic frame (See user, room and catchUp).
+     * \return ID in the topic (0 if not a valid topic).
+     */
+    static unsigned int getID(const std::string& topic);
+
+   private:
+    static std::string make(const char kind, const unsigned int id);
+};
+
+}  // namespace collabserver
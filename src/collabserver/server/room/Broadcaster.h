@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstddef>  // std::size_t
+#include <unordered_set>
+
 #include "OperationInfo.h"
+#include "SnapshotInfo.h"
 
 namespace collabserver {
 
@@ -46,6 +50,99 @@ class Broadcaster {
      * \param id    Room ID where to send operation.
      */
     virtual void broadcastOperationToRoom(const OperationInfo& op, unsigned int id) = 0;
+
+    /**
+     * Broadcast the operation to all users in a room but its sender (Echo
+     * suppression, See Room::setEchoSuppression). Default sends it to each
+     * of them (See sendOperationToUser).
+     *
+     * \param op       Operation to send (Sequence number set).
+     * \param userIDs  Users in the room (Sender included).
+     * \param id       Room ID where to send operation.
+     */
+    virtual void broadcastOperationToOthers(const OperationInfo& op, const std::unordered_set<unsigned int>& userIDs,
+                                            unsigned int id) {
+        for (const unsigned int userID : userIDs) {
+            if (userID != op.userID) {
+                this->sendOperationToUser(op, userID);
+            }
+        }
+    }
+
+    /**
+     * Send the snapshot of a room to the user.
+     * Operations after the snapshot position are sent next.
+     *
+     * \param snapshot Snapshot to send.
+     * \param id       ID of the recipient user.
+     */
+    virtual void sendSnapshotToUser(const SnapshotInfo& snapshot, unsigned int id) = 0;
+
+    /**
+     * Send several operations of a room to the user at once, if the
+     * broadcaster has them already encoded. None of them is dropped, their
+     * sequence numbers follow each other.
+     *
+     * \param roomID    ID of the room.
+     * \param first     Index of the first operation.
+     * \param last      Index after the last operation.
+     * \param id        ID of the recipient user.
+     * \return True if sent, false if not available (Operations are then
+     *         sent one by one with sendOperationToUser).
+     */
+    virtual bool sendOperationsToUser(unsigned int roomID, std::size_t first, std::size_t last, unsigned int id) {
+        return false;
+    }
+
+    /**
+     * Send operation to all the users catching up together in a room
+     * (Shared catch-up, See Room::setSharedCatchUps).
+     *
+     * \param op    Operation to send (Sequence number set).
+     * \param id    ID of the room.
+     */
+    virtual void sendOperationToStream(const OperationInfo& op, unsigned int id) = 0;
+
+    /**
+     * Send the snapshot of a room to all the users catching up together.
+     * Operations after the snapshot position are sent next.
+     *
+     * \param snapshot Snapshot to send.
+     * \param id       ID of the room.
+     */
+    virtual void sendSnapshotToStream(const SnapshotInfo& snapshot, unsigned int id) = 0;
+
+    /**
+     * Same as sendOperationsToUser, to all the users catching up together.
+     *
+     * \param first     Index of the first operation.
+     * \param last      Index after the last operation.
+     * \param id        ID of the room.
+     * \return True if sent, false if not available (Operations are then
+     *         sent one by one with sendOperationToStream).
+     */
+    virtual bool sendOperationsToStream(std::size_t first, std::size_t last, unsigned int id) { return false; }
+
+    /**
+     * Tell the user its catch-up is done: it has all the operations up to
+     * the given position, the next ones come live (See broadcastOperationToRoom).
+     * Sent after the last operation of its history. Default does nothing.
+     *
+     * \param roomID    ID of the room.
+     * \param end       Number of operations of the history sent.
+     * \param id        ID of the recipient user.
+     */
+    virtual void sendCatchUpDoneToUser(unsigned int roomID, std::size_t end, unsigned int id) {}
+
+    /**
+     * Same as sendCatchUpDoneToUser, for a user whose history ends with the
+     * shared catch-up (after its last operation, See sendOperationToStream).
+     *
+     * \param userID    ID of the user who caught up.
+     * \param end       Number of operations of the history sent.
+     * \param id        ID of the room.
+     */
+    virtual void sendCatchUpDoneToStream(unsigned int userID, std::size_t end, unsigned int id) {}
 };
 
 }  // namespace collabserver
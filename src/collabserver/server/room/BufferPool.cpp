@@ -0,0 +1,64 @@
+#include "collabserver/server/room/BufferPool.h"
+
+#include <algorithm>  // std::remove_if
+#include <functional>
+
+namespace collabserver {
+
+std::shared_ptr<const std::string> BufferPool::intern(const std::string& buffer, bool& isShared) {
+    // DevNote: candidates locked here may lose their other references
+    // meanwhile. They are released after the mutex (See release).
+    std::vector<std::shared_ptr<const std::string>> locked;
+    const std::size_t hash = std::hash<std::string>()(buffer);
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::weak_ptr<const std::string>>& candidates = _buffers[hash];
+    for (const std::weak_ptr<const std::string>& candidate : candidates) {
+        locked.push_back(candidate.lock());
+        if (locked.back() && *locked.back() == buffer) {
+            isShared = true;
+            return locked.back();
+        }
+    }
+
+    // DevNote: last reference removes the buffer from the pool. Pool is kept
+    // alive until then, even if its owner is gone.
+    std::shared_ptr<BufferPool> pool = this->shared_from_this();
+    std::shared_ptr<const std::string> stored(new std::string(buffer), [pool, hash](const std::string* removed) {
+        pool->release(hash, removed);
+        delete removed;
+    });
+    candidates.push_back(stored);
+    ++_nbBuffers;
+    _bytes += buffer.size();
+    isShared = false;
+    return stored;
+}
+
+std::size_t BufferPool::getNbBuffers() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _nbBuffers;
+}
+
+std::size_t BufferPool::getBytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _bytes;
+}
+
+void BufferPool::release(const std::size_t hash, const std::string* buffer) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_nbBuffers;
+    _bytes -= buffer->size();
+    auto it = _buffers.find(hash);
+    if (it == _buffers.end()) {
+        return;
+    }
+    // Expired ones only: an equal buffer may have been stored again meanwhile
+    std::vector<std::weak_ptr<const std::string>>& candidates = it->second;
+    auto isExpired = [](const std::weak_ptr<const std::string>& candidate) { return candidate.expired(); };
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), isExpired), candidates.end());
+    if (candidates.empty()) {
+        _buffers.erase(it);
+    }
+}
+
+}  // namespace collabserver
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Memory saved by deduplicating operation buffers.
+ */
+struct DedupStats {
+    std::size_t bufferBytes = 0;  // Bytes of the buffers kept (As if each one was stored)
+    std::size_t savedBytes = 0;   // Bytes of the buffers that were already stored when kept
+
+    /**
+     * Bytes kept per byte actually stored.
+     *
+     * \return Ratio (1 if nothing saved).
+     */
+    double getRatio() const {
+        const std::size_t storedBytes = bufferBytes - savedBytes;
+        return storedBytes > 0 ? static_cast<double>(bufferBytes) / static_cast<double>(storedBytes) : 1.0;
+    }
+
+    DedupStats& operator+=(const DedupStats& other) {
+        bufferBytes += other.bufferBytes;
+        savedBytes += other.savedBytes;
+        return *this;
+    }
+};
+
+/**
+ * \brief
+ * Content-addressed store of operation buffers, shared by the rooms.
+ *
+ * Each distinct buffer is stored once. Rooms keep a reference counted
+ * pointer to it (See intern), the buffer is freed with its last reference.
+ * Buffers are indexed by the hash of their content.
+ *
+ * Thread safe: may be shared by the room workers. Must be created with
+ * std::make_shared (Buffers keep the pool alive).
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+   private:
+    mutable std::mutex _mutex;
+    std::unordered_map<std::size_t, std::vector<std::weak_ptr<const std::string>>> _buffers;  // By hash
+    std::size_t _nbBuffers = 0;
+    std::size_t _bytes = 0;  // Bytes of the distinct buffers
+
+   public:
+    /**
+     * Get the stored copy of a buffer (Stored now if not yet).
+     *
+     * \param buffer Content of the buffer.
+     * \param isShared Set to true if already stored, otherwise, set to false.
+     * \return Pointer to the stored buffer (Never nullptr).
+     */
+    std::shared_ptr<const std::string> intern(const std::string& buffer, bool& isShared);
+
+    /**
+     * Number of distinct buffers stored.
+     *
+     * \return Number of buffers.
+     */
+    std::size_t getNbBuffers() const;
+
+    /**
+     * Memory used by the distinct buffers stored.
+     *
+     * \return Number of bytes.
+     */
+    std::size_t getBytes() const;
+
+   private:
+    void release(const std::size_t hash, const std::string* buffer);
+};
+
+}  // namespace collabserver
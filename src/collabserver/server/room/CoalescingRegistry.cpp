@@ -0,0 +1,45 @@
+#include "collabserver/server/room/CoalescingRegistry.h"
+
+#include <utility>  // std::move
+
+namespace collabserver {
+
+void CoalescingRegistry::registerRule(const unsigned int opTypeID, KeyFunction function) {
+    _rules[opTypeID] = std::move(function);
+}
+
+bool CoalescingRegistry::getKey(const OperationInfo& op, std::string& key) const {
+    auto it = _rules.find(op.opTypeID);
+    if (it == _rules.end()) {
+        return false;
+    }
+    std::string ruleKey;
+    if (!it->second(op, ruleKey)) {
+        return false;
+    }
+
+    // DevNote: type is part of the key, rules of different types may give
+    // the same key.
+    key.assign(reinterpret_cast<const char*>(&op.opTypeID), sizeof(op.opTypeID));
+    key.append(ruleKey);
+    return true;
+}
+
+CoalescingRegistry::KeyFunction CoalescingRegistry::byType() {
+    return [](const OperationInfo& op, std::string& key) {
+        key.clear();
+        return true;
+    };
+}
+
+CoalescingRegistry::KeyFunction CoalescingRegistry::byPrefix(const std::size_t prefixSize) {
+    return [prefixSize](const OperationInfo& op, std::string& key) {
+        if (op.buffer.size() < prefixSize) {
+            return false;
+        }
+        key.assign(op.buffer, 0, prefixSize);
+        return true;
+    };
+}
+
+}  // namespace collabserver
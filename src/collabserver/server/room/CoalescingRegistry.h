@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "OperationInfo.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Coalescing rules of the operation types, keyed by OperationInfo::opTypeID.
+ *
+ * A rule gives the key of an operation. Within a room, a later operation of
+ * the same type with the same key supersedes the earlier ones: these are
+ * dropped from the history (See Room::coalesce). Live broadcast is not
+ * concerned, every operation is still broadcasted in commit order.
+ *
+ * Server doesn't know the operation semantics (CollabData), rules only look
+ * at the operation type and raw buffer. Types without rule are never dropped.
+ */
+class CoalescingRegistry {
+   public:
+    /**
+     * Gives the key of an operation.
+     * Returns false if this operation supersedes nothing and is never
+     * superseded (e.g., buffer too short).
+     */
+    typedef std::function<bool(const OperationInfo& op, std::string& key)> KeyFunction;
+
+   private:
+    std::unordered_map<unsigned int, KeyFunction> _rules;
+
+   public:
+    /**
+     * Register the coalescing rule of an operation type.
+     * Replaces the previous rule of this type (If any).
+     *
+     * \param opTypeID ID of the operation type.
+     * \param function Rule that gives the key of the operations.
+     */
+    void registerRule(const unsigned int opTypeID, KeyFunction function);
+
+    /**
+     * Remove the coalescing rule of an operation type.
+     *
+     * \param opTypeID ID of the operation type.
+     * \return True if removed, otherwise, return false (No rule).
+     */
+    bool unregisterRule(const unsigned int opTypeID) { return _rules.erase(opTypeID) == 1; }
+
+    /**
+     * Check whether an operation type has a coalescing rule.
+     *
+     * \param opTypeID ID of the operation type.
+     * \return True if has a rule, otherwise, return false.
+     */
+    bool hasRule(const unsigned int opTypeID) const { return _rules.count(opTypeID) == 1; }
+
+    /**
+     * Check whether no rule is registered.
+     *
+     * \return True if empty, otherwise, return false.
+     */
+    bool isEmpty() const { return _rules.empty(); }
+
+    /**
+     * Get the coalescing key of an operation (Including its type).
+     *
+     * \param op The operation.
+     * \param key Set to the key (Unchanged if returns false).
+     * \return True if the operation may supersede or be superseded,
+     *         otherwise, return false.
+     */
+    bool getKey(const OperationInfo& op, std::string& key) const;
+
+    // -------------------------------------------------------------------------
+    // Built-in rules
+    // -------------------------------------------------------------------------
+
+   public:
+    /**
+     * Rule where the latest operation of the type supersedes all the
+     * earlier ones (e.g., "set room title").
+     *
+     * \return The rule.
+     */
+    static KeyFunction byType();
+
+    /**
+     * Rule where operations with the same first bytes supersede each other
+     * (e.g., "set attribute X" with the ID of X serialized first).
+     * Operations with a shorter buffer are never dropped.
+     *
+     * \param prefixSize Number of bytes of the key.
+     * \return The rule.
+     */
+    static KeyFunction byPrefix(const std::size_t prefixSize);
+};
+
+}  // namespace collabserver
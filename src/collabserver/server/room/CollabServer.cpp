@@ -1,22 +1,100 @@
 #include "collabserver/server/room/CollabServer.h"
 
-#include <utility>  // std::pair
+#include <algorithm>  // std::find, std::max, std::min
+#include <cassert>
+#include <memory>
+#include <utility>  // std::move, std::pair
+#include <vector>
+
+#include "collabserver/server/utils/constants.h"
 
 namespace collabserver {
 
-CollabServer::CollabServer(Broadcaster& carrot) : _broadcaster(carrot) {
+CollabServer::CollabServer(Broadcaster& carrot)
+    : _historyBytes(std::make_shared<std::atomic<std::size_t>>(0)), _hibernationIdleTime(0), _broadcaster(carrot) {
     // I choose arbitrary numbers. Reserves x users and rooms.
     _users.reserve(20);
     _rooms.reserve(10);
 }
 
 CollabServer::~CollabServer() {
+    // DevNote: deleteUser / deleteRoom erase from the maps, which invalidates
+    // iterators. IDs are collected first.
+    std::vector<unsigned int> ids;
+    ids.reserve(_users.size());
     for (auto& user_it : _users) {
-        this->deleteUser(user_it.second.getUserID());
+        ids.push_back(user_it.first);
+    }
+    for (unsigned int id : ids) {
+        this->deleteUser(id);
     }
     for (auto& room_it : _rooms) {
-        this->deleteRoom(room_it.second.getRoomID());
+        this->updateHistoryBytes(room_it.second.getHistoryBytes(), 0);
+    }
+    _rooms.clear();
+}
+
+void CollabServer::enableStorage(const std::string& storageDir, const Durability durability,
+                                 const std::size_t segmentSize) {
+    _storageDir = storageDir;
+    _durability = durability;
+    _segmentSize = segmentSize;
+}
+
+void CollabServer::setHistoryBudget(const HistoryBudget& budget,
+                                    std::shared_ptr<std::atomic<std::size_t>> serverBytes) {
+    assert(_rooms.empty());
+    _historyBudget = budget;
+    if (serverBytes) {
+        _historyBytes = std::move(serverBytes);
+    }
+}
+
+void CollabServer::setCoalescing(std::shared_ptr<const CoalescingRegistry> registry) {
+    assert(_rooms.empty());
+    _coalescing = std::move(registry);
+}
+
+void CollabServer::setBufferPool(std::shared_ptr<BufferPool> pool) {
+    assert(_rooms.empty());
+    _bufferPool = std::move(pool);
+}
+
+void CollabServer::setHistoryCompression(const bool isEnabled) {
+    assert(_rooms.empty());
+    _compressHistory = isEnabled;
+}
+
+void CollabServer::setSharedCatchUps(const bool isEnabled) {
+    assert(_rooms.empty());
+    _shareCatchUps = isEnabled;
+}
+
+void CollabServer::setEchoSuppression(const bool isEnabled) {
+    assert(_rooms.empty());
+    _suppressEchoes = isEnabled;
+}
+
+void CollabServer::setHibernation(const std::string& directory, const std::chrono::milliseconds idleTime) {
+    _isHibernating = true;
+    _hibernationDir = directory;
+    _hibernationIdleTime = idleTime;
+}
+
+DedupStats CollabServer::getDedupStats() const {
+    DedupStats stats;
+    for (const auto& room_it : _rooms) {
+        stats += room_it.second.getDedupStats();
     }
+    return stats;
+}
+
+HistoryStats CollabServer::getHistoryStats() const {
+    HistoryStats stats = _deletedRoomsStats;
+    for (const auto& room_it : _rooms) {
+        stats += room_it.second.getHistoryStats();
+    }
+    return stats;
 }
 
 // -----------------------------------------------------------------------------
@@ -29,6 +107,11 @@ const User* CollabServer::createNewUser() {
     return &(it.first->second);
 }
 
+const User* CollabServer::registerUser(const unsigned int id) {
+    auto it = _users.emplace(id, User(id));
+    return it.second ? &(it.first->second) : nullptr;
+}
+
 bool CollabServer::deleteUser(const unsigned int id) {
     auto it = _users.find(id);
     if (it == _users.end()) {
@@ -62,13 +145,21 @@ bool CollabServer::isUserInAnyRoom(const unsigned int userID) const {
     return user->getRoom() != nullptr;
 }
 
-bool CollabServer::userJoinRoom(const unsigned int userID, const unsigned int roomID) {
+bool CollabServer::userJoinRoom(const unsigned int userID, const unsigned int roomID,
+                                const std::size_t lastSequence) {
     User* user = this->findUser(userID);
     Room* room = this->findRoom(roomID);
     if (user == nullptr || room == nullptr) {
         return false;
     }
-    return room->addUser(*user);
+    if (!room->addUser(*user, lastSequence)) {
+        return false;
+    }
+    if (room->hasPendingCatchUp() &&
+        std::find(_catchUpRooms.begin(), _catchUpRooms.end(), roomID) == _catchUpRooms.end()) {
+        _catchUpRooms.push_back(roomID);
+    }
+    return true;
 }
 
 bool CollabServer::userLeaveCurrentRoom(const unsigned int userID) {
@@ -106,10 +197,69 @@ User* CollabServer::findUser(const unsigned int id) {
 
 const Room* CollabServer::createNewRoom() {
     const unsigned int id = Room::ROOM_ID_COUNTER + 1;
-    auto it = _rooms.emplace(std::make_pair(id, Room(_broadcaster)));
+    std::shared_ptr<RoomLog> log;
+    if (this->hasStorage()) {
+        log.reset(RoomLog::open(_storageDir, id, _segmentSize));
+        if (!log) {
+            return nullptr;
+        }
+    }
+    auto it = _rooms.emplace(std::make_pair(id, Room(_broadcaster, log)));
+    if (it.second) {
+        this->setupRoom(it.first->second);
+    }
     return &(it.first->second);
 }
 
+const Room* CollabServer::createNewRoom(const unsigned int id) {
+    if (this->hasRoom(id)) {
+        return nullptr;
+    }
+    std::shared_ptr<RoomLog> log;
+    if (this->hasStorage()) {
+        log.reset(RoomLog::open(_storageDir, id, _segmentSize));
+        if (!log) {
+            return nullptr;
+        }
+    }
+    auto it = _rooms.emplace(id, Room(id, _broadcaster, log));
+    if (!it.second) {
+        return nullptr;
+    }
+    this->setupRoom(it.first->second);
+    return &(it.first->second);
+}
+
+const Room* CollabServer::restoreRoom(const unsigned int id) {
+    if (_hibernatedRooms.count(id) == 1) {
+        return this->wakeRoom(id);
+    }
+    if (!this->hasStorage() || !RoomLog::exists(_storageDir, id)) {
+        return nullptr;
+    }
+    return this->createNewRoom(id);
+}
+
+void CollabServer::adoptHibernatedRoom(const unsigned int id) {
+    if (!this->hasStorage() && !this->hasRoom(id)) {
+        _hibernatedRooms.insert(id);  // Otherwise, restored from its persistent log
+    }
+}
+
+std::size_t CollabServer::restoreRooms() {
+    if (!this->hasStorage()) {
+        return 0;
+    }
+    std::size_t count = 0;
+    for (const unsigned int id : RoomLog::listRoomIDs(_storageDir)) {
+        Room::ROOM_ID_COUNTER = std::max(Room::ROOM_ID_COUNTER, id);  // Even if failed: ID is not free
+        if (this->createNewRoom(id) != nullptr) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 bool CollabServer::deleteRoom(const unsigned int id) {
     auto it = _rooms.find(id);
     if (it == _rooms.end()) {
@@ -121,15 +271,196 @@ bool CollabServer::deleteRoom(const unsigned int id) {
         return false;
     }
 
+    this->updateHistoryBytes(room.getHistoryBytes(), 0);
+    _deletedRoomsStats += room.getHistoryStats();
     return _rooms.erase(id) == 1;
 }
 
-bool CollabServer::commitOperationInRoom(const OperationInfo& op, const unsigned int id) {
+bool CollabServer::hibernateRoom(const unsigned int id) {
+    Room* room = this->findRoom(id);
+    if (room == nullptr || !room->isEmpty()) {
+        return false;
+    }
+    if (this->hasStorage()) {
+        // Whole history is in the persistent log, restored from there
+        return room->syncOperations(true) && this->deleteRoom(id);
+    }
+    if (_hibernationDir.empty()) {
+        return false;
+    }
+    std::unique_ptr<RoomArchive> archive(RoomArchive::create(_hibernationDir, id));
+    if (!archive || !room->saveHistory(*archive)) {
+        return false;
+    }
+    _hibernatedRooms.insert(id);
+    return this->deleteRoom(id);
+}
+
+std::size_t CollabServer::hibernateIdleRooms() {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (!_isHibernating || now < _nextHibernationCheck) {
+        return 0;
+    }
+    const std::chrono::milliseconds checkPeriod(COLLAB_HIBERNATION_CHECK_MS);
+    _nextHibernationCheck = now + std::min(_hibernationIdleTime, checkPeriod);
+
+    // DevNote: hibernateRoom erases from the map, which invalidates
+    // iterators. IDs are collected first.
+    std::vector<unsigned int> ids;
+    for (const auto& room_it : _rooms) {
+        const Room& room = room_it.second;
+        if (room.isEmpty() && now - room.getEmptySince() >= _hibernationIdleTime) {
+            ids.push_back(room_it.first);
+        }
+    }
+    std::size_t count = 0;
+    for (const unsigned int id : ids) {
+        if (this->hibernateRoom(id)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool CollabServer::commitOperationInRoom(OperationInfo& op, const unsigned int id) {
     Room* room = this->findRoom(id);
     if (room == nullptr) {
         return false;
     }
-    return room->commitOperation(op);
+    const std::size_t historyBytes = room->getHistoryBytes();
+    const bool isCoalescing = room->hasPendingCoalescing();
+    if (!room->commitOperation(op)) {
+        return false;
+    }
+    this->updateHistoryBytes(historyBytes, room->getHistoryBytes());
+    this->enforceHistoryBudget(*room);
+    if (_coalescing && !isCoalescing && room->hasPendingCoalescing()) {
+        _coalescingRooms.push_back(id);
+    }
+    if (this->getDurability() != Durability::NONE &&
+        std::find(_unsyncedRooms.begin(), _unsyncedRooms.end(), id) == _unsyncedRooms.end()) {
+        _unsyncedRooms.push_back(id);
+    }
+    return true;
+}
+
+bool CollabServer::installSnapshotInRoom(const SnapshotInfo& snapshot, const unsigned int id) {
+    Room* room = this->findRoom(id);
+    if (room == nullptr) {
+        return false;
+    }
+    const std::size_t historyBytes = room->getHistoryBytes();
+    const bool isInstalled = room->installSnapshot(snapshot);
+    this->updateHistoryBytes(historyBytes, room->getHistoryBytes());
+    return isInstalled;
+}
+
+bool CollabServer::readHistoryInRoom(const unsigned int userID, const unsigned int roomID,
+                                     const std::size_t fromSequence, const std::size_t toSequence,
+                                     const std::size_t maxBytes, const Room::RecordFunction& function,
+                                     std::size_t& next) const {
+    const Room* room = this->findRoom(roomID);
+    if (room == nullptr || !room->hasUser(userID)) {
+        return false;
+    }
+    const std::size_t maxAllowed = COLLAB_HISTORY_PAGE_MAX_BYTES;
+    const std::size_t first = std::max((fromSequence > 0) ? fromSequence - 1 : 0, room->getFirstOperationIndex());
+    const std::size_t last = std::min((toSequence > 0) ? toSequence : room->getNbOperations(),
+                                      first + COLLAB_HISTORY_PAGE_MAX_OPS);
+    const std::size_t bytes = (maxBytes > 0) ? std::min(maxBytes, maxAllowed) : maxAllowed;
+    next = room->readHistory(first, last, bytes, function);
+    return true;
+}
+
+bool CollabServer::syncRooms() {
+    // DevNote: rooms are synced one after the other. A single fsync per room
+    // covers every operation committed in it since the previous call.
+    const bool isBlocking = this->getDurability() == Durability::GROUP_SYNC;
+    bool isSynced = true;
+    for (const unsigned int id : _unsyncedRooms) {
+        Room* room = this->findRoom(id);
+        if (room != nullptr && !room->syncOperations(isBlocking)) {
+            isSynced = false;
+        }
+    }
+    _unsyncedRooms.clear();
+    return isSynced;
+}
+
+std::size_t CollabServer::continueCatchUps(const std::size_t maxOps) {
+    std::size_t sent = 0;
+    std::size_t nbRooms = _catchUpRooms.size();  // Each room at most once per call
+    while (sent < maxOps && nbRooms > 0) {
+        const unsigned int id = _catchUpRooms.front();
+        _catchUpRooms.pop_front();
+        --nbRooms;
+
+        Room* room = this->findRoom(id);
+        if (room == nullptr) {
+            continue;
+        }
+        sent += room->continueCatchUp(maxOps - sent);
+        if (room->hasPendingCatchUp()) {
+            _catchUpRooms.push_back(id);
+        }
+    }
+    return sent;
+}
+
+std::size_t CollabServer::continueCoalescing(const std::size_t maxOps) {
+    std::size_t scanned = 0;
+    std::size_t nbRooms = _coalescingRooms.size();  // Each room at most once per call
+    while (scanned < maxOps && nbRooms > 0) {
+        const unsigned int id = _coalescingRooms.front();
+        _coalescingRooms.pop_front();
+        --nbRooms;
+
+        Room* room = this->findRoom(id);
+        if (room == nullptr) {
+            continue;
+        }
+        const std::size_t historyBytes = room->getHistoryBytes();
+        scanned += room->coalesce(*_coalescing, maxOps - scanned);
+        this->updateHistoryBytes(historyBytes, room->getHistoryBytes());
+        if (room->hasPendingCoalescing()) {
+            _coalescingRooms.push_back(id);
+        }
+    }
+    return scanned;
+}
+
+void CollabServer::setupRoom(Room& room) {
+    room.setBufferPool(_bufferPool);
+    room.setCompression(_compressHistory, _coalescing != nullptr);
+    room.setSharedCatchUps(_shareCatchUps);
+    room.setEchoSuppression(_suppressEchoes);
+}
+
+const Room* CollabServer::wakeRoom(const unsigned int id) {
+    if (this->hasRoom(id)) {
+        return nullptr;
+    }
+    std::unique_ptr<RoomArchive> archive(RoomArchive::open(_hibernationDir, id));
+    if (!archive) {
+        return nullptr;
+    }
+    Room& room = _rooms.emplace(id, Room(id, _broadcaster)).first->second;
+    this->setupRoom(room);
+    if (!room.loadHistory(*archive)) {
+        _rooms.erase(id);  // Archive is kept
+        return nullptr;
+    }
+    archive.reset();
+    RoomArchive::remove(_hibernationDir, id);
+    _hibernatedRooms.erase(id);
+
+    this->updateHistoryBytes(0, room.getHistoryBytes());
+    this->enforceHistoryBudget(room);
+    if (_coalescing && room.hasPendingCoalescing() &&
+        std::find(_coalescingRooms.begin(), _coalescingRooms.end(), id) == _coalescingRooms.end()) {
+        _coalescingRooms.push_back(id);
+    }
+    return &room;
 }
 
 const Room* CollabServer::findRoom(const unsigned int id) const {
@@ -148,4 +479,59 @@ Room* CollabServer::findRoom(const unsigned int id) {
     return &(room_it->second);
 }
 
+// -----------------------------------------------------------------------------
+// History budget
+// -----------------------------------------------------------------------------
+
+void CollabServer::updateHistoryBytes(const std::size_t before, const std::size_t after) {
+    if (after > before) {
+        _historyBytes->fetch_add(after - before, std::memory_order_relaxed);
+    } else if (after < before) {
+        _historyBytes->fetch_sub(before - after, std::memory_order_relaxed);
+    }
+}
+
+bool CollabServer::spillRoom(Room& room) {
+    const std::size_t historyBytes = room.getHistoryBytes();
+    const bool isSpilled = room.spillOperations(_historyBudget.spillDir);
+    this->updateHistoryBytes(historyBytes, room.getHistoryBytes());
+    return isSpilled;
+}
+
+void CollabServer::enforceHistoryBudget(Room& room) {
+    if (_historyBudget.spillDir.empty()) {
+        return;
+    }
+    const std::size_t maxBytes = _historyBudget.roomMaxBytes;
+    const std::size_t maxOps = _historyBudget.roomMaxOps;
+    while ((maxBytes > 0 && room.getHistoryBytes() > maxBytes) || (maxOps > 0 && room.getNbHotOperations() > maxOps)) {
+        if (!this->spillRoom(room)) {
+            break;
+        }
+    }
+
+    // DevNote: server budget may be shared with other CollabServers (e.g.,
+    // room workers, or one per room with work stealing). Each one only spills
+    // its own rooms, the largest first, and never the chunk of their most
+    // recent operation: the one committing may not be the one holding the
+    // bytes, and its hot tail must stay in memory. Budget may then be
+    // exceeded by up to one chunk per room. Counter is only read here, the others may
+    // spill at the same time.
+    while (_historyBudget.serverMaxBytes > 0 && this->getHistoryBytes() > _historyBudget.serverMaxBytes) {
+        Room* largest = nullptr;
+        for (auto& room_it : _rooms) {
+            Room& candidate = room_it.second;
+            if (!candidate.canSpillOperations()) {
+                continue;
+            }
+            if (largest == nullptr || candidate.getHistoryBytes() > largest->getHistoryBytes()) {
+                largest = &candidate;
+            }
+        }
+        if (largest == nullptr || !this->spillRoom(*largest)) {
+            break;
+        }
+    }
+}
+
 }  // namespace collabserver
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>  // For std::size_t
+#include <deque>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "Broadcaster.h"
+#include "BufferPool.h"
+#include "CoalescingRegistry.h"
+#include "HistoryBudget.h"
 #include "Room.h"
 #include "User.h"
+#include "collabserver/server/storage/Durability.h"
 
 namespace collabserver {
 
@@ -15,11 +26,51 @@ namespace collabserver {
  *
  * This is the entry point to deal with 'room' components and features
  * such as adding, removing user or room.
+ *
+ * If storage is enabled, the history of each room is persisted in its own
+ * RoomLog. Rooms are restored from these logs after a restart (See
+ * restoreRooms). Committed operations are then made durable by groups (See
+ * syncRooms): the caller commits several operations, syncs once, then
+ * acknowledges all of them.
+ *
+ * Otherwise, history is kept in memory within a budget (See
+ * setHistoryBudget): rooms over budget spill their oldest operations to
+ * temporary files. Superseded operations may also be dropped from it in
+ * the background (See setCoalescing). Identical buffers may be stored once
+ * for all rooms (See setBufferPool), and older operations compressed by
+ * blocks (See setHistoryCompression).
+ *
+ * Users joining a room while others catch up on its history may share
+ * their catch-up (See setSharedCatchUps). Operations may be broadcasted to
+ * the other users of the room only (See setEchoSuppression).
+ *
+ * Rooms with no user for a while may be unloaded (See setHibernation):
+ * resident memory then depends on the active rooms only. An unloaded room is
+ * loaded again by restoreRoom (e.g., when a user joins it).
  */
 class CollabServer {
    private:
     std::unordered_map<unsigned int, User> _users;
     std::unordered_map<unsigned int, Room> _rooms;
+    std::deque<unsigned int> _catchUpRooms;  // Rooms with users catching up (round robin)
+    std::string _storageDir;                 // Persistent room logs (empty: history in memory)
+    std::size_t _segmentSize = RoomLog::DEFAULT_SEGMENT_SIZE;
+    Durability _durability = Durability::NONE;
+    std::vector<unsigned int> _unsyncedRooms;  // Rooms with operations committed since last syncRooms
+    HistoryBudget _historyBudget;
+    std::shared_ptr<std::atomic<std::size_t>> _historyBytes;  // Memory used by the histories (May be shared)
+    HistoryStats _deletedRoomsStats;                          // Stats of the rooms deleted so far
+    std::shared_ptr<const CoalescingRegistry> _coalescing;    // Rules applied to the histories (May be shared)
+    std::deque<unsigned int> _coalescingRooms;                // Rooms with operations not coalesced yet
+    std::shared_ptr<BufferPool> _bufferPool;                  // Buffers of the histories (May be shared)
+    bool _compressHistory = false;                            // Compress the histories in memory by blocks
+    bool _shareCatchUps = false;                              // Joining users of a room share one catch-up
+    bool _suppressEchoes = false;                             // Operations not broadcasted back to their sender
+    bool _isHibernating = false;                              // Unload the idle rooms (See setHibernation)
+    std::string _hibernationDir;                              // Archives of the unloaded rooms (History in memory)
+    std::chrono::milliseconds _hibernationIdleTime;           // Time a room stays empty before being unloaded
+    std::unordered_set<unsigned int> _hibernatedRooms;        // Unloaded rooms saved in an archive
+    std::chrono::steady_clock::time_point _nextHibernationCheck;
     Broadcaster& _broadcaster;
 
    public:
@@ -37,6 +88,135 @@ class CollabServer {
      */
     ~CollabServer();
 
+    /**
+     * Persist the history of the rooms created from now on.
+     *
+     * \param storageDir Directory with the logs of all rooms.
+     * \param durability What syncRooms does.
+     * \param segmentSize Size of the log files.
+     */
+    void enableStorage(const std::string& storageDir, const Durability durability = Durability::NONE,
+                       const std::size_t segmentSize = RoomLog::DEFAULT_SEGMENT_SIZE);
+
+    /**
+     * Check whether room history is persisted.
+     *
+     * \return True if storage is enabled, otherwise, return false.
+     */
+    bool hasStorage() const { return !_storageDir.empty(); }
+
+    /**
+     * Limit the memory used by the history of the rooms (Rooms without
+     * persistent log only). Must be set before creating rooms.
+     *
+     * \param budget Limits and spill directory.
+     * \param serverBytes Counter of the memory used by the histories, shared
+     *                    with other CollabServers (nullptr: counter of this one).
+     */
+    void setHistoryBudget(const HistoryBudget& budget,
+                          std::shared_ptr<std::atomic<std::size_t>> serverBytes = nullptr);
+
+    /**
+     * Drop the superseded operations from the history of the rooms
+     * (Rooms without persistent log only, See Room::coalesce). Must be set
+     * before creating rooms. Coalescing is done by continueCoalescing.
+     *
+     * \param registry Coalescing rules (nullptr: operations are all kept).
+     */
+    void setCoalescing(std::shared_ptr<const CoalescingRegistry> registry);
+
+    /**
+     * Deduplicate the buffers of the histories kept in memory: identical
+     * buffers are stored once in the pool (See Room::setBufferPool). Must
+     * be set before creating rooms.
+     *
+     * \param pool Pool of buffers, may be shared with other CollabServers
+     *             (nullptr: no deduplication).
+     */
+    void setBufferPool(std::shared_ptr<BufferPool> pool);
+
+    /**
+     * Compress the history in memory of the rooms by blocks (See
+     * Room::setCompression). With coalescing, only the operations already
+     * coalesced are compressed. Must be set before creating rooms.
+     *
+     * \param isEnabled True to compress, otherwise, keep raw operations.
+     */
+    void setHistoryCompression(const bool isEnabled);
+
+    /**
+     * Let the users joining a room at the same time share one catch-up
+     * stream (See Room::setSharedCatchUps). Must be set before creating
+     * rooms.
+     *
+     * \param isEnabled True to share, otherwise, one catch-up per user.
+     */
+    void setSharedCatchUps(const bool isEnabled);
+
+    /**
+     * Broadcast the operations committed in a room to its other users only
+     * (See Room::setEchoSuppression). Must be set before creating rooms.
+     *
+     * \param isEnabled True to skip the sender, otherwise, broadcast to the whole room.
+     */
+    void setEchoSuppression(const bool isEnabled);
+
+    /**
+     * Unload the rooms that stay empty for the given time (See
+     * hibernateIdleRooms). Rooms with a persistent log are only removed from
+     * memory. Otherwise, their history is saved in an archive first.
+     *
+     * \param directory Where to save the archives (Not used with storage).
+     * \param idleTime Time a room stays empty before being unloaded.
+     */
+    void setHibernation(const std::string& directory, const std::chrono::milliseconds idleTime);
+
+    /**
+     * Check whether idle rooms are unloaded (See setHibernation).
+     *
+     * \return True if enabled, otherwise, return false.
+     */
+    bool hasHibernation() const { return _isHibernating; }
+
+    /**
+     * Check whether buffers are deduplicated (See setBufferPool).
+     *
+     * \return True if has a buffer pool, otherwise, return false.
+     */
+    bool hasBufferPool() const { return _bufferPool != nullptr; }
+
+    /**
+     * Memory saved by the buffer pool for the operations in memory (All
+     * rooms of this CollabServer).
+     *
+     * \return Statistics (Zero if no pool).
+     */
+    DedupStats getDedupStats() const;
+
+    /**
+     * Memory used by the histories counted in the (possibly shared)
+     * counter. See setHistoryBudget.
+     *
+     * \return Number of bytes.
+     */
+    std::size_t getHistoryBytes() const { return _historyBytes->load(std::memory_order_relaxed); }
+
+    /**
+     * Where the operations sent to the joining users were read from, and
+     * how many were dropped by coalescing (All rooms, including the deleted
+     * ones).
+     *
+     * \return Statistics since the creation of this CollabServer.
+     */
+    HistoryStats getHistoryStats() const;
+
+    /**
+     * Get the durability of the committed operations.
+     *
+     * \return Durability level (NONE if no storage).
+     */
+    Durability getDurability() const { return this->hasStorage() ? _durability : Durability::NONE; }
+
     // -------------------------------------------------------------------------
     // Users management
     // -------------------------------------------------------------------------
@@ -49,6 +229,15 @@ class CollabServer {
      */
     const User* createNewUser();
 
+    /**
+     * Register a user already created elsewhere (e.g., by another
+     * CollabServer) using its ID.
+     *
+     * \param id ID of the user.
+     * \return Pointer to the registered user or nullptr if ID already used.
+     */
+    const User* registerUser(const unsigned int id);
+
     /**
      * Remove a created user from the current CollabServer.
      * If no user for this ID, returns false.
@@ -94,12 +283,15 @@ class CollabServer {
      * Try to add a user to a room (Using IDs).
      * User and room must exist.
      * User must not be in room yet.
+     * Room history is sent later, by continueCatchUps.
      *
      * \param userID ID of the user to add in the room.
      * \param roomID ID of the room where to place user.
+     * \param lastSequence Sequence number of the last operation the user
+     *                     already has (0: none, See Room::addUser).
      * \return True if successfully added in room, otherwise, return false.
      */
-    bool userJoinRoom(const unsigned int userID, const unsigned int roomID);
+    bool userJoinRoom(const unsigned int userID, const unsigned int roomID, const std::size_t lastSequence = 0);
 
     /**
      * Tries to remove a user from its current room.
@@ -148,24 +340,162 @@ class CollabServer {
      */
     const Room* createNewRoom();
 
+    /**
+     * Create a new room using an already allocated ID.
+     *
+     * \param id ID of the room to create.
+     * \return Pointer to the newly created room or nullptr if ID already used.
+     */
+    const Room* createNewRoom(const unsigned int id);
+
+    /**
+     * Restore a room from its archive (Unloaded by hibernateRoom), or else
+     * from its persistent log (Storage must be enabled).
+     * ROOM_ID_COUNTER is not updated.
+     *
+     * \param id ID of the room to restore.
+     * \return Pointer to the restored room or nullptr if no archive nor log,
+     *         or room already exists.
+     */
+    const Room* restoreRoom(const unsigned int id);
+
+    /**
+     * Take over a room unloaded by another CollabServer with the same
+     * settings (See hibernateRoom). It is restored by restoreRoom.
+     *
+     * \param id ID of the unloaded room.
+     */
+    void adoptHibernatedRoom(const unsigned int id);
+
+    /**
+     * Restore all the rooms that have a persistent log.
+     * ROOM_ID_COUNTER is updated so that new rooms don't reuse their IDs.
+     *
+     * \return Number of restored rooms.
+     */
+    std::size_t restoreRooms();
+
     /**
      * Remove a room.
      * The room must be empty.
+     * Its persistent log (if any) is kept.
      *
      * \param id The unique ID of the room.
      * \return True if successfully deleted, otherwise, return false.
      */
     bool deleteRoom(const unsigned int id);
 
+    /**
+     * Unload a room from memory (See restoreRoom).
+     * The room must be empty. Its history is saved in an archive (Synced to
+     * its persistent log instead, if any).
+     *
+     * \param id The unique ID of the room.
+     * \return True if successfully unloaded, otherwise, return false (Room is kept).
+     */
+    bool hibernateRoom(const unsigned int id);
+
+    /**
+     * Unload the rooms empty for longer than the idle time (See
+     * setHibernation). Must be called regularly: rooms are only checked
+     * once per COLLAB_HIBERNATION_CHECK_MS (Or idle time, if shorter).
+     *
+     * \return Number of rooms unloaded.
+     */
+    std::size_t hibernateIdleRooms();
+
     /**
      * Commit an operation to the given room.
      * Do nothing if invalid data.
      *
-     * \param op Reference to the operation to commit.
+     * Operation is broadcasted right away, before syncRooms makes it durable
+     * (See Durability).
+     *
+     * \param op Reference to the operation to commit (Its sequence number is set).
      * \param roomID ID of the room where to commit operation.
      * \return True if successfully committed, otherwise, return false.
      */
-    bool commitOperationInRoom(const OperationInfo& op, const unsigned int roomID);
+    bool commitOperationInRoom(OperationInfo& op, const unsigned int roomID);
+
+    /**
+     * Install a snapshot in the given room (See Room::installSnapshot).
+     * Operations before the snapshot position are discarded.
+     *
+     * \param snapshot Reference to the snapshot to install.
+     * \param roomID ID of the room where to install the snapshot.
+     * \return True if successfully installed, otherwise, return false.
+     */
+    bool installSnapshotInRoom(const SnapshotInfo& snapshot, const unsigned int roomID);
+
+    /**
+     * Read a page of the history of a room for one of its users (See
+     * Room::readHistory). Page is capped to COLLAB_HISTORY_PAGE_MAX_OPS
+     * operations and COLLAB_HISTORY_PAGE_MAX_BYTES bytes of buffers.
+     *
+     * \param userID ID of the user reading (Must be in the room).
+     * \param roomID ID of the room.
+     * \param fromSequence First sequence number to read (0: first kept).
+     * \param toSequence Last sequence number to read (0: latest).
+     * \param maxBytes Max size of the buffers read (0: max allowed).
+     * \param function Called with the index and the record of each operation.
+     * \param next Set with the index after the last operation read.
+     * \return True if read, otherwise, return false (User not in the room).
+     */
+    bool readHistoryInRoom(const unsigned int userID, const unsigned int roomID, const std::size_t fromSequence,
+                           const std::size_t toSequence, const std::size_t maxBytes,
+                           const Room::RecordFunction& function, std::size_t& next) const;
+
+    /**
+     * Send the next slice of history to the users that joined a room.
+     * Must be called regularly while hasPendingCatchUps is true, between
+     * requests (Rooms share the budget round robin).
+     *
+     * \param maxOps Max number of operations to send.
+     * \return Number of operations sent.
+     */
+    std::size_t continueCatchUps(const std::size_t maxOps);
+
+    /**
+     * Coalesce the next operations committed in the rooms (See
+     * setCoalescing). Must be called regularly while hasPendingCoalescing
+     * is true, when there is nothing more urgent to do (Rooms share the
+     * budget round robin).
+     *
+     * \param maxOps Max number of operations to scan.
+     * \return Number of operations scanned.
+     */
+    std::size_t continueCoalescing(const std::size_t maxOps);
+
+    /**
+     * Check whether some committed operations were not coalesced yet.
+     *
+     * \return True if coalescing is pending, otherwise, return false.
+     */
+    bool hasPendingCoalescing() const { return !_coalescingRooms.empty(); }
+
+    /**
+     * Make the operations committed since the previous call durable, as
+     * required by the durability level. With GROUP_SYNC, blocks until they
+     * are on disk. Do nothing with NONE.
+     *
+     * \return True if succeed, otherwise, return false (Operations may be lost).
+     */
+    bool syncRooms();
+
+    /**
+     * Check whether operations were committed since the previous syncRooms.
+     *
+     * \return True if sync is pending, otherwise, return false.
+     */
+    bool hasUnsyncedRooms() const { return !_unsyncedRooms.empty(); }
+
+    /**
+     * Check whether some users didn't receive the whole history of their
+     * room yet.
+     *
+     * \return True if catch-up is pending, otherwise, return false.
+     */
+    bool hasPendingCatchUps() const { return !_catchUpRooms.empty(); }
 
     /**
      * Returns the current number of rooms in the CollabServer
@@ -199,6 +529,12 @@ class CollabServer {
      * \copydoc CollabServer::findRoom
      */
     Room* findRoom(const unsigned int id);
+
+    void setupRoom(Room& room);
+    const Room* wakeRoom(const unsigned int id);
+    void updateHistoryBytes(const std::size_t before, const std::size_t after);
+    bool spillRoom(Room& room);
+    void enforceHistoryBudget(Room& room);
 };
 
 }  // namespace collabserver
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Memory allowed for the room histories kept in memory.
+ *
+ * A room keeps its most recent operations in memory (hot tail). Once over
+ * budget, the oldest ones are spilled to temporary files in spillDir (cold
+ * prefix) and read back from there when a user joins (See Room::spillOperations).
+ * Rooms with a persistent log keep no history in memory and are not concerned.
+ */
+struct HistoryBudget {
+    std::string spillDir;            // Where older operations are spilled (empty: whole history in memory)
+    std::size_t roomMaxBytes = 0;    // Max bytes of operations in memory per room (0: no limit)
+    std::size_t roomMaxOps = 0;      // Max operations in memory per room (0: no limit)
+    std::size_t serverMaxBytes = 0;  // Max bytes of operations in memory for all rooms (0: no limit, Hot tails kept)
+};
+
+/**
+ * \brief
+ * Where the operations sent to joining users were read from.
+ */
+struct HistoryStats {
+    std::size_t hotReads = 0;      // Operations read from memory
+    std::size_t coldReads = 0;     // Operations read from files (spilled or persistent log)
+    std::size_t encodedReads = 0;  // Operations sent already encoded by the broadcaster (Memory)
+    std::size_t dropped = 0;       // Operations dropped from the history by coalescing
+    std::size_t sharedReads = 0;   // Operations not read again, sent once to several users (shared catch-up)
+
+    /**
+     * Part of the operations read from memory.
+     *
+     * \return Hit rate in [0, 1] (1 if nothing read yet).
+     */
+    double getHitRate() const {
+        const std::size_t total = hotReads + coldReads + encodedReads;
+        return total > 0 ? static_cast<double>(hotReads + encodedReads) / static_cast<double>(total) : 1.0;
+    }
+
+    HistoryStats& operator+=(const HistoryStats& other) {
+        hotReads += other.hotReads;
+        coldReads += other.coldReads;
+        encodedReads += other.encodedReads;
+        dropped += other.dropped;
+        sharedReads += other.sharedReads;
+        return *this;
+    }
+};
+
+}  // namespace collabserver
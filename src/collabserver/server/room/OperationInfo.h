@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>  // std::size_t
 #include <string>
 
 namespace collabserver {
@@ -10,10 +11,11 @@ namespace collabserver {
  */
 class OperationInfo {
    public:
-    std::string buffer;     // Operation in serialized form
-    unsigned int roomID;    // Room where operation is done
-    unsigned int userID;    // User that made this operation
-    unsigned int opTypeID;  // ID of the operation type
+    std::string buffer;        // Operation in serialized form
+    unsigned int roomID;       // Room where operation is done
+    unsigned int userID;       // User that made this operation
+    unsigned int opTypeID;     // ID of the operation type
+    std::size_t sequence = 0;  // Position in the room history + 1 (Set when committed, 0: not committed)
 
    public:
     OperationInfo() = default;
@@ -21,6 +23,7 @@ class OperationInfo {
         roomID = info.roomID;
         userID = info.userID;
         opTypeID = info.opTypeID;
+        sequence = info.sequence;
         buffer = info.buffer;
     }
 };
@@ -0,0 +1,242 @@
+#include "collabserver/server/room/OperationLog.h"
+
+#include <algorithm>  // std::max, std::min
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>  // std::move
+
+#include "collabserver/server/storage/BlockCodec.h"
+
+namespace collabserver {
+
+const std::size_t OperationLog::CHUNK_SIZE;
+
+// DevNote: blocks are never persisted, fields are encoded in host order.
+template <typename T>
+static void local_write(std::string& out, const T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static T local_read(const char*& data) {
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    data += sizeof(value);
+    return value;
+}
+
+void OperationLog::setBufferPool(std::shared_ptr<BufferPool> pool) {
+    assert(_size == 0);
+    _pool = std::move(pool);
+}
+
+void OperationLog::start(const std::size_t position) {
+    assert(_size == 0);
+    _firstChunk = position / CHUNK_SIZE;
+    _firstRawChunk = _firstChunk;
+    _first = position;
+    _size = position;
+    if (position % CHUNK_SIZE == 0) {
+        return;
+    }
+
+    // DevNote: front chunk starts with placeholders (Never read, not
+    // accounted in _bytes), so that operations stay at index % CHUNK_SIZE.
+    _chunks.emplace_back(position % CHUNK_SIZE);
+    _chunks.back().reserve(CHUNK_SIZE);
+    _dropped.emplace_back();
+    _blocks.emplace_back();
+    if (_pool) {
+        _pooled.emplace_back(position % CHUNK_SIZE);
+        _pooled.back().reserve(CHUNK_SIZE);
+        _shared.emplace_back();
+    }
+}
+
+void OperationLog::append(const OperationInfo& op) {
+    // DevNote: outer deque never moves the chunks, and chunks never
+    // reallocate their operations.
+    if (_size % CHUNK_SIZE == 0) {
+        _chunks.emplace_back();
+        _chunks.back().reserve(CHUNK_SIZE);
+        _dropped.emplace_back();
+        _blocks.emplace_back();
+        if (_pool) {
+            _pooled.emplace_back();
+            _pooled.back().reserve(CHUNK_SIZE);
+            _shared.emplace_back();
+        }
+    }
+    if (_pool) {
+        bool isShared = false;
+        _pooled.back().push_back(_pool->intern(op.buffer, isShared));
+        _shared.back()[_size % CHUNK_SIZE] = isShared;
+        _dedup.bufferBytes += op.buffer.size();
+        _dedup.savedBytes += isShared ? op.buffer.size() : 0;
+
+        _chunks.back().emplace_back();  // Buffer is in the pool
+        OperationInfo& stored = _chunks.back().back();
+        stored.roomID = op.roomID;
+        stored.userID = op.userID;
+        stored.opTypeID = op.opTypeID;
+        stored.sequence = op.sequence;
+    } else {
+        _chunks.back().push_back(op);
+    }
+    _bytes += OperationLog::getBytes(op);  // Pooled buffers are counted by each log using them
+    ++_size;
+}
+
+void OperationLog::truncate(const std::size_t position) {
+    assert(position <= _size);
+    if (position <= _first) {
+        return;
+    }
+    while (!_chunks.empty() && (_firstChunk + 1) * CHUNK_SIZE <= position) {
+        if (_firstChunk < _firstRawChunk) {
+            _bytes -= _blocks.front().size();
+        } else {
+            for (std::size_t k = std::max(_first, _firstChunk * CHUNK_SIZE); k < (_firstChunk + 1) * CHUNK_SIZE; ++k) {
+                this->releaseBuffer(k);
+                _bytes -= sizeof(OperationInfo);
+            }
+        }
+        if (_firstChunk == _cachedChunk) {
+            _cache.clear();
+            _cachedChunk = SIZE_MAX;
+        }
+        _chunks.pop_front();
+        _dropped.pop_front();
+        _blocks.pop_front();
+        if (_pool) {
+            _pooled.pop_front();
+            _shared.pop_front();
+        }
+        ++_firstChunk;
+    }
+    _firstRawChunk = std::max(_firstRawChunk, _firstChunk);
+
+    // Discarded operations of the front chunk only release their buffer (Kept
+    // in the block if compressed)
+    if (_firstChunk >= _firstRawChunk) {
+        for (std::size_t k = std::max(_first, _firstChunk * CHUNK_SIZE); k < position; ++k) {
+            this->releaseBuffer(k);
+            _bytes -= sizeof(OperationInfo);
+        }
+    }
+    _first = position;
+}
+
+std::size_t OperationLog::compress(const std::size_t position) {
+    std::size_t count = 0;
+    std::string raw;
+    std::string block;
+    while ((_firstRawChunk + 1) * CHUNK_SIZE <= std::min(position, _size)) {
+        const std::size_t chunkStart = _firstRawChunk * CHUNK_SIZE;
+        const std::size_t chunk = _firstRawChunk - _firstChunk;
+
+        // Whole chunk, including discarded and dropped operations (empty buffers)
+        raw.clear();
+        for (std::size_t index = chunkStart; index < chunkStart + CHUNK_SIZE; ++index) {
+            const OperationInfo& op = _pool ? this->rebuild(index) : _chunks[chunk][index % CHUNK_SIZE];
+            local_write<uint32_t>(raw, op.roomID);
+            local_write<uint32_t>(raw, op.userID);
+            local_write<uint32_t>(raw, op.opTypeID);
+            local_write<uint64_t>(raw, op.sequence);
+            local_write<uint32_t>(raw, static_cast<uint32_t>(op.buffer.size()));
+            raw.append(op.buffer);
+        }
+        BlockCodec::compress(raw.data(), raw.size(), block);
+        _blocks[chunk] = block;  // Copy has the exact size
+
+        for (std::size_t index = std::max(_first, chunkStart); index < chunkStart + CHUNK_SIZE; ++index) {
+            this->releaseBuffer(index);
+            _bytes -= sizeof(OperationInfo);
+        }
+        _bytes += _blocks[chunk].size();
+        std::vector<OperationInfo>().swap(_chunks[chunk]);
+        if (_pool) {
+            std::vector<std::shared_ptr<const std::string>>().swap(_pooled[chunk]);
+        }
+        ++_firstRawChunk;
+        ++count;
+    }
+    return count;
+}
+
+void OperationLog::drop(const std::size_t index) {
+    assert(index >= _first && index < _size);
+    std::bitset<CHUNK_SIZE>& dropped = _dropped[index / CHUNK_SIZE - _firstChunk];
+    if (dropped[index % CHUNK_SIZE]) {
+        return;
+    }
+    dropped.set(index % CHUNK_SIZE);
+    this->releaseBuffer(index);  // OperationInfo itself is kept
+}
+
+const OperationInfo& OperationLog::rebuild(const std::size_t index) const {
+    const OperationInfo& op = _chunks[index / CHUNK_SIZE - _firstChunk][index % CHUNK_SIZE];
+    const std::shared_ptr<const std::string>& buffer = _pooled[index / CHUNK_SIZE - _firstChunk][index % CHUNK_SIZE];
+    _rebuilt.roomID = op.roomID;
+    _rebuilt.userID = op.userID;
+    _rebuilt.opTypeID = op.opTypeID;
+    _rebuilt.sequence = op.sequence;
+    if (buffer) {
+        _rebuilt.buffer.assign(*buffer);
+    } else {
+        _rebuilt.buffer.clear();  // Dropped or discarded
+    }
+    return _rebuilt;
+}
+
+const std::vector<OperationInfo>& OperationLog::decompress(const std::size_t chunkNumber) const {
+    if (chunkNumber == _cachedChunk) {
+        return _cache;
+    }
+    const std::string& block = _blocks[chunkNumber - _firstChunk];
+    std::string raw;
+    const bool isDecompressed = BlockCodec::decompress(block.data(), block.size(), raw);
+    assert(isDecompressed);
+    (void)isDecompressed;
+
+    // DevNote: operations of the cache are reused, their buffer keeps its
+    // capacity from one block to the other.
+    _cache.resize(CHUNK_SIZE);
+    const char* data = raw.data();
+    for (OperationInfo& op : _cache) {
+        op.roomID = local_read<uint32_t>(data);
+        op.userID = local_read<uint32_t>(data);
+        op.opTypeID = local_read<uint32_t>(data);
+        op.sequence = static_cast<std::size_t>(local_read<uint64_t>(data));
+        const uint32_t bufferSize = local_read<uint32_t>(data);
+        op.buffer.assign(data, bufferSize);
+        data += bufferSize;
+    }
+    _cachedChunk = chunkNumber;
+    return _cache;
+}
+
+void OperationLog::releaseBuffer(const std::size_t index) {
+    const std::size_t chunk = index / CHUNK_SIZE - _firstChunk;
+    if (index / CHUNK_SIZE < _firstRawChunk) {
+        return;  // Kept in the block
+    }
+    if (!_pool) {
+        OperationInfo& op = _chunks[chunk][index % CHUNK_SIZE];
+        _bytes -= op.buffer.size();
+        std::string().swap(op.buffer);
+        return;
+    }
+    std::shared_ptr<const std::string>& buffer = _pooled[chunk][index % CHUNK_SIZE];
+    if (!buffer) {
+        return;  // Already released
+    }
+    _bytes -= buffer->size();
+    _dedup.bufferBytes -= buffer->size();
+    _dedup.savedBytes -= _shared[chunk][index % CHUNK_SIZE] ? buffer->size() : 0;
+    buffer.reset();
+}
+
+}  // namespace collabserver
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // SIZE_MAX
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BufferPool.h"
+#include "OperationInfo.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Append-only history of the operations of a room.
+ *
+ * Operations are stored in fixed-size chunks. A chunk is allocated once (full
+ * capacity) and never grows, so existing operations are never moved or copied
+ * when the log grows. Append and random access are O(1).
+ *
+ * Operations are indexed from the creation of the log. The oldest ones may be
+ * discarded (See truncate), indexes of the remaining ones don't change.
+ * Any operation may also be dropped (e.g., superseded by a later one): it
+ * keeps its index but its buffer is released and forEach skips it.
+ *
+ * Buffers may be deduplicated (See setBufferPool): identical ones are then
+ * stored once in the pool, shared by all the logs using it. Operations are
+ * rebuilt when read (One buffer copy, no allocation once large enough).
+ *
+ * Full chunks may be compressed into blocks (See compress). A block is
+ * decompressed when read, the last one is cached. The chunk being filled is
+ * never compressed: append has no overhead.
+ */
+class OperationLog {
+   public:
+    static const std::size_t CHUNK_SIZE = 256;  // Operations per chunk (Power of two)
+
+   private:
+    std::deque<std::vector<OperationInfo>> _chunks;  // Each one reserved to CHUNK_SIZE
+    std::deque<std::bitset<CHUNK_SIZE>> _dropped;    // Dropped operations of each chunk
+    std::size_t _firstChunk = 0;                     // Chunk number of the front chunk
+    std::size_t _first = 0;                          // Index of the first operation kept
+    std::size_t _size = 0;
+    std::size_t _bytes = 0;                          // Memory used by the operations kept (See getBytes)
+
+    std::shared_ptr<BufferPool> _pool;                                    // nullptr: buffers in the operations
+    std::deque<std::vector<std::shared_ptr<const std::string>>> _pooled;  // Buffers of each chunk (With _pool)
+    std::deque<std::bitset<CHUNK_SIZE>> _shared;                          // Buffers already in the pool when appended
+    DedupStats _dedup;
+    mutable OperationInfo _rebuilt;  // Last operation read (With _pool)
+
+    std::deque<std::string> _blocks;              // Compressed chunks (Empty for the raw ones)
+    std::size_t _firstRawChunk = 0;               // Chunks before this one are compressed
+    mutable std::size_t _cachedChunk = SIZE_MAX;  // Chunk number of the decompressed block in _cache
+    mutable std::vector<OperationInfo> _cache;
+
+   public:
+    /**
+     * Store the buffers of the operations appended from now on in a pool.
+     * Log must be empty.
+     *
+     * \param pool Pool of buffers, may be shared (nullptr: buffers in the operations).
+     */
+    void setBufferPool(std::shared_ptr<BufferPool> pool);
+
+    /**
+     * Make an empty log start at the given index, as if the operations
+     * before it were appended then discarded (e.g., history reloaded after
+     * a snapshot). Log must be empty.
+     *
+     * \param position Index of the first operation appended.
+     */
+    void start(const std::size_t position);
+
+    /**
+     * Add an operation at the end of the log.
+     *
+     * \param op Operation to add.
+     */
+    void append(const OperationInfo& op);
+
+    /**
+     * Get an operation by its position in the log.
+     *
+     * \param index Position of the operation (In [getFirstIndex(), size())).
+     * \return Reference to the operation (Valid until truncated, or until
+     *         the next read with a buffer pool or compressed chunks).
+     */
+    const OperationInfo& operator[](const std::size_t index) const {
+        if (index / CHUNK_SIZE < _firstRawChunk) {
+            return this->decompress(index / CHUNK_SIZE)[index % CHUNK_SIZE];
+        }
+        if (_pool) {
+            return this->rebuild(index);
+        }
+        return _chunks[index / CHUNK_SIZE - _firstChunk][index % CHUNK_SIZE];
+    }
+
+    /**
+     * Call a function for each operation in [first, last), in log order.
+     * Dropped operations are skipped. Function must not read the log.
+     *
+     * \param first Position of the first operation (At least getFirstIndex()).
+     * \param last Position after the last operation (At most size()).
+     * \param function Called with a const reference to each operation.
+     */
+    template <typename Function>
+    void forEach(std::size_t first, const std::size_t last, Function function) const {
+        while (first < last) {
+            const std::size_t chunkNumber = first / CHUNK_SIZE;
+            const bool isCompressed = chunkNumber < _firstRawChunk;
+            const std::vector<OperationInfo>& chunk =
+                isCompressed ? this->decompress(chunkNumber) : _chunks[chunkNumber - _firstChunk];
+            const std::bitset<CHUNK_SIZE>& dropped = _dropped[chunkNumber - _firstChunk];
+            const std::size_t offset = first % CHUNK_SIZE;
+            const std::size_t count = (last - first < CHUNK_SIZE - offset) ? last - first : CHUNK_SIZE - offset;
+            for (std::size_t k = offset; k < offset + count; ++k) {
+                if (!dropped[k]) {
+                    function((_pool && !isCompressed) ? this->rebuild(first - offset + k) : chunk[k]);
+                }
+            }
+            first += count;
+        }
+    }
+
+    /**
+     * Drop an operation (Its buffer is released, it keeps its index).
+     *
+     * \param index Position of the operation (In [getFirstIndex(), size())).
+     */
+    void drop(const std::size_t index);
+
+    /**
+     * Check whether an operation was dropped.
+     *
+     * \param index Position of the operation (In [getFirstIndex(), size())).
+     * \return True if dropped, otherwise, return false.
+     */
+    bool isDropped(const std::size_t index) const {
+        return _dropped[index / CHUNK_SIZE - _firstChunk][index % CHUNK_SIZE];
+    }
+
+    /**
+     * Compress the full chunks before the given position that are not
+     * compressed yet. Their memory is then accounted as the size of their
+     * block (See getBytes).
+     *
+     * \param position Chunks ending at or before this index are compressed.
+     * \return Number of chunks compressed.
+     */
+    std::size_t compress(const std::size_t position);
+
+    /**
+     * Discard the operations before the given position.
+     *
+     * \param position Index of the first operation to keep (At most size()).
+     */
+    void truncate(const std::size_t position);
+
+    /**
+     * Number of operations appended since the creation of the log (Including
+     * the discarded ones). This is the index of the next operation.
+     *
+     * \return Number of operations.
+     */
+    std::size_t size() const { return _size; }
+
+    /**
+     * Index of the first operation kept (See truncate).
+     *
+     * \return Index of the first operation.
+     */
+    std::size_t getFirstIndex() const { return _first; }
+
+    /**
+     * Memory used by the operations kept (Buffers and OperationInfo, or
+     * compressed blocks).
+     *
+     * \return Number of bytes.
+     */
+    std::size_t getBytes() const { return _bytes; }
+
+    /**
+     * Memory saved by the buffer pool for the operations kept (See
+     * setBufferPool).
+     *
+     * \return Statistics (Zero if no pool).
+     */
+    const DedupStats& getDedupStats() const { return _dedup; }
+
+    /**
+     * Memory accounted for an operation (See getBytes).
+     *
+     * \param op The operation.
+     * \return Number of bytes.
+     */
+    static std::size_t getBytes(const OperationInfo& op) { return sizeof(OperationInfo) + op.buffer.size(); }
+
+    /**
+     * Check whether log has no operation kept.
+     *
+     * \return True if empty, otherwise, return false.
+     */
+    bool isEmpty() const { return _first == _size; }
+
+   private:
+    const OperationInfo& rebuild(const std::size_t index) const;
+    const std::vector<OperationInfo>& decompress(const std::size_t chunkNumber) const;
+    void releaseBuffer(const std::size_t index);
+};
+
+}  // namespace collabserver
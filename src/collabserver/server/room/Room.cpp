@@ -1,28 +1,57 @@
 #include "collabserver/server/room/Room.h"
 
+#include <algorithm>  // std::find, std::find_if, std::max, std::min, std::remove, std::remove_if, std::rotate
 #include <cassert>
-#include <utility>  // std::pair
+#include <utility>  // std::move, std::pair
 
 namespace collabserver {
 
 unsigned int Room::ROOM_ID_COUNTER = 0;
 
-Room::Room(Broadcaster& broadcaster) : _id(++ROOM_ID_COUNTER), _broadcaster(broadcaster) {
+static const std::size_t local_spillSegmentSize = 4 * 1024 * 1024;
+
+Room::Room(Broadcaster& broadcaster, std::shared_ptr<RoomLog> log)
+    : _id(++ROOM_ID_COUNTER), _log(std::move(log)), _broadcaster(broadcaster) {
     _users.reserve(15);  // Reserve values are totally arbitrary here.
-    _operations.reserve(100);
+    if (_log) {
+        _hasSnapshot = _log->loadSnapshot(_snapshot);
+    }
+}
+
+Room::Room(const unsigned int id, Broadcaster& broadcaster, std::shared_ptr<RoomLog> log)
+    : _id(id), _log(std::move(log)), _broadcaster(broadcaster) {
+    _users.reserve(15);
+    if (_log) {
+        _hasSnapshot = _log->loadSnapshot(_snapshot);
+    }
 }
 
 // -----------------------------------------------------------------------------
 // Users management
 // -----------------------------------------------------------------------------
 
-bool Room::addUser(User& user) {
+bool Room::addUser(User& user, const std::size_t lastSequence) {
+    const std::size_t nbOperations = this->getNbOperations();
+    if (lastSequence > nbOperations) {
+        return false;
+    }
     auto result = _users.emplace(user.getUserID());
     bool added = result.second;
     if (added) {
         user.setRoom(this);
-        for (auto op : _operations) {
-            _broadcaster.sendOperationToUser(op, user.getUserID());
+        // DevNote: sequence number N is at position N - 1, the next one to
+        // send is therefore at position lastSequence.
+        const std::size_t first = std::max(this->getFirstOperationIndex(), lastSequence);
+        const bool needsSnapshot = _hasSnapshot && lastSequence < _snapshot.position;
+        if (!needsSnapshot && nbOperations <= first) {
+            _broadcaster.sendCatchUpDoneToUser(_id, nbOperations, user.getUserID());  // Nothing to catch up
+            return added;
+        }
+        _catchUpEnds[user.getUserID()] = nbOperations;
+        if (_isSharingCatchUps) {
+            this->joinSharedCatchUp(user.getUserID(), first, nbOperations, needsSnapshot);
+        } else {
+            _catchUps.push_back({user.getUserID(), first, nbOperations, needsSnapshot});
         }
     }
     return added;
@@ -32,6 +61,15 @@ bool Room::removeUser(User& user) {
     bool removed = _users.erase(user.getUserID()) == 1;
     if (removed) {
         user.setRoom(nullptr);
+        const unsigned int id = user.getUserID();
+        _catchUps.erase(std::remove_if(_catchUps.begin(), _catchUps.end(),
+                                       [id](const CatchUp& catchUp) { return catchUp.userID == id; }),
+                        _catchUps.end());
+        _stream.userIDs.erase(std::remove(_stream.userIDs.begin(), _stream.userIDs.end(), id), _stream.userIDs.end());
+        _catchUpEnds.erase(id);
+        if (_users.empty()) {
+            _emptySince = std::chrono::steady_clock::now();
+        }
     }
     return removed;
 }
@@ -44,23 +82,454 @@ bool Room::hasUser(const User& user) const { return _users.find(user.getUserID()
 // Operations
 // -----------------------------------------------------------------------------
 
-bool Room::commitOperation(const OperationInfo& op) {
+bool Room::commitOperation(OperationInfo& op) {
     if (op.roomID != _id || !this->hasUser(op.userID)) {
         assert(false);  // It's your fault ugly rabbit!
         return false;
     }
+    op.sequence = this->getNbOperations() + 1;
+
+    if (_log) {
+        if (!_log->append(op)) {
+            return false;
+        }
+    } else {
+        _operations.append(op);
+        this->compressOperations();
+    }
+    if (_isSuppressingEchoes) {
+        _broadcaster.broadcastOperationToOthers(op, _users, _id);
+    } else {
+        _broadcaster.broadcastOperationToRoom(op, _id);
+    }
 
-    _operations.emplace_back(op);
+    return true;
+}
 
-    assert(_operations.capacity() > 1);  // If false, you forgot to reserve
-    float load = _operations.size() / _operations.capacity();
-    if (load > 0.90) {
-        _operations.reserve(_operations.size() + 20);  // 20 is arbitrary
+bool Room::installSnapshot(const SnapshotInfo& snapshot) {
+    if (snapshot.roomID != _id || !this->hasUser(snapshot.userID)) {
+        return false;
+    }
+    if (snapshot.position < this->getFirstOperationIndex() || snapshot.position > this->getNbOperations()) {
+        return false;
     }
 
-    _broadcaster.broadcastOperationToRoom(op, _id);
+    if (_log) {
+        if (!_log->installSnapshot(snapshot)) {
+            return false;
+        }
+    } else {
+        if (_spilled) {
+            _spilled->discard(std::min(snapshot.position, _spilled->size()));
+        }
+        _operations.truncate(snapshot.position);
+    }
+    _snapshot = snapshot;
+    _hasSnapshot = true;
 
+    // DevNote: snapshot replaces the state of users still catching up. They
+    // may already have received (live) operations after its position, which
+    // are part of it anyway. Each user receives it once: from the shared
+    // stream, or with its first own catch-up.
+    std::unordered_set<unsigned int> hasSnapshot;
+    if (!_stream.userIDs.empty()) {
+        _stream.needsSnapshot = true;
+        _stream.next = std::max(_stream.next, snapshot.position);
+        _stream.end = std::max(_stream.end, snapshot.position);
+        hasSnapshot.insert(_stream.userIDs.begin(), _stream.userIDs.end());
+    }
+    for (CatchUp& catchUp : _catchUps) {
+        catchUp.needsSnapshot = hasSnapshot.insert(catchUp.userID).second;
+        catchUp.next = std::max(catchUp.next, snapshot.position);
+        catchUp.end = std::max(catchUp.end, snapshot.position);
+    }
     return true;
 }
 
+std::size_t Room::continueCatchUp(const std::size_t maxOps) {
+    // DevNote: each user gets a small slice in turn, so that someone joining
+    // a long room doesn't delay the catch-up of the other joiners.
+    static const std::size_t sliceSize = 64;
+
+    std::size_t sent = 0;
+    while (sent < maxOps && this->hasPendingCatchUp()) {
+        if (!_stream.userIDs.empty()) {
+            sent += this->continueSharedCatchUp(std::min(sliceSize, maxOps - sent));
+        }
+        if (sent == maxOps || _catchUps.empty()) {
+            continue;
+        }
+        CatchUp& catchUp = _catchUps.front();
+        if (catchUp.needsSnapshot) {
+            _broadcaster.sendSnapshotToUser(_snapshot, catchUp.userID);
+            catchUp.needsSnapshot = false;
+            ++sent;
+        }
+        const std::size_t count = std::min(std::min(sliceSize, maxOps - sent), catchUp.end - catchUp.next);
+        this->sendHistory(catchUp.next, catchUp.next + count, catchUp.userID, false);
+        catchUp.next += count;
+        sent += count;
+
+        if (catchUp.next == catchUp.end) {
+            const unsigned int userID = catchUp.userID;
+            const std::size_t end = catchUp.end;
+            _catchUps.erase(_catchUps.begin());
+            if (!this->isCatchingUp(userID)) {
+                _broadcaster.sendCatchUpDoneToUser(_id, this->endCatchUp(userID, end), userID);
+            }
+        } else {
+            std::rotate(_catchUps.begin(), _catchUps.begin() + 1, _catchUps.end());
+        }
+    }
+    return sent;
+}
+
+void Room::joinSharedCatchUp(const unsigned int userID, const std::size_t first, const std::size_t end,
+                             const bool needsSnapshot) {
+    if (_stream.userIDs.empty()) {
+        _stream.next = first;
+        _stream.end = end;
+        _stream.needsSnapshot = needsSnapshot;
+        _stream.userIDs.push_back(userID);
+        return;
+    }
+
+    // DevNote: a user that already has operations after the stream position
+    // or that must not receive its snapshot (it already has later
+    // operations) catches up on its own.
+    if (first > _stream.next || (_stream.needsSnapshot && !needsSnapshot)) {
+        _catchUps.push_back({userID, first, end, needsSnapshot});
+        return;
+    }
+    _stream.userIDs.push_back(userID);
+    const bool needsOwnSnapshot = needsSnapshot && !_stream.needsSnapshot;  // Already sent by the stream
+    if (needsOwnSnapshot || first < _stream.next) {
+        _catchUps.push_back({userID, first, _stream.next, needsOwnSnapshot});
+    }
+    if (end > _stream.end) {
+        // Broadcasted live to the users already in the room, not to this one
+        _catchUps.push_back({userID, _stream.end, end, false});
+    }
+}
+
+std::size_t Room::continueSharedCatchUp(const std::size_t maxOps) {
+    std::size_t sent = 0;
+    if (_stream.needsSnapshot) {
+        _broadcaster.sendSnapshotToStream(_snapshot, _id);
+        _stream.needsSnapshot = false;
+        ++sent;
+    }
+    const std::size_t count = std::min(maxOps - sent, _stream.end - _stream.next);
+    this->sendHistory(_stream.next, _stream.next + count, 0, true);
+    _stream.next += count;
+    sent += count;
+    _stats.sharedReads += count * (_stream.userIDs.size() - 1);
+
+    if (_stream.next == _stream.end) {
+        // Done. Users with a part of their history still to send on their own
+        // are told once it is sent.
+        std::vector<unsigned int> userIDs;
+        userIDs.swap(_stream.userIDs);
+        for (const unsigned int userID : userIDs) {
+            if (!this->isCatchingUp(userID)) {
+                _broadcaster.sendCatchUpDoneToStream(userID, this->endCatchUp(userID, _stream.end), _id);
+            }
+        }
+    }
+    return sent;
+}
+
+bool Room::isCatchingUp(const unsigned int userID) const {
+    auto isUser = [userID](const CatchUp& catchUp) { return catchUp.userID == userID; };
+    return std::find(_stream.userIDs.begin(), _stream.userIDs.end(), userID) != _stream.userIDs.end() ||
+           std::find_if(_catchUps.begin(), _catchUps.end(), isUser) != _catchUps.end();
+}
+
+std::size_t Room::endCatchUp(const unsigned int userID, const std::size_t end) {
+    auto it = _catchUpEnds.find(userID);
+    assert(it != _catchUpEnds.end());
+    const std::size_t catchUpEnd = std::max(it->second, end);  // A snapshot may move the stream past it
+    _catchUpEnds.erase(it);
+    return catchUpEnd;
+}
+
+std::size_t Room::readHistory(std::size_t first, std::size_t last, const std::size_t maxBytes,
+                              const RecordFunction& function) const {
+    first = std::max(first, this->getFirstOperationIndex());
+    last = std::min(last, this->getNbOperations());
+
+    // DevNote: RoomLog::forEach can't stop early, the records after a full
+    // page are only skipped. Callers bound the range.
+    std::size_t next = first;
+    std::size_t bytes = 0;
+    bool hasRead = false;
+    bool isFull = false;
+    auto read = [this, maxBytes, &function, &next, &bytes, &hasRead, &isFull](const LogRecord& record) {
+        if (isFull) {
+            return;
+        }
+        if (!this->isDroppedAt(next)) {
+            if (hasRead && bytes + record.bufferSize > maxBytes) {
+                isFull = true;
+                return;
+            }
+            function(next, record);
+            bytes += record.bufferSize;
+            hasRead = true;
+        }
+        ++next;
+    };
+
+    if (_log) {
+        _log->forEach(first, last, read);
+        return next;
+    }
+    const std::size_t hotFirst = _operations.getFirstIndex();
+    if (first < hotFirst) {
+        _spilled->forEach(first, std::min(last, hotFirst), read);
+    }
+    LogRecord record;
+    while (!isFull && next < last) {
+        if (_operations.isDropped(next)) {
+            ++next;
+            continue;
+        }
+        const OperationInfo& op = _operations[next];
+        record.roomID = op.roomID;
+        record.userID = op.userID;
+        record.opTypeID = op.opTypeID;
+        record.buffer = op.buffer.data();
+        record.bufferSize = op.buffer.size();
+        read(record);
+    }
+    return next;
+}
+
+std::size_t Room::getFirstOperationIndex() const {
+    if (_log) {
+        return _log->getFirstIndex();
+    }
+    return (_spilled && !_spilled->isEmpty()) ? _spilled->getFirstIndex() : _operations.getFirstIndex();
+}
+
+bool Room::spillOperations(const std::string& spillDir) {
+    if (_log || _operations.isEmpty()) {
+        return false;
+    }
+    const std::size_t first = _operations.getFirstIndex();
+    if (!_spilled || _spilled->size() != first) {
+        // Not created yet, or fully discarded by a snapshot after its end
+        _spilled.reset(RoomLog::createTemporary(spillDir, first, local_spillSegmentSize));
+        if (!_spilled) {
+            return false;
+        }
+        _spilledDropped.clear();
+        _spilledFirst = first;
+    }
+
+    // DevNote: a whole chunk at once, so that the chunk is released. If the
+    // temporary log fails (e.g., disk full), only the operations appended to
+    // it are removed from memory. Dropped operations are appended too (with
+    // an empty buffer) so that indexes match, and flagged in _spilledDropped.
+    const std::size_t chunkEnd = (first / OperationLog::CHUNK_SIZE + 1) * OperationLog::CHUNK_SIZE;
+    const std::size_t last = std::min(_operations.size(), chunkEnd);
+    for (std::size_t index = first; index < last && _spilled->append(_operations[index]); ++index) {
+        _spilledDropped.resize(index + 1 - _spilledFirst);
+        _spilledDropped[index - _spilledFirst] = _operations.isDropped(index);
+    }
+    _operations.truncate(_spilled->size());
+    return _spilled->size() > first;
+}
+
+bool Room::canSpillOperations() const {
+    if (_log || _operations.isEmpty()) {
+        return false;
+    }
+    const std::size_t firstChunk = _operations.getFirstIndex() / OperationLog::CHUNK_SIZE;
+    return firstChunk < (_operations.size() - 1) / OperationLog::CHUNK_SIZE;
+}
+
+void Room::sendHistory(const std::size_t first, const std::size_t last, const unsigned int userID,
+                       const bool isShared) {
+    // DevNote: dropped operations split the history in runs, the sequence
+    // numbers of a run follow each other.
+    std::size_t runFirst = first;
+    for (std::size_t index = first; index <= last; ++index) {
+        if (index < last && !this->isDroppedAt(index)) {
+            continue;
+        }
+        if (index > runFirst) {
+            const bool isEncoded = isShared ? _broadcaster.sendOperationsToStream(runFirst, index, _id)
+                                            : _broadcaster.sendOperationsToUser(_id, runFirst, index, userID);
+            if (isEncoded) {
+                _stats.encodedReads += index - runFirst;
+            } else {
+                this->sendOperations(runFirst, index, userID, isShared);
+            }
+        }
+        runFirst = index + 1;
+    }
+}
+
+void Room::sendOperations(std::size_t first, const std::size_t last, const unsigned int userID,
+                          const bool isShared) {
+    if (_log) {
+        this->sendRecords(*_log, first, last, userID, isShared);
+        _stats.coldReads += last - first;
+        return;
+    }
+
+    const std::size_t hotFirst = _operations.getFirstIndex();
+    if (first < hotFirst) {
+        const std::size_t coldLast = std::min(last, hotFirst);
+        this->sendRecords(*_spilled, first, coldLast, userID, isShared);
+        _stats.coldReads += coldLast - first;
+        first = coldLast;
+    }
+    _operations.forEach(first, last, [this, userID, isShared](const OperationInfo& op) {
+        this->sendOperation(op, userID, isShared);
+    });
+    _stats.hotReads += last - first;
+}
+
+void Room::sendOperation(const OperationInfo& op, const unsigned int userID, const bool isShared) {
+    if (isShared) {
+        _broadcaster.sendOperationToStream(op, _id);
+    } else {
+        _broadcaster.sendOperationToUser(op, userID);
+    }
+}
+
+bool Room::isDroppedAt(const std::size_t index) const {
+    if (_log) {
+        return false;  // Never coalesced
+    }
+    if (index < _operations.getFirstIndex()) {
+        return _spilledDropped[index - _spilledFirst];
+    }
+    return _operations.isDropped(index);
+}
+
+std::size_t Room::coalesce(const CoalescingRegistry& registry, const std::size_t maxOps) {
+    if (!this->hasPendingCoalescing()) {
+        return 0;
+    }
+
+    // DevNote: operations spilled or discarded before being scanned are
+    // skipped. A key may map to an operation no longer in memory, it is
+    // then kept and only the next ones are dropped.
+    const std::size_t hotFirst = _operations.getFirstIndex();
+    const std::size_t first = std::max(_coalesced, hotFirst);
+    const std::size_t last = std::min(_operations.size(), first + maxOps);
+    std::string key;
+    for (std::size_t index = first; index < last; ++index) {
+        if (!registry.getKey(_operations[index], key)) {
+            continue;
+        }
+        auto result = _latestByKey.emplace(key, index);
+        if (result.second) {
+            continue;
+        }
+        const std::size_t previous = result.first->second;
+        if (previous >= hotFirst && !_operations.isDropped(previous)) {
+            _operations.drop(previous);
+            ++_stats.dropped;
+        }
+        result.first->second = index;
+    }
+    _coalesced = last;
+    this->compressOperations();
+    return last - first;
+}
+
+void Room::setCompression(const bool isEnabled, const bool afterCoalescing) {
+    _isCompressing = isEnabled;
+    _compressCoalesced = afterCoalescing;
+    this->compressOperations();
+}
+
+void Room::compressOperations() {
+    if (_isCompressing && !_log) {
+        _operations.compress(_compressCoalesced ? _coalesced : _operations.size());
+    }
+}
+
+bool Room::saveHistory(RoomArchive& archive) {
+    if (_log) {
+        return false;
+    }
+    const std::size_t first = this->getFirstOperationIndex();
+    const std::size_t hotFirst = _operations.getFirstIndex();
+    if (!archive.writeHeader(first, _operations.size(), _hasSnapshot ? &_snapshot : nullptr)) {
+        return false;
+    }
+
+    bool isWritten = true;
+    if (first < hotFirst) {
+        std::size_t index = first;
+        _spilled->forEach(first, hotFirst, [this, &archive, &index, &isWritten](const LogRecord& record) {
+            _replayed.roomID = record.roomID;
+            _replayed.userID = record.userID;
+            _replayed.opTypeID = record.opTypeID;
+            _replayed.buffer.assign(record.buffer, record.bufferSize);
+            isWritten = isWritten && archive.write(_replayed, _spilledDropped[index - _spilledFirst]);
+            ++index;
+        });
+    }
+    for (std::size_t index = hotFirst; index < _operations.size() && isWritten; ++index) {
+        isWritten = archive.write(_operations[index], _operations.isDropped(index));
+    }
+    return isWritten && archive.commit();
+}
+
+bool Room::loadHistory(RoomArchive& archive) {
+    assert(!_log && _operations.size() == 0);
+    std::size_t first = 0;
+    std::size_t nbOperations = 0;
+    bool hasSnapshot = false;
+    if (!archive.readHeader(first, nbOperations, _snapshot, hasSnapshot)) {
+        return false;
+    }
+
+    // DevNote: coalesce starts again from the first operation (_coalesced is
+    // 0), which rebuilds _latestByKey. Dropped ones are never counted twice.
+    _operations.start(first);
+    OperationInfo op;
+    bool isDropped = false;
+    for (std::size_t index = first; index < nbOperations; ++index) {
+        if (!archive.read(op, isDropped)) {
+            return false;
+        }
+        op.sequence = index + 1;
+        _operations.append(op);
+        if (isDropped) {
+            _operations.drop(index);
+        }
+        this->compressOperations();
+    }
+    _hasSnapshot = hasSnapshot;
+    return true;
+}
+
+void Room::sendRecords(const RoomLog& log, const std::size_t first, const std::size_t last, const unsigned int userID,
+                       const bool isShared) {
+    // DevNote: records are read from the file mappings. The buffer is copied
+    // in one reused OperationInfo (no allocation once its capacity is large
+    // enough) since Broadcaster needs an OperationInfo.
+    const bool hasDropped = &log == _spilled.get();
+    std::size_t index = first;
+    log.forEach(first, last, [this, userID, isShared, hasDropped, &index](const LogRecord& record) {
+        const std::size_t position = index++;
+        if (hasDropped && _spilledDropped[position - _spilledFirst]) {
+            return;
+        }
+        _replayed.sequence = position + 1;
+        _replayed.roomID = record.roomID;
+        _replayed.userID = record.userID;
+        _replayed.opTypeID = record.opTypeID;
+        _replayed.buffer.assign(record.buffer, record.bufferSize);
+        this->sendOperation(_replayed, userID, isShared);
+    });
+}
+
 }  // namespace collabserver
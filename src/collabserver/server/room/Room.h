@@ -1,27 +1,124 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>  // std::size_t
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>  // std::move
 #include <vector>
 
 #include "Broadcaster.h"
+#include "BufferPool.h"
+#include "CoalescingRegistry.h"
+#include "HistoryBudget.h"
 #include "OperationInfo.h"
+#include "OperationLog.h"
+#include "SnapshotInfo.h"
 #include "User.h"
+#include "collabserver/server/storage/RoomArchive.h"
+#include "collabserver/server/storage/RoomLog.h"
 
 namespace collabserver {
 
 /**
  * \brief
  * Room of collaboration.
+ *
+ * A user joining the room receives the history (catch-up) incrementally:
+ * addUser only places a cursor, history is then sent by bounded slices (See
+ * continueCatchUp). Catch-up ends at the last operation committed before the
+ * join, later operations are broadcasted live to the whole room. Each
+ * operation is therefore received once, either by catch-up or live (not
+ * necessarily in commit order). Once the whole history is sent, the user is
+ * told where it ends (See Broadcaster::sendCatchUpDoneToUser), even if there
+ * was nothing to catch up: live operations received until then go after it.
+ *
+ * Each committed operation gets the next sequence number of the room (Its
+ * position in the history + 1). A user that already has the operations up
+ * to a sequence number only catches up on the following ones (See addUser).
+ *
+ * History is kept in memory (OperationLog) unless the room has a persistent
+ * log (RoomLog). In that case, history lives in the log files only and
+ * catch-up reads the records from the file mappings.
+ *
+ * History in memory may be tiered: the oldest operations are spilled to a
+ * temporary log (See spillOperations) and only the recent ones stay in
+ * memory. Catch-up reads the spilled ones back from the files on demand.
+ *
+ * A user may install a snapshot of the room data (See installSnapshot).
+ * Operations before its position are discarded: joining users receive the
+ * snapshot, then the operations after it.
+ *
+ * Operations superseded by a later one may be dropped from the history in
+ * memory (See coalesce). They keep their sequence number, joining users
+ * only receive the remaining ones.
+ *
+ * Users joining at the same time may share one catch-up stream (See
+ * setSharedCatchUps): the history is read and sent once for all of them.
+ *
+ * A committed operation may be broadcasted to the other users only, its
+ * sender already applied it (See setEchoSuppression).
+ *
+ * Catch-up first asks the broadcaster to send each run of operations at once
+ * (See Broadcaster::sendOperationsToUser), which it may have kept encoded
+ * since their commit. Otherwise, they are read and sent one by one.
+ *
+ * Buffers of the history in memory may be deduplicated with the other rooms
+ * (See setBufferPool), and its older part compressed (See setCompression).
+ *
+ * History in memory of an empty room may be saved in an archive (See
+ * saveHistory), so that the room is unloaded, then loaded again by a new
+ * room with the same ID (See loadHistory).
  */
 class Room {
    public:
     static unsigned int ROOM_ID_COUNTER;
 
+    // Function called for each operation read by readHistory
+    typedef std::function<void(std::size_t index, const LogRecord& record)> RecordFunction;
+
+   private:
+    struct CatchUp {
+        unsigned int userID;
+        std::size_t next;    // Index of the next operation to send
+        std::size_t end;     // Number of operations when user joined
+        bool needsSnapshot;  // Snapshot not sent yet
+    };
+
+    struct SharedCatchUp {
+        std::size_t next = 0;               // Index of the next operation to send
+        std::size_t end = 0;                // Number of operations when started
+        bool needsSnapshot = false;         // Snapshot not sent yet
+        std::vector<unsigned int> userIDs;  // Users receiving it (Empty: no stream running)
+    };
+
    private:
     const unsigned int _id;
-    std::vector<OperationInfo> _operations;
+    OperationLog _operations;           // History if no persistent log (Recent part if some is spilled)
+    std::shared_ptr<RoomLog> _log;      // Persistent history (nullptr: memory only)
+    std::shared_ptr<RoomLog> _spilled;  // Temporary log with the operations before _operations (If any)
+    std::vector<bool> _spilledDropped;  // Dropped operations of _spilled (From _spilledFirst)
+    std::size_t _spilledFirst = 0;      // Index of the first operation of _spilled when created
+    std::size_t _coalesced = 0;         // Operations before this index were coalesced
+    bool _isCompressing = false;        // Compress the full chunks of _operations
+    bool _compressCoalesced = false;    // Only the ones already coalesced
+    // Latest operation of each coalescing key
+    std::unordered_map<std::string, std::size_t> _latestByKey;
+    HistoryStats _stats;
+    OperationInfo _replayed;        // Reused for each operation read from the persistent log
+    SnapshotInfo _snapshot;         // Latest snapshot installed (If _hasSnapshot)
+    bool _hasSnapshot = false;
     std::unordered_set<unsigned int> _users;
+    std::vector<CatchUp> _catchUps;     // Users still receiving the history (round robin)
+    bool _isSharingCatchUps = false;    // Joining users share one stream (See setSharedCatchUps)
+    SharedCatchUp _stream;              // Catch-up sent once to all its users
+    // End of the history sent to each user still catching up (All parts)
+    std::unordered_map<unsigned int, std::size_t> _catchUpEnds;
+    bool _isSuppressingEchoes = false;  // Operations not broadcasted back to their sender
+    std::chrono::steady_clock::time_point _emptySince = std::chrono::steady_clock::now();
     Broadcaster& _broadcaster;
 
     // -------------------------------------------------------------------------
@@ -29,7 +126,23 @@ class Room {
     // -------------------------------------------------------------------------
 
    public:
-    Room(Broadcaster& broadcaster);
+    /**
+     * Create a new room with a new unique ID.
+     *
+     * \param broadcaster Broadcaster used by this room.
+     * \param log Persistent history (nullptr: history in memory).
+     */
+    Room(Broadcaster& broadcaster, std::shared_ptr<RoomLog> log = nullptr);
+
+    /**
+     * Create a room with an already allocated ID.
+     * ROOM_ID_COUNTER is not updated.
+     *
+     * \param id ID of the room.
+     * \param broadcaster Broadcaster used by this room.
+     * \param log Persistent history (nullptr: history in memory).
+     */
+    Room(const unsigned int id, Broadcaster& broadcaster, std::shared_ptr<RoomLog> log = nullptr);
 
     // -------------------------------------------------------------------------
     // Users management
@@ -40,11 +153,15 @@ class Room {
      * Add user in this room.
      * If user is already in a room, do nothing and return false.
      * This also set the user room.
+     * History is not sent yet (See continueCatchUp).
      *
      * \param user Reference to the user to add in room.
-     * \return True if successfully added, otherwise, return false.
+     * \param lastSequence Sequence number of the last operation the user
+     *                     already has (0: none, whole history is sent).
+     * \return True if successfully added, otherwise, return false (Also if
+     *         lastSequence is after the last operation).
      */
-    bool addUser(User& user);
+    bool addUser(User& user, const std::size_t lastSequence = 0);
 
     /**
      * Remove user from this room.
@@ -56,6 +173,14 @@ class Room {
      */
     bool removeUser(User& user);
 
+    /**
+     * Time when the last user left (Or creation time if nobody joined yet).
+     * Meaningless if the room is not empty.
+     *
+     * \return Time point.
+     */
+    std::chrono::steady_clock::time_point getEmptySince() const { return _emptySince; }
+
     // -------------------------------------------------------------------------
     // Operations
     // -------------------------------------------------------------------------
@@ -66,11 +191,243 @@ class Room {
      * Uses the information given inside OperationInfo.
      * Check validity (Room, user in room etc).
      * Broadcast this operation to all registered users.
+     * Sets the sequence number of the operation.
      *
      * \param op    The new operation to commit in the room.
      * \return True if successfully commited, otherwise, return false.
      */
-    bool commitOperation(const OperationInfo& op);
+    bool commitOperation(OperationInfo& op);
+
+    /**
+     * Install a snapshot of the room data.
+     * Check validity (Room, user in room, position not before the current
+     * snapshot and not after the last operation).
+     * Operations before the snapshot position are discarded. Users still
+     * catching up receive the snapshot instead of them.
+     *
+     * \param snapshot The snapshot (Position is an operation index).
+     * \return True if successfully installed, otherwise, return false.
+     */
+    bool installSnapshot(const SnapshotInfo& snapshot);
+
+    /**
+     * Send the next history operations to the users that are catching up.
+     * Users share the budget round robin.
+     *
+     * \param maxOps Max number of operations to send.
+     * \return Number of operations sent.
+     */
+    std::size_t continueCatchUp(const std::size_t maxOps);
+
+    /**
+     * Read a page of the history kept (e.g., for a user fetching older
+     * operations). Operations are read where they are kept (memory, spilled
+     * or persistent log) and given as records pointing into it (No copy).
+     * Dropped operations are skipped.
+     *
+     * \param first Index of the first operation to read (Before the first
+     *              operation kept: from the first one kept).
+     * \param last Index after the last operation to read (Capped to the
+     *             number of operations).
+     * \param maxBytes Max size of the buffers read (At least one operation
+     *                 is read, even if larger).
+     * \param function Called with the index and the record of each
+     *                 operation (Record valid during the call only).
+     * \return Index after the last operation read (Next page starts there).
+     */
+    std::size_t readHistory(std::size_t first, std::size_t last, const std::size_t maxBytes,
+                            const RecordFunction& function) const;
+
+    /**
+     * Check whether some users didn't receive the whole history yet.
+     *
+     * \return True if catch-up is pending, otherwise, return false.
+     */
+    bool hasPendingCatchUp() const { return !_catchUps.empty() || !_stream.userIDs.empty(); }
+
+    /**
+     * Let the users joining while another one catches up share its stream
+     * (See Broadcaster::sendOperationToStream). A user joining late receives
+     * the rest of the stream, and on its own the operations the stream
+     * doesn't cover (Before its current position, or committed since it
+     * started). Operations may then be received out of order: users place
+     * them by sequence number.
+     *
+     * \param isEnabled True to share, otherwise, one catch-up per user.
+     */
+    void setSharedCatchUps(const bool isEnabled) { _isSharingCatchUps = isEnabled; }
+
+    /**
+     * Broadcast the committed operations to the other users of the room
+     * only (See Broadcaster::broadcastOperationToOthers). Sender is only
+     * acknowledged, by the caller of commitOperation (e.g., with the
+     * sequence number of the operation).
+     *
+     * \param isEnabled True to skip the sender, otherwise, broadcast to the whole room.
+     */
+    void setEchoSuppression(const bool isEnabled) { _isSuppressingEchoes = isEnabled; }
+
+    /**
+     * Number of operations committed in this room (Including the ones
+     * restored from the persistent log).
+     *
+     * \return Number of operations.
+     */
+    std::size_t getNbOperations() const { return _log ? _log->size() : _operations.size(); }
+
+    /**
+     * Index of the first operation kept (Snapshot position, if any).
+     *
+     * \return Index of the first operation.
+     */
+    std::size_t getFirstOperationIndex() const;
+
+    /**
+     * Check whether a snapshot was installed.
+     *
+     * \return True if has a snapshot, otherwise, return false.
+     */
+    bool hasSnapshot() const { return _hasSnapshot; }
+
+    /**
+     * Flush the operations committed since the previous sync to the
+     * persistent log (Do nothing if no persistent log).
+     *
+     * \param isBlocking If true, wait until on disk, otherwise, only start
+     *                   the writeback.
+     * \return True if succeed, otherwise, return false.
+     */
+    bool syncOperations(const bool isBlocking) { return !_log || _log->sync(isBlocking); }
+
+    /**
+     * Check whether some operations were committed since the previous sync.
+     *
+     * \return True if not synced, otherwise, return false.
+     */
+    bool hasUnsyncedOperations() const { return _log && _log->hasUnsyncedRecords(); }
+
+    /**
+     * Move the oldest operations kept in memory (up to one OperationLog
+     * chunk) to the temporary log of this room. Do nothing if the room has
+     * a persistent log.
+     *
+     * \param spillDir Directory where to create the temporary log (If not created yet).
+     * \return True if some operations were spilled, otherwise, return false.
+     */
+    bool spillOperations(const std::string& spillDir);
+
+    /**
+     * Check whether spillOperations would keep in memory the chunk of the
+     * most recent operation (Hot tail).
+     *
+     * \return True if some older operations can be spilled, otherwise, return false.
+     */
+    bool canSpillOperations() const;
+
+    /**
+     * Drop the operations superseded by a later one, according to the rules
+     * of the registry. Operations are scanned incrementally in commit order:
+     * call it regularly while hasPendingCoalescing is true (e.g., when
+     * idle). Only the operations still in memory are dropped, the ones
+     * already spilled or in a persistent log are kept.
+     *
+     * \param registry Coalescing rules of the operation types.
+     * \param maxOps Max number of operations to scan.
+     * \return Number of operations scanned.
+     */
+    std::size_t coalesce(const CoalescingRegistry& registry, const std::size_t maxOps);
+
+    /**
+     * Check whether some committed operations were not scanned by coalesce
+     * yet (Always false with a persistent log).
+     *
+     * \return True if coalescing is pending, otherwise, return false.
+     */
+    bool hasPendingCoalescing() const { return !_log && _coalesced < _operations.size(); }
+
+    /**
+     * Store the buffers of the history in memory in a pool shared with
+     * other rooms (Identical ones stored once). No operation committed yet.
+     *
+     * \param pool Pool of buffers (nullptr: each buffer stored in its operation).
+     */
+    void setBufferPool(std::shared_ptr<BufferPool> pool) { _operations.setBufferPool(std::move(pool)); }
+
+    /**
+     * Compress the history in memory by blocks, as soon as a block of
+     * operations is full (See OperationLog::compress). The most recent
+     * operations stay raw.
+     *
+     * \param isEnabled True to compress, otherwise, keep raw operations.
+     * \param afterCoalescing If true, wait until operations are coalesced
+     *                        (See coalesce), so that dropped buffers are
+     *                        never compressed.
+     */
+    void setCompression(const bool isEnabled, const bool afterCoalescing);
+
+    /**
+     * Memory saved by the buffer pool for the operations kept in memory.
+     *
+     * \return Statistics (Zero if no pool).
+     */
+    const DedupStats& getDedupStats() const { return _operations.getDedupStats(); }
+
+    /**
+     * Memory used by the operations kept in memory.
+     *
+     * \return Number of bytes.
+     */
+    std::size_t getHistoryBytes() const { return _operations.getBytes(); }
+
+    /**
+     * Number of operations kept in memory.
+     *
+     * \return Number of operations.
+     */
+    std::size_t getNbHotOperations() const { return _operations.size() - _operations.getFirstIndex(); }
+
+    /**
+     * Where the operations sent to the joining users were read from, and
+     * how many were dropped by coalesce.
+     *
+     * \return Statistics since the creation of the room.
+     */
+    const HistoryStats& getHistoryStats() const { return _stats; }
+
+    /**
+     * Save the whole history kept (In memory and spilled, with the snapshot
+     * and the dropped operations) in an archive, and commit it. The room is
+     * unchanged. Not supported with a persistent log (Already on disk).
+     *
+     * \param archive Archive just created (See RoomArchive::create).
+     * \return True if saved, otherwise, return false.
+     */
+    bool saveHistory(RoomArchive& archive);
+
+    /**
+     * Load the history saved by saveHistory (Sequence numbers are kept).
+     * Room must have no history yet, and no persistent log. Operations are
+     * coalesced again, the dropped ones stay dropped.
+     *
+     * \param archive Archive just opened (See RoomArchive::open).
+     * \return True if loaded, otherwise, return false (Room history is then
+     *         incomplete, the room must be deleted).
+     */
+    bool loadHistory(RoomArchive& archive);
+
+   private:
+    void joinSharedCatchUp(const unsigned int userID, const std::size_t first, const std::size_t end,
+                           const bool needsSnapshot);
+    std::size_t continueSharedCatchUp(const std::size_t maxOps);
+    bool isCatchingUp(const unsigned int userID) const;
+    std::size_t endCatchUp(const unsigned int userID, const std::size_t end);
+    void sendHistory(const std::size_t first, const std::size_t last, const unsigned int userID, const bool isShared);
+    void sendOperations(std::size_t first, const std::size_t last, const unsigned int userID, const bool isShared);
+    void sendOperation(const OperationInfo& op, const unsigned int userID, const bool isShared);
+    bool isDroppedAt(const std::size_t index) const;
+    void compressOperations();
+    void sendRecords(const RoomLog& log, const std::size_t first, const std::size_t last, const unsigned int userID,
+                     const bool isShared);
 
     // -------------------------------------------------------------------------
     // Various
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+
+namespace collabserver {
+
+/**
+ * \brief
+ * State of a room data at a given position of its history.
+ *
+ * The server doesn't know the data implementation: the state is the
+ * serialized CollabData, made by a user. Applying the snapshot gives the
+ * same data as applying the operations before its position.
+ */
+class SnapshotInfo {
+   public:
+    std::string buffer;        // Data state in serialized form
+    unsigned int roomID = 0;   // Room of the data
+    unsigned int userID = 0;   // User that made this snapshot
+    std::size_t position = 0;  // Number of operations included in the state
+};
+
+}  // namespace collabserver
@@ -25,6 +25,14 @@ class User {
      */
     User() : _id(++USER_ID_COUNTER) {}
 
+    /**
+     * Creates a user with an already known ID (e.g., a user created by
+     * another CollabServer). USER_ID_COUNTER is not updated.
+     *
+     * \param id ID of the user.
+     */
+    explicit User(const unsigned int id) : _id(id) {}
+
     /**
      * Set pointer to the current room where user is collaborating.
      * Not check is done, this simply set, regardless the previous value.
@@ -0,0 +1,54 @@
+#include "collabserver/server/scheduler/Strand.h"
+
+#include <utility>  // std::move
+
+namespace collabserver {
+
+// Max number of tasks run before giving back the worker.
+static const std::size_t local_strandBudget = 32;
+
+void Strand::post(TaskScheduler::Task task) {
+    bool mustSchedule = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+        if (!_isScheduled) {
+            _isScheduled = true;
+            mustSchedule = true;
+        }
+    }
+    if (mustSchedule) {
+        _scheduler.submit([this] { this->run(); });
+    }
+}
+
+bool Strand::isIdle() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_isScheduled;
+}
+
+void Strand::run() {
+    TaskScheduler::Task task;
+    for (std::size_t k = 0; k < local_strandBudget; ++k) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_tasks.empty()) {
+                _isScheduled = false;
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+
+    // Budget exhausted, let other strands run (queued behind them)
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_tasks.empty()) {
+        _isScheduled = false;
+    } else {
+        _scheduler.submit([this] { this->run(); });
+    }
+}
+
+}  // namespace collabserver
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <deque>
+#include <mutex>
+
+#include "TaskScheduler.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Serialized stream of tasks running on a TaskScheduler.
+ *
+ * Tasks posted to a strand run one at a time, in the posted order, but not
+ * always on the same worker thread. An idle strand costs nothing. Once a task
+ * is posted, the strand is submitted to the scheduler as a single task that
+ * runs the pending tasks (Other workers may steal it).
+ *
+ * After a few tasks, the strand is submitted again behind the tasks waiting
+ * on its worker (See TaskScheduler::submit) instead of running all pending
+ * tasks, so that a busy strand doesn't hold a worker forever.
+ *
+ * \warning
+ * Strand must outlive its pending tasks (e.g., stop the scheduler first).
+ */
+class Strand {
+   private:
+    TaskScheduler& _scheduler;
+    std::mutex _mutex;
+    std::deque<TaskScheduler::Task> _tasks;
+    bool _isScheduled = false;  // Submitted to scheduler or running
+
+   public:
+    /**
+     * Create a new idle strand.
+     *
+     * \param scheduler Scheduler that runs the tasks.
+     */
+    explicit Strand(TaskScheduler& scheduler) : _scheduler(scheduler) {}
+
+    Strand(const Strand& other) = delete;
+    Strand& operator=(const Strand& other) = delete;
+
+   public:
+    /**
+     * Post a task at the end of this strand. Thread safe.
+     *
+     * \param task Task to run.
+     */
+    void post(TaskScheduler::Task task);
+
+    /**
+     * Check whether no task is pending nor running. Thread safe.
+     * Strand may be destroyed then, if nothing posts to it meanwhile.
+     *
+     * \return True if idle, otherwise, return false.
+     */
+    bool isIdle();
+
+   private:
+    void run();
+};
+
+}  // namespace collabserver
@@ -0,0 +1,128 @@
+#include "collabserver/server/scheduler/TaskScheduler.h"
+
+#include <cassert>
+#include <utility>  // std::move
+
+namespace collabserver {
+
+// Worker running on the current thread (nullptr if not a worker thread)
+static thread_local const TaskScheduler* local_currentScheduler = nullptr;
+static thread_local std::size_t local_currentWorker = 0;
+
+TaskScheduler::TaskScheduler(const unsigned int nbThreads) : _nbPending(0), _nbSteals(0), _nextWorker(0) {
+    assert(nbThreads > 0);
+    _workers.reserve(nbThreads);
+    for (unsigned int k = 0; k < nbThreads; ++k) {
+        _workers.push_back(new Worker());
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    this->stop();
+    for (Worker* worker : _workers) {
+        delete worker;
+    }
+}
+
+void TaskScheduler::start() {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        assert(!_isRunning);
+        _isRunning = true;
+    }
+    for (std::size_t k = 0; k < _workers.size(); ++k) {
+        _workers[k]->thread = std::thread(&TaskScheduler::run, this, k);
+    }
+}
+
+void TaskScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _isRunning = false;
+    }
+    _sleepCondition.notify_all();
+    for (Worker* worker : _workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void TaskScheduler::submit(Task task) {
+    std::size_t index;
+    if (local_currentScheduler == this) {
+        index = local_currentWorker;
+    } else {
+        index = _nextWorker.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+    }
+
+    {
+        // DevNote: worker runs its own tasks from the front, in the submitted
+        // order. Run from the back, a stream of new tasks (e.g., woken strands)
+        // would starve a busy strand queued before them.
+        std::lock_guard<std::mutex> lock(_workers[index]->mutex);
+        _workers[index]->tasks.push_back(std::move(task));
+    }
+    _nbPending.fetch_add(1);
+
+    // DevNote: lock makes sure a worker can't miss the notification between
+    // its check of _nbPending and its wait.
+    { std::lock_guard<std::mutex> lock(_sleepMutex); }
+    _sleepCondition.notify_one();
+}
+
+void TaskScheduler::run(const std::size_t index) {
+    local_currentScheduler = this;
+    local_currentWorker = index;
+
+    Task task;
+    while (true) {
+        if (this->popLocal(index, task) || this->steal(index, task)) {
+            _nbPending.fetch_sub(1);
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        if (_nbPending.load() > 0) {
+            lock.unlock();
+            std::this_thread::yield();  // Being pushed or taken by another worker, retry
+            continue;
+        }
+        if (!_isRunning) {
+            break;
+        }
+        _sleepCondition.wait(lock, [this] { return _nbPending.load() > 0 || !_isRunning; });
+    }
+
+    local_currentScheduler = nullptr;
+}
+
+bool TaskScheduler::popLocal(const std::size_t index, Task& task) {
+    Worker& worker = *_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+    return true;
+}
+
+bool TaskScheduler::steal(const std::size_t index, Task& task) {
+    const std::size_t nbWorkers = _workers.size();
+    for (std::size_t k = 1; k < nbWorkers; ++k) {
+        Worker& victim = *_workers[(index + k) % nbWorkers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            _nbSteals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace collabserver
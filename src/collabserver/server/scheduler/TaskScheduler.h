@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>  // std::size_t
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Pool of worker threads with work stealing.
+ *
+ * Each worker has its own deque of tasks. A worker runs its own tasks first
+ * (oldest first) and, once idle, steals the newest task of another worker.
+ * Tasks submitted from outside the pool are spread over the workers.
+ *
+ * Tasks may run on any worker and in any order. Use Strand for tasks that
+ * must run one at a time and in order.
+ */
+class TaskScheduler {
+   public:
+    typedef std::function<void()> Task;
+
+   private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    std::vector<Worker*> _workers;
+    std::atomic<std::size_t> _nbPending;  // Submitted but not yet taken tasks
+    std::atomic<std::size_t> _nbSteals;
+    std::atomic<unsigned int> _nextWorker;
+    bool _isRunning = false;  // Protected by _sleepMutex
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCondition;
+
+   public:
+    /**
+     * Create a new scheduler. Threads are not started yet.
+     *
+     * \param nbThreads Number of worker threads (At least 1).
+     */
+    explicit TaskScheduler(const unsigned int nbThreads);
+
+    /**
+     * Stop the scheduler (if running).
+     */
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler& other) = delete;
+    TaskScheduler& operator=(const TaskScheduler& other) = delete;
+
+   public:
+    /**
+     * Start all worker threads.
+     */
+    void start();
+
+    /**
+     * Stop all worker threads once all submitted tasks are done (including
+     * the ones submitted meanwhile). Block until stopped.
+     */
+    void stop();
+
+    /**
+     * Submit a task. Thread safe.
+     * From a worker thread, task is placed in the worker own deque, behind
+     * the tasks already waiting there (e.g., a Strand over budget).
+     *
+     * \param task Task to run.
+     */
+    void submit(Task task);
+
+    /**
+     * Number of worker threads.
+     *
+     * \return Number of threads.
+     */
+    std::size_t getNbThreads() const { return _workers.size(); }
+
+    /**
+     * Number of tasks stolen since the creation (For stats).
+     *
+     * \return Number of stolen tasks.
+     */
+    std::size_t getNbSteals() const { return _nbSteals.load(); }
+
+   private:
+    void run(const std::size_t index);
+    bool popLocal(const std::size_t index, Task& task);
+    bool steal(const std::size_t index, Task& task);
+};
+
+}  // namespace collabserver
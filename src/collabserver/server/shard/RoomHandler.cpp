@@ -0,0 +1,436 @@
+#include "collabserver/server/shard/RoomHandler.h"
+
+#include <chrono>
+#include <iterator>  // std::next
+#include <utility>   // std::move
+
+#include "collabserver/network/messaging/MessageFactory.h"
+#include "collabserver/server/network/MessageCodec.h"
+#include "collabserver/server/network/MsgRoomCatchUpDone.h"
+#include "collabserver/server/network/MsgRoomHistoryPage.h"
+#include "collabserver/server/network/MsgRoomOperationAck.h"
+#include "collabserver/server/network/MsgRoomOperationBatch.h"
+#include "collabserver/server/network/ServerMessages.h"
+#include "collabserver/server/network/Topic.h"
+#include "collabserver/server/utils/Log.h"
+
+namespace collabserver {
+
+RoomHandler::RoomHandler(RoomSink& sink, const RoomShardConfig& config)
+    : _sink(sink),
+      _collabserver(*this),
+      _window(config.window, [this](const unsigned int roomID, std::vector<OperationInfo>& operations) {
+          this->publishRoomOperations(roomID, operations);
+      }),
+      _sequenceNumbers(config.sequenceNumbers),
+      _echoSuppression(config.echoSuppression),
+      _bundleMaxBytes(config.catchUpBundleBytes) {
+    _collabserver.setHistoryBudget(config.history, config.historyBytes);
+    _collabserver.setCoalescing(config.coalescing);
+    _collabserver.setBufferPool(config.bufferPool);
+    _collabserver.setHistoryCompression(config.compressHistory);
+    _collabserver.setSharedCatchUps(config.sharedCatchUps);
+    _collabserver.setEchoSuppression(config.echoSuppression);
+    if (config.hibernateAfterSec > 0) {
+        _collabserver.setHibernation(config.hibernationDir, std::chrono::seconds(config.hibernateAfterSec));
+    }
+}
+
+bool RoomHandler::handleMessage(const Message& msg, const unsigned int roomID) {
+    switch (msg.getType()) {
+        case MessageFactory::MSG_CREA_DATA_REQUEST:
+            this->handleMessage(static_cast<const MsgCreaDataRequest&>(msg), roomID);
+            return true;
+        case MessageFactory::MSG_JOIN_DATA_REQUEST:
+            this->handleMessage(static_cast<const MsgJoinDataRequest&>(msg));
+            return true;
+        case MessageFactory::MSG_LEAVE_DATA_REQUEST:
+            this->handleMessage(static_cast<const MsgLeaveDataRequest&>(msg));
+            return true;
+        case MSG_ROOM_RESUME_REQUEST:
+            this->handleMessage(static_cast<const MsgRoomResumeRequest&>(msg));
+            return true;
+        case MSG_ROOM_HISTORY_REQUEST:
+            this->handleMessage(static_cast<const MsgRoomHistoryRequest&>(msg));
+            return true;
+        case MessageFactory::MSG_ROOM_OPERATION:
+            this->handleMessage(static_cast<const MsgRoomOperation&>(msg));
+            return true;
+        case MSG_ROOM_SNAPSHOT:
+            this->handleMessage(static_cast<const MsgRoomSnapshot&>(msg));
+            return true;
+        default:
+            return false;
+    }
+}
+
+void RoomHandler::flushBroadcasts(const bool isIdle) {
+    if (isIdle) {
+        _window.flushAll();
+    } else {
+        _window.flushExpired();
+    }
+}
+
+std::size_t RoomHandler::hibernateIdleRooms() {
+    const std::size_t count = _collabserver.hibernateIdleRooms();
+    if (count > 0) {
+        for (auto it = _bundles.begin(); it != _bundles.end();) {
+            it = _collabserver.hasRoom(it->first) ? std::next(it) : _bundles.erase(it);
+        }
+    }
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// Message handling
+// -----------------------------------------------------------------------------
+
+void RoomHandler::handleMessage(const MsgCreaDataRequest& msg, const unsigned int roomID) {
+    LOG << "Message received (MsgCreaDataRequest)\n";
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    unsigned int userID = static_cast<MsgCreaDataRequest>(msg).getUserID();
+    const Room* room = (roomID != 0) ? _collabserver.createNewRoom(roomID) : _collabserver.createNewRoom();
+    if (_isCopyingUsers) {
+        _collabserver.registerUser(userID);
+    }
+
+    Message* response = nullptr;
+    if (room != nullptr && _collabserver.userJoinRoom(userID, room->getRoomID())) {
+        LOG << "(UserID=" << userID << "): Room successfully created (RoomID=" << room->getRoomID() << ")\n";
+        response = factory.newMessage(MessageFactory::MSG_CREA_DATA_SUCCESS);
+        static_cast<MsgCreaDataSuccess*>(response)->setDataID(room->getRoomID());
+        _sink.sendResponse(*response);
+    } else {
+        LOG << "(UserID=" << userID << "): Unable to create new room\n";
+        if (_isCopyingUsers) {
+            _collabserver.deleteUser(userID);
+        }
+        response = factory.newMessage(MessageFactory::MSG_ERROR);
+        _sink.sendResponse(*response);
+    }
+
+    factory.freeMessage(response);
+}
+
+void RoomHandler::handleMessage(const MsgJoinDataRequest& msg) {
+    LOG << "Message received (MsgJoinDataRequest)\n";
+
+    unsigned int userID = static_cast<MsgJoinDataRequest>(msg).getUserID();
+    unsigned int roomID = static_cast<MsgJoinDataRequest>(msg).getDataID();
+    this->joinRoom(userID, roomID, 0);
+}
+
+void RoomHandler::handleMessage(const MsgRoomResumeRequest& msg) {
+    LOG << "Message received (MsgRoomResumeRequest)\n";
+    this->joinRoom(msg.getUserID(), msg.getRoomID(), msg.getSequence());
+}
+
+void RoomHandler::handleMessage(const MsgRoomHistoryRequest& msg) {
+    LOG << "Message received (MsgRoomHistoryRequest)\n";
+    const CollabServer& rooms = _collabserver;
+    const unsigned int userID = msg.getUserID();
+    const unsigned int roomID = msg.getRoomID();
+    if (!rooms.isUserInRoom(userID, roomID)) {
+        LOG << "(UserID=" << userID << "): Unable to read history (RoomID=" << roomID << ")\n";
+        MessageFactory& factory = MessageFactory::getInstance();
+        Message* response = factory.newMessage(MessageFactory::MSG_ERROR);
+        _sink.sendResponse(*response);
+        factory.freeMessage(response);
+        return;
+    }
+
+    // Records are encoded in the page straight from where the history keeps them
+    const Room* room = rooms.findRoom(roomID);
+    MsgRoomHistoryPage page(roomID, room->getFirstOperationIndex() + 1, room->getNbOperations());
+    std::size_t next = 0;
+    rooms.readHistoryInRoom(
+        userID, roomID, msg.getFromSequence(), msg.getToSequence(), msg.getMaxBytes(),
+        [&page](const std::size_t index, const LogRecord& record) { page.addOperation(index + 1, record); }, next);
+    page.setNextSequence(next + 1);
+    _sink.sendResponse(page);
+}
+
+void RoomHandler::joinRoom(const unsigned int userID, const unsigned int roomID, const std::size_t lastSequence) {
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    // Delayed operations are part of the history sent to the new user
+    _window.flushRoom(roomID);
+    if (!_collabserver.hasRoom(roomID) && _collabserver.restoreRoom(roomID) != nullptr) {
+        LOG << "Room restored (RoomID=" << roomID << ")\n";
+    }
+    if (_isCopyingUsers) {
+        _collabserver.registerUser(userID);
+    }
+    bool success = _collabserver.userJoinRoom(userID, roomID, lastSequence);
+
+    Message* response = nullptr;
+    if (success) {
+        LOG << "(UserID=" << userID << "): User successfully joined room (RoomID=" << roomID
+            << ", after sequence " << lastSequence << ")\n";
+        if (_collabserver.hasBufferPool()) {
+            const CollabServer& rooms = _collabserver;
+            const DedupStats& dedup = rooms.findRoom(roomID)->getDedupStats();
+            LOG << "(RoomID=" << roomID << "): History dedup ratio " << dedup.getRatio() << ", "
+                << dedup.savedBytes << " bytes saved\n";
+        }
+        response = factory.newMessage(MessageFactory::MSG_JOIN_DATA_SUCCESS);
+        _sink.sendResponse(*response);
+    } else {
+        LOG << "(UserID=" << userID << "): Unable to join room (RoomID=" << roomID << ")\n";
+        if (_isCopyingUsers) {
+            _collabserver.deleteUser(userID);
+        }
+        response = factory.newMessage(MessageFactory::MSG_ERROR);
+        _sink.sendResponse(*response);
+    }
+
+    factory.freeMessage(response);
+}
+
+void RoomHandler::handleMessage(const MsgLeaveDataRequest& msg) {
+    LOG << "Message received (MsgLeaveDataRequest)\n";
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    unsigned int userID = static_cast<MsgLeaveDataRequest>(msg).getUserID();
+    bool success = _collabserver.userLeaveCurrentRoom(userID);
+    if (_isCopyingUsers) {
+        _collabserver.deleteUser(userID);  // User copy is only kept while in a room
+    }
+
+    Message* response = nullptr;
+    if (success) {
+        LOG << "(UserID=" << userID << "): Successfully left his room\n";
+        response = factory.newMessage(MessageFactory::MSG_LEAVE_DATA_SUCCESS);
+        _sink.sendResponse(*response);
+    } else {
+        LOG << "(UserID=" << userID << "): Unable to left his room\n";
+        response = factory.newMessage(MessageFactory::MSG_ERROR);
+        _sink.sendResponse(*response);
+    }
+
+    factory.freeMessage(response);
+}
+
+void RoomHandler::handleMessage(const MsgRoomOperation& msg) {
+    LOG << "Message received (MsgRoomOperation)\n";
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    OperationInfo op;
+    op.roomID = static_cast<const MsgRoomOperation>(msg).getRoomID();
+    op.userID = static_cast<const MsgRoomOperation>(msg).getUserID();
+    op.opTypeID = static_cast<const MsgRoomOperation>(msg).getOpTypeID();
+    op.buffer = static_cast<const MsgRoomOperation>(msg).getOperationBuffer();
+
+    // It's just aliases for visibility
+    const unsigned int roomID = op.roomID;
+    const unsigned int userID = op.userID;
+
+    bool success = _collabserver.commitOperationInRoom(op, roomID);
+    if (success && _sink.isGroupCommit() && _collabserver.getDurability() == Durability::GROUP_SYNC) {
+        // Acknowledged with the operations committed meanwhile, with one sync for all of them
+        _sink.deferAck(roomID, op.sequence);
+        return;
+    }
+    if (success && !_sink.isGroupCommit() && _collabserver.hasUnsyncedRooms()) {
+        success = _collabserver.syncRooms();  // Group of one operation
+    }
+
+    Message* response = nullptr;
+    if (success && _echoSuppression) {
+        // Sender already applied it, only its sequence number is sent back
+        LOG << "(UserID=" << userID << "): Successfully broadcasted operation (RoomID=" << roomID << ")\n";
+        _sink.sendResponse(MsgRoomOperationAck(roomID, op.sequence));
+        return;
+    }
+
+    if (success) {
+        // DevNote: REP Pattern requires a response, here, this is a dummy response.
+        LOG << "(UserID=" << userID << "): Successfully broadcasted operation (RoomID=" << roomID << ")\n";
+        response = factory.newMessage(MessageFactory::MSG_EMPTY);
+        _sink.sendResponse(*response);
+    } else {
+        LOG << "(UserID=" << userID << "): Unable to broadcast operation (RoomID=" << roomID << ")\n";
+        response = factory.newMessage(MessageFactory::MSG_ERROR);
+        _sink.sendResponse(*response);
+    }
+
+    factory.freeMessage(response);
+}
+
+void RoomHandler::handleMessage(const MsgRoomSnapshot& msg) {
+    LOG << "Message received (MsgRoomSnapshot)\n";
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    const SnapshotInfo& snapshot = msg.getSnapshot();
+    const unsigned int roomID = snapshot.roomID;
+    const unsigned int userID = snapshot.userID;
+
+    // Delayed operations are published before the log is truncated
+    _window.flushRoom(roomID);
+    bool success = _collabserver.installSnapshotInRoom(snapshot, roomID);
+
+    Message* response = nullptr;
+    if (success) {
+        auto it = _bundles.find(roomID);
+        if (it != _bundles.end()) {
+            it->second->discard(snapshot.position);
+        }
+        LOG << "(UserID=" << userID << "): Snapshot installed at position " << snapshot.position
+            << " (RoomID=" << roomID << ")\n";
+        response = factory.newMessage(MessageFactory::MSG_EMPTY);
+        _sink.sendResponse(*response);
+    } else {
+        LOG << "(UserID=" << userID << "): Unable to install snapshot (RoomID=" << roomID << ")\n";
+        response = factory.newMessage(MessageFactory::MSG_ERROR);
+        _sink.sendResponse(*response);
+    }
+
+    factory.freeMessage(response);
+}
+
+// -----------------------------------------------------------------------------
+// Broadcaster methods
+// -----------------------------------------------------------------------------
+
+void RoomHandler::sendOperationToUser(const OperationInfo& op, unsigned int id) {
+    LOG << "(RoomID=" << op.roomID << "): Sending operation to user (UserID=" << id << ")\n";
+    this->publishOperation(Topic::user(id), op);
+}
+
+void RoomHandler::broadcastOperationToRoom(const OperationInfo& op, unsigned int id) {
+    LOG << "(UserID=" << op.userID << "): Broadcasting operation in room (roomID=" << id << ")\n";
+    this->keepEncoded(op, id);
+    if (_window.isEnabled()) {
+        _window.add(op);
+    } else {
+        this->publishOperation(Topic::room(id), op);
+    }
+}
+
+void RoomHandler::broadcastOperationToOthers(const OperationInfo& op, const std::unordered_set<unsigned int>& userIDs,
+                                             unsigned int id) {
+    LOG << "(UserID=" << op.userID << "): Broadcasting operation to the others in room (roomID=" << id << ")\n";
+    this->keepEncoded(op, id);
+
+    // DevNote: a PUB socket can't skip one subscriber of the room topic.
+    // Operation is published on the topic of each other user instead (Not
+    // delayed by the window), encoded once.
+    std::string frame;
+    if (!this->encodeOperation(op, frame)) {
+        return;
+    }
+    for (const unsigned int userID : userIDs) {
+        if (userID != op.userID) {
+            _sink.publishFrame(Topic::user(userID), frame);
+        }
+    }
+}
+
+void RoomHandler::keepEncoded(const OperationInfo& op, unsigned int id) {
+    if (_bundleMaxBytes > 0) {
+        std::unique_ptr<CatchUpBundle>& bundle = _bundles[id];
+        if (!bundle) {
+            bundle.reset(new CatchUpBundle(id, _bundleMaxBytes));
+        }
+        bundle->append(op);
+    }
+}
+
+void RoomHandler::sendSnapshotToUser(const SnapshotInfo& snapshot, unsigned int id) {
+    LOG << "(RoomID=" << snapshot.roomID << "): Sending snapshot to user (UserID=" << id << ")\n";
+    MsgRoomSnapshot msg(snapshot);
+    _sink.publish(Topic::user(id), msg);
+}
+
+bool RoomHandler::sendOperationsToUser(unsigned int roomID, std::size_t first, std::size_t last, unsigned int id) {
+    if (!this->publishEncoded(Topic::user(id), roomID, first, last)) {
+        return false;
+    }
+    LOG << "(RoomID=" << roomID << "): Sent " << last - first << " encoded operations to user (UserID=" << id
+        << ")\n";
+    return true;
+}
+
+void RoomHandler::sendOperationToStream(const OperationInfo& op, unsigned int id) {
+    LOG << "(RoomID=" << id << "): Sending operation to shared catch-up\n";
+    this->publishOperation(Topic::catchUp(id), op);
+}
+
+void RoomHandler::sendSnapshotToStream(const SnapshotInfo& snapshot, unsigned int id) {
+    LOG << "(RoomID=" << id << "): Sending snapshot to shared catch-up\n";
+    MsgRoomSnapshot msg(snapshot);
+    _sink.publish(Topic::catchUp(id), msg);
+}
+
+bool RoomHandler::sendOperationsToStream(std::size_t first, std::size_t last, unsigned int id) {
+    if (!this->publishEncoded(Topic::catchUp(id), id, first, last)) {
+        return false;
+    }
+    LOG << "(RoomID=" << id << "): Sent " << last - first << " encoded operations to shared catch-up\n";
+    return true;
+}
+
+void RoomHandler::sendCatchUpDoneToUser(unsigned int roomID, std::size_t end, unsigned int id) {
+    LOG << "(RoomID=" << roomID << "): User caught up to " << end << " operation(s) (UserID=" << id << ")\n";
+    MsgRoomCatchUpDone msg(roomID, id, end);
+    _sink.publish(Topic::user(id), msg);
+}
+
+void RoomHandler::sendCatchUpDoneToStream(unsigned int userID, std::size_t end, unsigned int id) {
+    LOG << "(RoomID=" << id << "): User caught up to " << end << " operation(s) with shared catch-up (UserID="
+        << userID << ")\n";
+    MsgRoomCatchUpDone msg(id, userID, end);
+    _sink.publish(Topic::catchUp(id), msg);
+}
+
+bool RoomHandler::publishEncoded(const std::string& topic, unsigned int roomID, std::size_t first, std::size_t last) {
+    auto it = _bundles.find(roomID);
+    std::string frame;
+    if (it == _bundles.end() || !it->second->encode(first, last, frame)) {
+        return false;
+    }
+    _sink.publishFrame(topic, std::move(frame));
+    return true;
+}
+
+void RoomHandler::publishOperation(const std::string& topic, const OperationInfo& op) {
+    std::string frame;
+    if (this->encodeOperation(op, frame)) {
+        _sink.publishFrame(topic, std::move(frame));
+    }
+}
+
+bool RoomHandler::encodeOperation(const OperationInfo& op, std::string& frame) const {
+    if (_sequenceNumbers) {
+        // DevNote: MsgRoomOperation has no field for the sequence number
+        MsgRoomOperationBatch batch(op.roomID, std::vector<OperationInfo>(1, op));
+        return MessageCodec::encode(batch, frame);
+    }
+    MessageFactory& factory = MessageFactory::getInstance();
+
+    Message* msg = factory.newMessage(MessageFactory::MSG_ROOM_OPERATION);
+
+    static_cast<MsgRoomOperation*>(msg)->setRoomID(op.roomID);
+    static_cast<MsgRoomOperation*>(msg)->setUserID(op.userID);
+    static_cast<MsgRoomOperation*>(msg)->setOpTypeID(op.opTypeID);
+    static_cast<MsgRoomOperation*>(msg)->setOperationBuffer(op.buffer);
+
+    const bool isEncoded = MessageCodec::encode(*msg, frame);
+
+    factory.freeMessage(msg);
+    return isEncoded;
+}
+
+void RoomHandler::publishRoomOperations(const unsigned int roomID, std::vector<OperationInfo>& operations) {
+    if (operations.size() == 1 && !_sequenceNumbers) {
+        this->publishOperation(Topic::room(roomID), operations.front());
+        return;
+    }
+    LOG << "(RoomID=" << roomID << "): Broadcasting " << operations.size() << " operations at once\n";
+    MsgRoomOperationBatch msg(roomID, std::move(operations));
+    _sink.publish(Topic::room(roomID), msg);
+}
+
+}  // namespace collabserver
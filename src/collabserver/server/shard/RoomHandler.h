@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/network/messaging/MessageList.h"
+#include "collabserver/server/network/BroadcastWindow.h"
+#include "collabserver/server/network/CatchUpBundle.h"
+#include "collabserver/server/network/MsgRoomHistoryRequest.h"
+#include "collabserver/server/network/MsgRoomResumeRequest.h"
+#include "collabserver/server/network/MsgRoomSnapshot.h"
+#include "collabserver/server/room/Broadcaster.h"
+#include "collabserver/server/room/BufferPool.h"
+#include "collabserver/server/room/CoalescingRegistry.h"
+#include "collabserver/server/room/CollabServer.h"
+#include "collabserver/server/room/HistoryBudget.h"
+#include "collabserver/server/shard/RoomSink.h"
+#include "collabserver/server/storage/Durability.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Settings shared by all room workers.
+ */
+struct RoomShardConfig {
+    BroadcastWindowConfig window;                            // Micro-batching of room broadcasts
+    std::string storageDir;                                  // Persistent room logs (empty: history in memory)
+    Durability durability = Durability::NONE;                // Persisted before acknowledging an operation
+    HistoryBudget history;                                   // Memory allowed for the histories (no storageDir)
+    std::shared_ptr<std::atomic<std::size_t>> historyBytes;  // Memory used by the histories of all workers
+    bool sequenceNumbers = false;                            // Publish operations with their sequence number
+    std::shared_ptr<const CoalescingRegistry> coalescing;    // Drop superseded operations (Shared by all workers)
+    std::shared_ptr<BufferPool> bufferPool;                  // Buffers of all workers (nullptr: no dedup)
+    bool compressHistory = false;                            // Compress older operations by blocks
+    unsigned int hibernateAfterSec = 0;                      // Unload the rooms empty for this long (0: never)
+    std::string hibernationDir;                              // Archives of the unloaded rooms (History in memory)
+    std::size_t catchUpBundleBytes = 0;                      // Operations kept encoded per room for catch-ups (0: none)
+    bool sharedCatchUps = false;                             // Users joining together share one catch-up
+    bool echoSuppression = false;                            // Operations not published back to their sender
+};
+
+/**
+ * \brief
+ * Room requests and broadcasts of a CollabServer.
+ *
+ * Used by whatever thread owns the rooms: the network thread (See Server) or
+ * a room worker (See RoomShard). Only the sink of the responses and
+ * broadcasts differs (See RoomSink).
+ *
+ * Handles MsgCreaDataRequest, MsgJoinDataRequest, MsgLeaveDataRequest,
+ * MsgRoomOperation, MsgRoomSnapshot, MsgRoomResumeRequest and
+ * MsgRoomHistoryRequest. Room broadcasts may be delayed by the window (See
+ * BroadcastWindow). Committed operations may be kept encoded for the
+ * catch-ups of the next joining users (See CatchUpBundle). With echo
+ * suppression, they are published to the other users of the room only
+ * (Encoded once), and their sender gets a MsgRoomOperationAck.
+ *
+ * Rooms persisted before a restart, or unloaded by hibernation (See
+ * hibernateIdleRooms), are restored by the first join request they receive.
+ * Storage is enabled by the owner (See getCollabServer).
+ */
+class RoomHandler : public Broadcaster {
+   private:
+    RoomSink& _sink;
+    CollabServer _collabserver;
+    BroadcastWindow _window;
+    const bool _sequenceNumbers;
+    const bool _echoSuppression;        // Senders acknowledged with a MsgRoomOperationAck
+    const std::size_t _bundleMaxBytes;  // Max bytes of each CatchUpBundle (0: no bundle)
+    bool _isCopyingUsers = false;       // Users are copies, only kept while in a room (See setUserCopies)
+    // Operations of each room kept encoded (RoomID -> Bundle)
+    std::unordered_map<unsigned int, std::unique_ptr<CatchUpBundle>> _bundles;
+
+   public:
+    /**
+     * Create a new handler with no room.
+     *
+     * \param sink Where to send the responses and broadcasts.
+     * \param config Settings of the rooms (Storage excepted).
+     */
+    RoomHandler(RoomSink& sink, const RoomShardConfig& config);
+
+    RoomHandler(const RoomHandler& other) = delete;
+    RoomHandler& operator=(const RoomHandler& other) = delete;
+
+   public:
+    /**
+     * Rooms and users handled.
+     *
+     * \return Reference to the CollabServer.
+     */
+    CollabServer& getCollabServer() { return _collabserver; }
+    const CollabServer& getCollabServer() const { return _collabserver; }
+
+    /**
+     * Users are copies of the ones of the network thread (Same ID). A copy is
+     * registered when it creates or joins a room, and deleted when it leaves.
+     *
+     * \param isCopyingUsers If true, users are copies.
+     */
+    void setUserCopies(const bool isCopyingUsers) { _isCopyingUsers = isCopyingUsers; }
+
+    /**
+     * Handle a room request. The response is sent to the sink.
+     *
+     * \param msg Request to handle.
+     * \param roomID ID of the room to create (MsgCreaDataRequest only, 0: next free ID).
+     * \return True if handled, false if not a room request.
+     */
+    bool handleMessage(const Message& msg, const unsigned int roomID = 0);
+
+    /**
+     * Publish delayed room broadcasts.
+     *
+     * \param isIdle If true, publish all of them (no request is waiting),
+     *               otherwise, only the expired ones.
+     */
+    void flushBroadcasts(const bool isIdle);
+
+    /**
+     * Check whether some room broadcasts are delayed.
+     *
+     * \return True if broadcasts are pending, otherwise, return false.
+     */
+    bool hasPendingBroadcasts() const { return !_window.isEmpty(); }
+
+    /**
+     * Unload the rooms empty for too long (See
+     * CollabServer::hibernateIdleRooms).
+     *
+     * \return Number of rooms unloaded.
+     */
+    std::size_t hibernateIdleRooms();
+
+   private:
+    void handleMessage(const MsgCreaDataRequest& msg, const unsigned int roomID);
+    void handleMessage(const MsgJoinDataRequest& msg);
+    void handleMessage(const MsgLeaveDataRequest& msg);
+    void handleMessage(const MsgRoomOperation& msg);
+    void handleMessage(const MsgRoomSnapshot& msg);
+    void handleMessage(const MsgRoomResumeRequest& msg);
+    void handleMessage(const MsgRoomHistoryRequest& msg);
+    void joinRoom(const unsigned int userID, const unsigned int roomID, const std::size_t lastSequence);
+
+   private:
+    void sendOperationToUser(const OperationInfo& op, unsigned int id) override;
+    void broadcastOperationToRoom(const OperationInfo& op, unsigned int id) override;
+    void broadcastOperationToOthers(const OperationInfo& op, const std::unordered_set<unsigned int>& userIDs,
+                                    unsigned int id) override;
+    void sendSnapshotToUser(const SnapshotInfo& snapshot, unsigned int id) override;
+    bool sendOperationsToUser(unsigned int roomID, std::size_t first, std::size_t last, unsigned int id) override;
+    void sendOperationToStream(const OperationInfo& op, unsigned int id) override;
+    void sendSnapshotToStream(const SnapshotInfo& snapshot, unsigned int id) override;
+    bool sendOperationsToStream(std::size_t first, std::size_t last, unsigned int id) override;
+    void sendCatchUpDoneToUser(unsigned int roomID, std::size_t end, unsigned int id) override;
+    void sendCatchUpDoneToStream(unsigned int userID, std::size_t end, unsigned int id) override;
+    void keepEncoded(const OperationInfo& op, unsigned int id);
+    bool publishEncoded(const std::string& topic, unsigned int roomID, std::size_t first, std::size_t last);
+    void publishOperation(const std::string& topic, const OperationInfo& op);
+    bool encodeOperation(const OperationInfo& op, std::string& frame) const;
+    void publishRoomOperations(const unsigned int roomID, std::vector<OperationInfo>& operations);
+};
+
+}  // namespace collabserver
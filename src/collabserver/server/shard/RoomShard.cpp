@@ -0,0 +1,105 @@
+#include "collabserver/server/shard/RoomShard.h"
+
+#include <cassert>
+#include <utility>  // std::move
+
+#include "collabserver/network/messaging/MessageFactory.h"
+#include "collabserver/server/network/MessageCodec.h"
+#include "collabserver/server/network/MsgRoomOperationAck.h"
+#include "collabserver/server/utils/Log.h"
+
+namespace collabserver {
+
+RoomShard::RoomShard(const unsigned int index, Outbox& broadcasts, const RoomShardConfig& config)
+    : _index(index),
+      _handler(*this, config),
+      _collabserver(_handler.getCollabServer()),
+      _broadcasts(broadcasts),
+      _echoSuppression(config.echoSuppression) {
+    _handler.setUserCopies(true);
+    if (!config.storageDir.empty()) {
+        _collabserver.enableStorage(config.storageDir, config.durability);
+    }
+}
+
+void RoomShard::process(ShardRequest& request) {
+    assert(request.msg != nullptr);
+    _responses = request.outbox;
+    _currentClient = request.client;
+    if (!_handler.handleMessage(*request.msg, request.roomID)) {
+        LOG << "(Shard=" << _index << "): Unexpected msg (TypeID=" << request.msg->getType() << ")\n";
+    }
+    MessageCodec::freeMessage(request.msg);
+    request.msg = nullptr;
+    _responses = nullptr;
+}
+
+void RoomShard::continueCatchUps(const std::size_t maxOps) {
+    if (!_collabserver.hasPendingCatchUps()) {
+        return;  // Only logged once, when done
+    }
+    _collabserver.continueCatchUps(maxOps);
+    if (!_collabserver.hasPendingCatchUps()) {
+        const HistoryStats stats = _collabserver.getHistoryStats();
+        LOG << "(Shard=" << _index << "): Catch-ups done. History reads: " << stats.hotReads << " from memory, "
+            << stats.encodedReads << " already encoded, " << stats.coldReads << " from files (hit rate "
+            << stats.getHitRate() * 100 << "%), " << stats.sharedReads << " saved by shared catch-ups, "
+            << stats.dropped << " operations dropped by coalescing\n";
+    }
+}
+
+void RoomShard::hibernateIdleRooms() {
+    const std::size_t count = _handler.hibernateIdleRooms();
+    if (count > 0) {
+        LOG << "(Shard=" << _index << "): " << count << " idle room(s) unloaded, " << _collabserver.getNbRooms()
+            << " still loaded\n";
+    }
+}
+
+void RoomShard::flushBroadcasts(const bool isIdle) { _handler.flushBroadcasts(isIdle); }
+
+void RoomShard::syncOperations() {
+    if (!this->hasPendingSync()) {
+        return;
+    }
+    const bool isSynced = _collabserver.syncRooms();
+    if (_pendingAcks.empty()) {
+        return;
+    }
+
+    MessageFactory& factory = MessageFactory::getInstance();
+    Message* response = factory.newMessage(isSynced ? MessageFactory::MSG_EMPTY : MessageFactory::MSG_ERROR);
+    for (const PendingAck& ack : _pendingAcks) {
+        if (isSynced && _echoSuppression) {
+            ack.outbox->sendResponse(ack.client, MsgRoomOperationAck(ack.roomID, ack.sequence));
+        } else {
+            ack.outbox->sendResponse(ack.client, *response);
+        }
+    }
+    factory.freeMessage(response);
+    _pendingAcks.clear();
+}
+
+// -----------------------------------------------------------------------------
+// RoomSink methods
+// -----------------------------------------------------------------------------
+
+void RoomShard::sendResponse(const Message& msg) {
+    if (_responses != nullptr && !_currentClient.empty()) {
+        _responses->sendResponse(_currentClient, msg);
+    }
+}
+
+void RoomShard::publish(const std::string& topic, const Message& msg) { _broadcasts.sendBroadcast(topic, msg); }
+
+void RoomShard::publishFrame(const std::string& topic, std::string frame) {
+    _broadcasts.sendBroadcastFrame(topic, std::move(frame));
+}
+
+void RoomShard::deferAck(const unsigned int roomID, const std::size_t sequence) {
+    if (_responses != nullptr && !_currentClient.empty()) {
+        _pendingAcks.push_back({_responses, _currentClient, roomID, sequence});  // See syncOperations
+    }
+}
+
+}  // namespace collabserver
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+#include <vector>
+
+#include "collabserver/network/messaging/Message.h"
+#include "collabserver/server/network/Outbox.h"
+#include "collabserver/server/room/CollabServer.h"
+#include "collabserver/server/shard/RoomHandler.h"
+#include "collabserver/server/shard/RoomSink.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Request handed over by the network thread to a RoomShard.
+ */
+struct ShardRequest {
+    std::string client;        // Identity of the client to respond to (Empty: no response)
+    Outbox* outbox = nullptr;  // Where to send the response (Outbox of the plane that received it)
+    Message* msg = nullptr;    // Owned by the shard once posted (nullptr: stop the worker)
+    unsigned int roomID = 0;   // Room ID allocated by the network thread (MsgCreaDataRequest only)
+};
+
+/**
+ * \brief
+ * Partition of the rooms.
+ *
+ * A shard owns a private CollabServer with the rooms it is responsible for.
+ * Users are created by the network thread. The shard only keeps a copy of the
+ * users currently in one of its rooms (Same ID).
+ *
+ * Room requests are handled by a RoomHandler, like on the network thread.
+ * Responses are sent through the outbox given by the request, broadcasts
+ * through the outbox of the publishing network thread. Room broadcasts may
+ * be delayed by the shard window (See BroadcastWindow).
+ *
+ * With storage, rooms persisted before a restart are restored by the first
+ * join request they receive. So are the idle rooms unloaded by hibernation
+ * (See hibernateIdleRooms), with or without storage. Operations are synced
+ * by groups (See syncOperations). With GROUP_SYNC durability, they are
+ * acknowledged then.
+ *
+ * A shard has no thread on its own, requests must be processed by one thread
+ * at a time (See ShardWorker and RoomStrand).
+ */
+class RoomShard : public RoomSink {
+   private:
+    struct PendingAck {
+        Outbox* outbox;
+        std::string client;
+        unsigned int roomID;
+        std::size_t sequence;  // Sequence number of the operation
+    };
+
+   private:
+    const unsigned int _index;
+    RoomHandler _handler;
+    CollabServer& _collabserver;  // Rooms of _handler
+    Outbox& _broadcasts;
+    const bool _echoSuppression;           // Senders acknowledged with a MsgRoomOperationAck
+    Outbox* _responses = nullptr;          // Outbox of the current request
+    std::string _currentClient;
+    std::vector<PendingAck> _pendingAcks;  // Operations acknowledged once synced
+
+   public:
+    /**
+     * Create a new empty shard.
+     *
+     * \param index Index of the shard (For logs).
+     * \param broadcasts Outbox where to publish room operations.
+     * \param config Settings of the room workers.
+     */
+    RoomShard(const unsigned int index, Outbox& broadcasts, const RoomShardConfig& config);
+
+    RoomShard(const RoomShard& other) = delete;
+    RoomShard& operator=(const RoomShard& other) = delete;
+
+   public:
+    /**
+     * Process a request and free its message.
+     *
+     * \param request Request to process.
+     */
+    void process(ShardRequest& request);
+
+    /**
+     * Send the next slice of history to joining users (See
+     * CollabServer::continueCatchUps).
+     *
+     * \param maxOps Max number of operations to send.
+     */
+    void continueCatchUps(const std::size_t maxOps);
+
+    /**
+     * Check whether some joining users didn't receive the whole history yet.
+     *
+     * \return True if catch-up is pending, otherwise, return false.
+     */
+    bool hasPendingCatchUps() const { return _collabserver.hasPendingCatchUps(); }
+
+    /**
+     * Drop the next superseded operations from the room histories (See
+     * CollabServer::continueCoalescing).
+     *
+     * \param maxOps Max number of operations to scan.
+     */
+    void continueCoalescing(const std::size_t maxOps) { _collabserver.continueCoalescing(maxOps); }
+
+    /**
+     * Check whether some committed operations were not coalesced yet.
+     *
+     * \return True if coalescing is pending, otherwise, return false.
+     */
+    bool hasPendingCoalescing() const { return _collabserver.hasPendingCoalescing(); }
+
+    /**
+     * Unload the rooms empty for too long (See
+     * CollabServer::hibernateIdleRooms).
+     */
+    void hibernateIdleRooms();
+
+    /**
+     * Check whether some rooms may be unloaded later (Hibernation enabled
+     * and rooms loaded).
+     *
+     * \return True if has candidates, otherwise, return false.
+     */
+    bool canHibernate() const { return _collabserver.hasHibernation() && _collabserver.getNbRooms() > 0; }
+
+    /**
+     * Take over a room unloaded by another shard (See
+     * CollabServer::adoptHibernatedRoom).
+     *
+     * \param roomID ID of the unloaded room.
+     */
+    void adoptHibernatedRoom(const unsigned int roomID) { _collabserver.adoptHibernatedRoom(roomID); }
+
+    /**
+     * Publish delayed room broadcasts.
+     *
+     * \param isIdle If true, publish all of them (no request is waiting),
+     *               otherwise, only the expired ones.
+     */
+    void flushBroadcasts(const bool isIdle);
+
+    /**
+     * Check whether some room broadcasts are delayed.
+     *
+     * \return True if broadcasts are pending, otherwise, return false.
+     */
+    bool hasPendingBroadcasts() const { return _handler.hasPendingBroadcasts(); }
+
+    /**
+     * Sync the operations committed since the previous call (one sync for
+     * all of them) and send the acknowledgements waiting for it.
+     * Must be called after each group of requests.
+     */
+    void syncOperations();
+
+    /**
+     * Check whether some operations were committed since the previous
+     * syncOperations.
+     *
+     * \return True if sync is pending, otherwise, return false.
+     */
+    bool hasPendingSync() const { return _collabserver.hasUnsyncedRooms() || !_pendingAcks.empty(); }
+
+   private:
+    void sendResponse(const Message& msg) override;
+    void publish(const std::string& topic, const Message& msg) override;
+    void publishFrame(const std::string& topic, std::string frame) override;
+    bool isGroupCommit() const override { return true; }  // See syncOperations
+    void deferAck(const unsigned int roomID, const std::size_t sequence) override;
+};
+
+}  // namespace collabserver
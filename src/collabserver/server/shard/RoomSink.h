@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+
+#include "collabserver/network/messaging/Message.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Where a RoomHandler sends its responses and publishes its room messages.
+ *
+ * Implemented by the thread that owns the rooms: the network thread (REP
+ * socket, router plane or batch) or a room worker (outboxes).
+ */
+class RoomSink {
+   protected:
+    RoomSink() = default;
+    RoomSink(const RoomSink& other) = default;
+    RoomSink& operator=(const RoomSink& other) = default;
+
+   public:
+    virtual ~RoomSink() = default;
+
+   public:
+    /**
+     * Send a response to the client of the current request.
+     *
+     * \param msg Message to send.
+     */
+    virtual void sendResponse(const Message& msg) = 0;
+
+    /**
+     * Publish a message on a topic.
+     *
+     * \param topic Topic to publish on (See Topic).
+     * \param msg Message to publish.
+     */
+    virtual void publish(const std::string& topic, const Message& msg) = 0;
+
+    /**
+     * Publish an already encoded message on a topic (See MessageCodec::encode).
+     *
+     * \param topic Topic to publish on (See Topic).
+     * \param frame Encoded message.
+     */
+    virtual void publishFrame(const std::string& topic, std::string frame) = 0;
+
+    /**
+     * Check whether the operations committed by the current request are
+     * synced later, with the next ones (Group commit). Otherwise, they are
+     * synced right away.
+     *
+     * \return True if synced later, otherwise, return false.
+     */
+    virtual bool isGroupCommit() const = 0;
+
+    /**
+     * Acknowledge a committed operation of the current request once synced
+     * (Group commit with GROUP_SYNC durability).
+     *
+     * \param roomID ID of the room of the operation.
+     * \param sequence Sequence number of the operation.
+     */
+    virtual void deferAck(const unsigned int roomID, const std::size_t sequence) = 0;
+};
+
+}  // namespace collabserver
@@ -0,0 +1,62 @@
+#include "collabserver/server/shard/RoomStrand.h"
+
+#include "collabserver/server/utils/constants.h"
+
+namespace collabserver {
+
+RoomStrand::RoomStrand(const unsigned int roomID, TaskScheduler& scheduler, Outbox& broadcasts,
+                       const std::size_t capacity, const bool isHibernated, const RoomShardConfig& config)
+    : _shard(roomID, broadcasts, config), _strand(scheduler), _capacity(capacity) {
+    if (isHibernated) {
+        _shard.adoptHibernatedRoom(roomID);
+    }
+}
+
+bool RoomStrand::tryPost(ShardRequest& request) {
+    if (_nbPending.load() >= _capacity) {
+        return false;
+    }
+    this->post(request);
+    return true;
+}
+
+void RoomStrand::post(ShardRequest request) {
+    _nbPending.fetch_add(1);
+    _strand.post([this, request]() mutable {
+        _nbPending.fetch_sub(1);
+        _shard.process(request);
+        _shard.flushBroadcasts(false);
+        _canHibernate.store(_shard.canHibernate());
+        this->postIdleTask();
+    });
+}
+
+void RoomStrand::hibernateIdleRoom() {
+    _strand.post([this]() {
+        _shard.hibernateIdleRooms();
+        _canHibernate.store(_shard.canHibernate());
+    });
+}
+
+bool RoomStrand::isUnloaded() {
+    // DevNote: idle first, the flag is then the one stored by the last task.
+    return _strand.isIdle() && !_canHibernate.load();
+}
+
+void RoomStrand::postIdleTask() {
+    if (_isIdleTaskPosted || (!_shard.hasPendingCatchUps() && !_shard.hasPendingBroadcasts() &&
+                              !_shard.hasPendingSync() && !_shard.hasPendingCoalescing())) {
+        return;
+    }
+    _isIdleTaskPosted = true;
+    _strand.post([this]() {
+        _isIdleTaskPosted = false;
+        _shard.syncOperations();  // Requests posted meanwhile share the sync
+        _shard.flushBroadcasts(true);
+        _shard.continueCatchUps(COLLAB_CATCH_UP_SLICE_SIZE);
+        _shard.continueCoalescing(COLLAB_COALESCING_SLICE_SIZE);
+        this->postIdleTask();
+    });
+}
+
+}  // namespace collabserver
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>  // std::size_t
+
+#include "collabserver/server/network/Outbox.h"
+#include "collabserver/server/scheduler/Strand.h"
+#include "collabserver/server/scheduler/TaskScheduler.h"
+#include "collabserver/server/shard/RoomShard.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * One room and its serialized stream of pending work, run by a TaskScheduler.
+ *
+ * All requests for the room (commits, joins with their catch-up, leaves) are
+ * processed in order, one at a time, by whatever worker runs the strand.
+ * Idle workers may steal a busy room, so load is not bound to a fixed
+ * partition of rooms.
+ *
+ * Background work of the room (history of joining users sent by slices,
+ * delayed broadcasts, sync of the committed operations) is done by an idle
+ * task, queued after the pending requests of the strand. A strand has no
+ * timer: idle rooms are unloaded when asked (See hibernateIdleRoom). Once its
+ * room is unloaded and no work is pending, the strand may be destroyed (See
+ * isUnloaded), a new one restores the room.
+ *
+ * Pending requests are bounded (See tryPost), like the mailbox of a
+ * ShardWorker.
+ */
+class RoomStrand {
+   private:
+    RoomShard _shard;
+    Strand _strand;
+    const std::size_t _capacity;
+    std::atomic<std::size_t> _nbPending{0};  // Requests posted, not processed yet
+    std::atomic<bool> _canHibernate{false};  // Room loaded (Updated by the strand)
+    bool _isIdleTaskPosted = false;          // Accessed from the strand only
+
+   public:
+    /**
+     * Create a new room stream.
+     *
+     * \param roomID ID of the room.
+     * \param scheduler Scheduler that runs the requests.
+     * \param broadcasts Outbox where to publish room operations.
+     * \param capacity Max number of pending requests (See tryPost).
+     * \param isHibernated If true, room was unloaded by a previous strand.
+     * \param config Settings of the room workers.
+     */
+    RoomStrand(const unsigned int roomID, TaskScheduler& scheduler, Outbox& broadcasts, const std::size_t capacity,
+               const bool isHibernated, const RoomShardConfig& config);
+
+    RoomStrand(const RoomStrand& other) = delete;
+    RoomStrand& operator=(const RoomStrand& other) = delete;
+
+   public:
+    /**
+     * Hand a request over to this room. Thread safe.
+     * The room takes the ownership of the message if successfully posted.
+     *
+     * \param request Request to process.
+     * \return True if posted, false if the room has too many pending requests.
+     */
+    bool tryPost(ShardRequest& request);
+
+    /**
+     * Hand a request over to this room, even if it has too many pending
+     * requests. Thread safe. Takes the ownership of the message.
+     *
+     * \param request Request to process.
+     */
+    void post(ShardRequest request);
+
+    /**
+     * Unload the room if empty for too long (See
+     * RoomShard::hibernateIdleRooms). Thread safe: done by the strand.
+     */
+    void hibernateIdleRoom();
+
+    /**
+     * Check whether the room is loaded (Hibernation enabled), and therefore
+     * worth asking to hibernate. Thread safe.
+     *
+     * \return True if loaded, otherwise, return false.
+     */
+    bool canHibernate() const { return _canHibernate.load(); }
+
+    /**
+     * Check whether the room is not loaded and no task is pending, so that
+     * this strand may be destroyed. Thread safe.
+     * Only meaningful if nothing posts to the strand meanwhile.
+     *
+     * \return True if unloaded, otherwise, return false.
+     */
+    bool isUnloaded();
+
+   private:
+    void postIdleTask();
+};
+
+}  // namespace collabserver
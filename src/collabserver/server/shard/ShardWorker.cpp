@@ -0,0 +1,76 @@
+#include "collabserver/server/shard/ShardWorker.h"
+
+#include <cassert>
+#include <utility>  // std::move
+
+#include "collabserver/server/utils/Log.h"
+#include "collabserver/server/utils/constants.h"
+
+namespace collabserver {
+
+// Max number of requests taken from the mailbox at once.
+static const std::size_t local_batchSize = 64;
+
+ShardWorker::ShardWorker(const unsigned int index, Outbox& broadcasts, const std::size_t capacity,
+                         const RoomShardConfig& config)
+    : _shard(index, broadcasts, config), _inbox(capacity) {}
+
+ShardWorker::~ShardWorker() { this->stop(); }
+
+void ShardWorker::start() {
+    assert(!_thread.joinable());
+    _thread = std::thread(&ShardWorker::run, this);
+}
+
+void ShardWorker::stop() {
+    if (_thread.joinable()) {
+        this->post(ShardRequest());
+        _thread.join();
+    }
+}
+
+bool ShardWorker::tryPost(ShardRequest& request) { return _inbox.tryPush(request); }
+
+void ShardWorker::post(ShardRequest request) { _inbox.push(std::move(request)); }
+
+void ShardWorker::run() {
+    LOG << "Shard worker started\n";
+
+    ShardRequest batch[local_batchSize];
+    bool isRunning = true;
+    while (isRunning) {
+        // DevNote: pending history is sent by slices between batches, never
+        // wait for requests meanwhile. Delayed broadcasts are all published
+        // as soon as no request is waiting. Coalescing only when idle. Wait
+        // is bounded while some rooms may be unloaded.
+        std::size_t count = 0;
+        if (_shard.hasPendingCatchUps() || _shard.hasPendingBroadcasts() || _shard.hasPendingCoalescing()) {
+            _shard.continueCatchUps(COLLAB_CATCH_UP_SLICE_SIZE);
+            count = _inbox.tryPopBatch(batch, local_batchSize);
+            if (count == 0) {
+                _shard.flushBroadcasts(true);
+                _shard.continueCoalescing(COLLAB_COALESCING_SLICE_SIZE);
+            }
+        } else if (_shard.canHibernate()) {
+            count = _inbox.waitBatch(batch, local_batchSize, COLLAB_HIBERNATION_CHECK_MS);
+        } else {
+            count = _inbox.waitBatch(batch, local_batchSize);
+        }
+        for (std::size_t k = 0; k < count; ++k) {
+            if (batch[k].msg == nullptr) {
+                isRunning = false;  // Stop requests are always the last ones
+                continue;
+            }
+            _shard.process(batch[k]);
+        }
+        _shard.syncOperations();  // One sync for the whole batch
+        _shard.flushBroadcasts(false);
+        _shard.hibernateIdleRooms();
+    }
+    _shard.syncOperations();
+    _shard.flushBroadcasts(true);
+
+    LOG << "Shard worker stopped\n";
+}
+
+}  // namespace collabserver
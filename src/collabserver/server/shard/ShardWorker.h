@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <thread>
+
+#include "collabserver/server/network/Outbox.h"
+#include "collabserver/server/shard/RoomShard.h"
+#include "collabserver/server/utils/Mailbox.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Worker thread dedicated to one RoomShard.
+ *
+ * Requests are received through a lock-free bounded mailbox (processed by
+ * batch).
+ */
+class ShardWorker {
+   private:
+    RoomShard _shard;
+    Mailbox<ShardRequest> _inbox;
+    std::thread _thread;
+
+   public:
+    /**
+     * Create a new worker. Thread is not started yet.
+     *
+     * \param index Index of the shard (For logs).
+     * \param broadcasts Outbox where to publish room operations.
+     * \param capacity Max number of pending requests.
+     * \param config Settings of the room workers.
+     */
+    ShardWorker(const unsigned int index, Outbox& broadcasts, const std::size_t capacity,
+                const RoomShardConfig& config);
+
+    /**
+     * Stop the worker thread (if running).
+     */
+    ~ShardWorker();
+
+    ShardWorker(const ShardWorker& other) = delete;
+    ShardWorker& operator=(const ShardWorker& other) = delete;
+
+   public:
+    /**
+     * Start the worker thread.
+     */
+    void start();
+
+    /**
+     * Stop the worker thread once all pending requests are processed.
+     * Block until stopped.
+     */
+    void stop();
+
+    /**
+     * Hand a request over to this worker. Thread safe.
+     * The worker takes the ownership of the message if successfully posted.
+     *
+     * \param request Request to process.
+     * \return True if posted, false if the worker has too many pending requests.
+     */
+    bool tryPost(ShardRequest& request);
+
+    /**
+     * Hand a request over to this worker, wait if the worker is full.
+     * Thread safe. The worker takes the ownership of the message.
+     *
+     * \param request Request to process.
+     */
+    void post(ShardRequest request);
+
+   private:
+    void run();
+};
+
+}  // namespace collabserver
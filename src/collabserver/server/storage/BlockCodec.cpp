@@ -0,0 +1,146 @@
+#include "collabserver/server/storage/BlockCodec.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace collabserver {
+
+static const std::size_t local_minMatch = 4;
+static const std::size_t local_maxOffset = 65535;
+static const std::size_t local_hashBits = 12;
+static const uint32_t local_noPosition = UINT32_MAX;
+
+static uint32_t local_read32(const char* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));  // Only hashed and compared, byte order doesn't matter
+    return value;
+}
+
+static std::size_t local_hash(const uint32_t sequence) {
+    return static_cast<std::size_t>((sequence * 2654435761u) >> (32 - local_hashBits));
+}
+
+static void local_writeLength(std::string& out, std::size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+static bool local_readLength(const unsigned char*& in, const unsigned char* end, std::size_t& length) {
+    unsigned char byte = 255;
+    while (byte == 255) {
+        if (in == end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    }
+    return true;
+}
+
+static void local_writeSequence(std::string& out, const char* literals, const std::size_t nbLiterals,
+                                const std::size_t offset, const std::size_t matchLength) {
+    const std::size_t tokenLiterals = nbLiterals < 15 ? nbLiterals : 15;
+    std::size_t tokenMatch = 0;  // Last sequence has no match
+    if (matchLength > 0) {
+        tokenMatch = (matchLength - local_minMatch < 15) ? matchLength - local_minMatch : 15;
+    }
+    out.push_back(static_cast<char>((tokenLiterals << 4) | tokenMatch));
+    if (tokenLiterals == 15) {
+        local_writeLength(out, nbLiterals - 15);
+    }
+    out.append(literals, nbLiterals);
+    if (matchLength == 0) {
+        return;  // Last sequence
+    }
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>((offset >> 8) & 0xff));
+    if (tokenMatch == 15) {
+        local_writeLength(out, matchLength - local_minMatch - 15);
+    }
+}
+
+void BlockCodec::compress(const char* data, const std::size_t size, std::string& out) {
+    out.clear();
+    out.reserve(4 + size + size / 255 + 16);  // Worst case: literals only
+    for (std::size_t k = 0; k < 4; ++k) {
+        out.push_back(static_cast<char>((size >> (8 * k)) & 0xff));
+    }
+
+    // DevNote: greedy parsing with a single candidate per hash (last
+    // position seen), as LZ4 fast mode.
+    std::vector<uint32_t> table(std::size_t(1) << local_hashBits, local_noPosition);
+    std::size_t anchor = 0;
+    std::size_t position = 0;
+    while (position + local_minMatch <= size) {
+        const uint32_t sequence = local_read32(data + position);
+        uint32_t& entry = table[local_hash(sequence)];
+        const std::size_t candidate = entry;
+        entry = static_cast<uint32_t>(position);
+        if (candidate == local_noPosition || position - candidate > local_maxOffset ||
+            local_read32(data + candidate) != sequence) {
+            ++position;
+            continue;
+        }
+        std::size_t length = local_minMatch;
+        while (position + length < size && data[candidate + length] == data[position + length]) {
+            ++length;
+        }
+        local_writeSequence(out, data + anchor, position - anchor, position - candidate, length);
+        position += length;
+        anchor = position;
+    }
+    local_writeSequence(out, data + anchor, size - anchor, 0, 0);
+}
+
+bool BlockCodec::decompress(const char* data, const std::size_t size, std::string& out) {
+    if (size < 4) {
+        return false;
+    }
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = in + size;
+    const std::size_t expectedSize = static_cast<std::size_t>(in[0]) | (static_cast<std::size_t>(in[1]) << 8) |
+                                     (static_cast<std::size_t>(in[2]) << 16) | (static_cast<std::size_t>(in[3]) << 24);
+    in += 4;
+    out.resize(expectedSize);
+    std::size_t written = 0;
+    while (in < end) {
+        const unsigned char token = *in++;
+        std::size_t nbLiterals = token >> 4;
+        if (nbLiterals == 15 && !local_readLength(in, end, nbLiterals)) {
+            return false;
+        }
+        if (nbLiterals > static_cast<std::size_t>(end - in) || nbLiterals > expectedSize - written) {
+            return false;
+        }
+        std::memcpy(&out[0] + written, in, nbLiterals);
+        in += nbLiterals;
+        written += nbLiterals;
+        if (in == end) {
+            break;  // Last sequence
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        const std::size_t offset = static_cast<std::size_t>(in[0]) | (static_cast<std::size_t>(in[1]) << 8);
+        in += 2;
+        std::size_t matchLength = (token & 0x0f) + local_minMatch;
+        if ((token & 0x0f) == 15 && !local_readLength(in, end, matchLength)) {
+            return false;
+        }
+        if (offset == 0 || offset > written || matchLength > expectedSize - written) {
+            return false;
+        }
+        // Byte by byte: match may overlap the bytes it writes (repetitions)
+        for (std::size_t k = 0; k < matchLength; ++k, ++written) {
+            out[written] = out[written - offset];
+        }
+    }
+    return written == expectedSize;
+}
+
+}  // namespace collabserver
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Fast LZ77 compression of a block of bytes (LZ4-like format).
+ *
+ * Meant for blocks of serialized operations: speed first, ratio second.
+ * Decompression is checked, a corrupted block fails instead of reading or
+ * writing out of bounds.
+ *
+ * \par Layout
+ *  - Decompressed size (u32, little endian)
+ *  - Sequences. Each one is:
+ *    - token (u8): literals length (high 4 bits), match length - 4 (low 4 bits)
+ *    - literals length - 15, if 15 in token (bytes of 255, then the rest)
+ *    - literals
+ *    - match offset (u16, little endian, 1 to 65535 bytes back)
+ *    - match length - 19, if 15 in token (bytes of 255, then the rest)
+ *  - Last sequence has literals only (Ends the block).
+ */
+class BlockCodec {
+   public:
+    /**
+     * Compress a block.
+     *
+     * \param data Bytes to compress.
+     * \param size Number of bytes (Less than 4 GiB).
+     * \param out Set to the compressed block.
+     */
+    static void compress(const char* data, const std::size_t size, std::string& out);
+
+    /**
+     * Decompress a block.
+     *
+     * \param data Compressed block.
+     * \param size Size of the compressed block.
+     * \param out Set to the decompressed bytes.
+     * \return True if succeed, otherwise, return false (Corrupted block).
+     */
+    static bool decompress(const char* data, const std::size_t size, std::string& out);
+};
+
+}  // namespace collabserver
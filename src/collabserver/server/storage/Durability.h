@@ -0,0 +1,23 @@
+#pragma once
+
+namespace collabserver {
+
+/**
+ * \brief
+ * How far committed operations are persisted before being acknowledged.
+ *
+ * Records are written in shared file mappings: a crash of the server never
+ * loses them, only a crash of the OS (or power loss) may.
+ *
+ * Only the acknowledgment to the sender waits for the sync: operations are
+ * broadcasted to the other users of the room as soon as committed. After a
+ * crash of the OS, these users may hold operations missing from the restored
+ * history (Clients must not assume their state matches it).
+ */
+enum class Durability {
+    NONE,       // Records are written back whenever the OS decides
+    ASYNC,      // Writeback is started after each group of commits (Not waited for)
+    GROUP_SYNC  // Acknowledged once on disk (Broadcasted before). One flush per group of commits.
+};
+
+}  // namespace collabserver
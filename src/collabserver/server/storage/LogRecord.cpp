@@ -0,0 +1,68 @@
+#include "collabserver/server/storage/LogRecord.h"
+
+#include <cstring>
+
+namespace collabserver {
+
+const std::size_t LogRecord::HEADER_SIZE;
+
+static void local_writeU32(char* out, const uint32_t value) {
+    out[0] = static_cast<char>(value & 0xff);
+    out[1] = static_cast<char>((value >> 8) & 0xff);
+    out[2] = static_cast<char>((value >> 16) & 0xff);
+    out[3] = static_cast<char>((value >> 24) & 0xff);
+}
+
+static uint32_t local_readU32(const char* data) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+static uint32_t local_checksum(const char* header, const char* buffer, const std::size_t size) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (std::size_t k = 0; k < 16; ++k) {
+        hash = (hash ^ static_cast<unsigned char>(header[k])) * 16777619u;
+    }
+    for (std::size_t k = 0; k < size; ++k) {
+        hash = (hash ^ static_cast<unsigned char>(buffer[k])) * 16777619u;
+    }
+    return hash;
+}
+
+void LogRecord::encode(const OperationInfo& op, char* out) {
+    local_writeU32(out, static_cast<uint32_t>(op.buffer.size()));
+    local_writeU32(out + 4, op.roomID);
+    local_writeU32(out + 8, op.userID);
+    local_writeU32(out + 12, op.opTypeID);
+    std::memcpy(out + HEADER_SIZE, op.buffer.data(), op.buffer.size());
+    local_writeU32(out + 16, local_checksum(out, out + HEADER_SIZE, op.buffer.size()));
+}
+
+bool LogRecord::decode(const char* data, const std::size_t available, LogRecord& record, std::size_t& recordSize) {
+    if (available < HEADER_SIZE) {
+        return false;
+    }
+    const std::size_t bufferSize = local_readU32(data);
+    if (bufferSize > available - HEADER_SIZE) {
+        return false;
+    }
+    if (local_readU32(data + 16) != local_checksum(data, data + HEADER_SIZE, bufferSize)) {
+        return false;
+    }
+    record = LogRecord::read(data);
+    recordSize = HEADER_SIZE + bufferSize;
+    return true;
+}
+
+LogRecord LogRecord::read(const char* data) {
+    LogRecord record;
+    record.bufferSize = local_readU32(data);
+    record.roomID = local_readU32(data + 4);
+    record.userID = local_readU32(data + 8);
+    record.opTypeID = local_readU32(data + 12);
+    record.buffer = data + HEADER_SIZE;
+    return record;
+}
+
+}  // namespace collabserver
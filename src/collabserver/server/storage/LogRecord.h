@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+
+#include "collabserver/server/room/OperationInfo.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * One operation stored in a log file (See LogSegment).
+ *
+ * A decoded record points into the file mapping, the buffer is not copied.
+ *
+ * \par Layout (little endian)
+ *  - bufferSize (u32)
+ *  - roomID (u32)
+ *  - userID (u32)
+ *  - opTypeID (u32)
+ *  - checksum (u32, FNV-1a of the four fields above and the buffer)
+ *  - buffer (bufferSize bytes)
+ *
+ * A torn or never written record fails the checksum, which marks the end of
+ * the log.
+ */
+struct LogRecord {
+    static const std::size_t HEADER_SIZE = 20;
+
+    unsigned int roomID = 0;
+    unsigned int userID = 0;
+    unsigned int opTypeID = 0;
+    const char* buffer = nullptr;  // Points into the encoded data
+    std::size_t bufferSize = 0;
+
+    /**
+     * Size of the encoded record of an operation.
+     *
+     * \param op Operation to encode.
+     * \return Size in bytes.
+     */
+    static std::size_t getEncodedSize(const OperationInfo& op) { return HEADER_SIZE + op.buffer.size(); }
+
+    /**
+     * Encode an operation.
+     *
+     * \param op Operation to encode.
+     * \param out Where to write (At least getEncodedSize(op) bytes).
+     */
+    static void encode(const OperationInfo& op, char* out);
+
+    /**
+     * Decode the record at the given position.
+     *
+     * \param data Encoded record.
+     * \param available Number of readable bytes from data.
+     * \param record Set with the decoded record (Points into data).
+     * \param recordSize Set with the size of the encoded record.
+     * \return True if a valid record was decoded, otherwise, return false.
+     */
+    static bool decode(const char* data, const std::size_t available, LogRecord& record, std::size_t& recordSize);
+
+    /**
+     * Read a record already validated by decode (No checks).
+     *
+     * \param data Encoded record.
+     * \return The record (Points into data).
+     */
+    static LogRecord read(const char* data);
+};
+
+}  // namespace collabserver
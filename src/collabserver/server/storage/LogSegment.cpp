@@ -0,0 +1,136 @@
+#include "collabserver/server/storage/LogSegment.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>  // mkstemp
+#include <cstring>
+
+#include "collabserver/server/utils/Log.h"
+
+namespace collabserver {
+
+// Allocate the blocks of the whole file. A sparse file would only get them
+// when the mapping is written, and a full disk then raises SIGBUS.
+static bool local_reserve(const int fd, const std::size_t capacity) {
+    const int error = ::posix_fallocate(fd, 0, static_cast<off_t>(capacity));
+    if (error != 0) {
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+LogSegment::~LogSegment() {
+    if (_data != nullptr) {
+        ::munmap(_data, _capacity);
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+}
+
+LogSegment* LogSegment::create(const std::string& path, const uint64_t firstIndex, const std::size_t capacity) {
+    LogSegment* segment = new LogSegment();
+    segment->_path = path;
+    segment->_firstIndex = firstIndex;
+    segment->_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (segment->_fd < 0 || !local_reserve(segment->_fd, capacity) || !segment->map(capacity)) {
+        LOG << "Failed to create log segment " << path << ": " << std::strerror(errno) << "\n";
+        if (segment->_fd >= 0) {
+            ::unlink(path.c_str());  // Would be taken for a segment on next open
+        }
+        delete segment;
+        return nullptr;
+    }
+    return segment;
+}
+
+LogSegment* LogSegment::createTemporary(const std::string& directory, const uint64_t firstIndex,
+                                        const std::size_t capacity) {
+    std::string path = directory + "/collabserver-XXXXXX";
+    LogSegment* segment = new LogSegment();
+    segment->_firstIndex = firstIndex;
+    segment->_fd = ::mkstemp(&path[0]);
+    if (segment->_fd >= 0) {
+        ::unlink(path.c_str());
+        ::fcntl(segment->_fd, F_SETFD, FD_CLOEXEC);
+    }
+    if (segment->_fd < 0 || !local_reserve(segment->_fd, capacity) || !segment->map(capacity)) {
+        LOG << "Failed to create temporary log segment in " << directory << ": " << std::strerror(errno) << "\n";
+        delete segment;
+        return nullptr;
+    }
+    return segment;
+}
+
+LogSegment* LogSegment::open(const std::string& path, const uint64_t firstIndex) {
+    LogSegment* segment = new LogSegment();
+    segment->_path = path;
+    segment->_firstIndex = firstIndex;
+    segment->_fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    struct stat info;
+    if (segment->_fd < 0 || ::fstat(segment->_fd, &info) != 0 || info.st_size <= 0 ||
+        !segment->map(static_cast<std::size_t>(info.st_size))) {
+        LOG << "Failed to open log segment " << path << ": " << std::strerror(errno) << "\n";
+        delete segment;
+        return nullptr;
+    }
+
+    LogRecord record;
+    std::size_t recordSize = 0;
+    while (LogRecord::decode(segment->_data + segment->_size, segment->_capacity - segment->_size, record,
+                             recordSize)) {
+        segment->_offsets.push_back(static_cast<uint32_t>(segment->_size));
+        segment->_size += recordSize;
+    }
+    segment->_syncedSize = segment->_size;
+    return segment;
+}
+
+bool LogSegment::map(const std::size_t capacity) {
+    void* data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    _data = static_cast<char*>(data);
+    _capacity = capacity;
+    return true;
+}
+
+bool LogSegment::append(const OperationInfo& op) {
+    const std::size_t recordSize = LogRecord::getEncodedSize(op);
+    if (recordSize > _capacity - _size) {
+        return false;
+    }
+    LogRecord::encode(op, _data + _size);
+    _offsets.push_back(static_cast<uint32_t>(_size));
+    _size += recordSize;
+    return true;
+}
+
+LogRecord LogSegment::getRecord(const std::size_t index) const {
+    assert(index < _offsets.size());
+    return LogRecord::read(_data + _offsets[index]);
+}
+
+bool LogSegment::sync(const bool isBlocking) {
+    if (_syncedSize == _size) {
+        return true;
+    }
+    // DevNote: msync requires an address aligned on a page (mapping is).
+    static const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t first = _syncedSize - (_syncedSize % pageSize);
+    if (::msync(_data + first, _size - first, isBlocking ? MS_SYNC : MS_ASYNC) != 0) {
+        LOG << "Failed to sync log segment " << _path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    _syncedSize = _size;
+    return true;
+}
+
+}  // namespace collabserver
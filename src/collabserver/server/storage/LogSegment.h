@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "collabserver/server/room/OperationInfo.h"
+#include "collabserver/server/storage/LogRecord.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * One file of a RoomLog, mapped in memory.
+ *
+ * The file is created with its full capacity and mapped once (shared
+ * mapping). Its blocks are allocated on creation: a full disk fails the
+ * creation, never a write in the mapping. Appending copies the encoded record in the mapping, reading
+ * returns a record that points into the mapping. Both go through the page
+ * cache, no heap copy.
+ *
+ * When an existing file is opened, records are scanned until the first
+ * invalid one (never written or torn by a crash). Next appends overwrite it.
+ *
+ * \note
+ * Written records are handed to the OS but not flushed to disk (See sync).
+ * Only the records written since the previous sync are flushed.
+ */
+class LogSegment {
+   private:
+    std::string _path;
+    int _fd = -1;
+    char* _data = nullptr;           // File mapping
+    std::size_t _capacity = 0;       // File size
+    std::size_t _size = 0;           // Bytes used by the records
+    std::size_t _syncedSize = 0;     // Bytes flushed to disk (or being flushed)
+    std::vector<uint32_t> _offsets;  // Offset of each record
+    uint64_t _firstIndex = 0;        // Log index of the first record
+
+   public:
+    ~LogSegment();
+    LogSegment(const LogSegment& other) = delete;
+    LogSegment& operator=(const LogSegment& other) = delete;
+
+   private:
+    LogSegment() = default;
+
+   public:
+    /**
+     * Create a new segment file.
+     *
+     * \param path File to create (Must not exist).
+     * \param firstIndex Log index of the first record.
+     * \param capacity File size.
+     * \return The new segment or nullptr if failed.
+     */
+    static LogSegment* create(const std::string& path, const uint64_t firstIndex, const std::size_t capacity);
+
+    /**
+     * Create a new segment in an unnamed file (Deleted as soon as created,
+     * the mapping keeps it alive until the segment is destroyed).
+     *
+     * \param directory Directory where to create the file.
+     * \param firstIndex Log index of the first record.
+     * \param capacity File size.
+     * \return The new segment or nullptr if failed.
+     */
+    static LogSegment* createTemporary(const std::string& directory, const uint64_t firstIndex,
+                                       const std::size_t capacity);
+
+    /**
+     * Open an existing segment file and load its records.
+     *
+     * \param path File to open.
+     * \param firstIndex Log index of the first record.
+     * \return The segment or nullptr if failed.
+     */
+    static LogSegment* open(const std::string& path, const uint64_t firstIndex);
+
+   public:
+    /**
+     * Append an operation.
+     *
+     * \param op Operation to append.
+     * \return True if appended, false if not enough space left.
+     */
+    bool append(const OperationInfo& op);
+
+    /**
+     * Get a record.
+     *
+     * \param index Position in this segment (Must be lower than getNbRecords).
+     * \return The record (Valid as long as this segment exists).
+     */
+    LogRecord getRecord(const std::size_t index) const;
+
+    /**
+     * Flush the records written since the previous sync to disk.
+     *
+     * \param isBlocking If true, wait until done, otherwise, only start
+     *                   the writeback.
+     * \return True if succeed, otherwise, return false.
+     */
+    bool sync(const bool isBlocking);
+
+    /**
+     * Check whether some records were written since the previous sync.
+     *
+     * \return True if not synced, otherwise, return false.
+     */
+    bool hasUnsyncedRecords() const { return _syncedSize != _size; }
+
+   public:
+    std::size_t getNbRecords() const { return _offsets.size(); }
+    uint64_t getFirstIndex() const { return _firstIndex; }
+    std::size_t getCapacity() const { return _capacity; }
+    std::size_t getSize() const { return _size; }
+    const std::string& getPath() const { return _path; }  // Empty if temporary
+
+   private:
+    bool map(const std::size_t capacity);
+};
+
+}  // namespace collabserver
@@ -0,0 +1,214 @@
+#include "collabserver/server/storage/RoomArchive.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include "collabserver/server/storage/LogRecord.h"
+#include "collabserver/server/utils/Log.h"
+
+namespace collabserver {
+
+static const uint32_t local_magic = 0x41525343;          // "CSRA"
+static const std::size_t local_headerSize = 21;          // magic (u32), first, nbOperations (u64), flag (u8)
+static const std::size_t local_snapshotHeaderSize = 20;  // position (u64), roomID, userID, buffer size (u32)
+static const std::size_t local_flushSize = 1024 * 1024;  // Written by blocks of this size
+
+static std::string local_archivePath(const std::string& directory, const unsigned int roomID) {
+    return directory + "/room-" + std::to_string(roomID) + ".archive";
+}
+
+static void local_appendUint(std::string& out, const uint64_t value, const int nbBytes) {
+    for (int k = 0; k < nbBytes; ++k) {
+        out.push_back(static_cast<char>((value >> (8 * k)) & 0xff));
+    }
+}
+
+static uint64_t local_readUint(const char* data, const int nbBytes) {
+    uint64_t value = 0;
+    for (int k = 0; k < nbBytes; ++k) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[k])) << (8 * k);
+    }
+    return value;
+}
+
+RoomArchive::~RoomArchive() {
+    if (_data != nullptr) {
+        ::munmap(_data, _size);
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+    if (!_tmpPath.empty()) {
+        ::unlink(_tmpPath.c_str());  // Not committed
+    }
+}
+
+RoomArchive* RoomArchive::create(const std::string& directory, const unsigned int roomID) {
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        LOG << "Failed to create directory " << directory << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+    RoomArchive* archive = new RoomArchive();
+    archive->_path = local_archivePath(directory, roomID);
+    archive->_tmpPath = archive->_path + ".tmp";
+    archive->_fd = ::open(archive->_tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (archive->_fd < 0) {
+        LOG << "Failed to create archive " << archive->_tmpPath << ": " << std::strerror(errno) << "\n";
+        delete archive;
+        return nullptr;
+    }
+    return archive;
+}
+
+RoomArchive* RoomArchive::open(const std::string& directory, const unsigned int roomID) {
+    RoomArchive* archive = new RoomArchive();
+    archive->_path = local_archivePath(directory, roomID);
+    archive->_fd = ::open(archive->_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (archive->_fd < 0 || ::fstat(archive->_fd, &info) != 0 || info.st_size <= 0) {
+        LOG << "Failed to open archive " << archive->_path << ": " << std::strerror(errno) << "\n";
+        delete archive;
+        return nullptr;
+    }
+    void* data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, archive->_fd, 0);
+    if (data == MAP_FAILED) {
+        LOG << "Failed to map archive " << archive->_path << ": " << std::strerror(errno) << "\n";
+        delete archive;
+        return nullptr;
+    }
+    archive->_data = static_cast<char*>(data);
+    archive->_size = static_cast<std::size_t>(info.st_size);
+    ::madvise(archive->_data, archive->_size, MADV_SEQUENTIAL);
+    return archive;
+}
+
+bool RoomArchive::remove(const std::string& directory, const unsigned int roomID) {
+    return ::unlink(local_archivePath(directory, roomID).c_str()) == 0;
+}
+
+// -----------------------------------------------------------------------------
+// Write
+// -----------------------------------------------------------------------------
+
+bool RoomArchive::writeHeader(const std::size_t first, const std::size_t nbOperations,
+                              const SnapshotInfo* snapshot) {
+    local_appendUint(_buffer, local_magic, 4);
+    local_appendUint(_buffer, first, 8);
+    local_appendUint(_buffer, nbOperations, 8);
+    _buffer.push_back(snapshot != nullptr ? 1 : 0);
+    if (snapshot != nullptr) {
+        local_appendUint(_buffer, snapshot->position, 8);
+        local_appendUint(_buffer, snapshot->roomID, 4);
+        local_appendUint(_buffer, snapshot->userID, 4);
+        local_appendUint(_buffer, snapshot->buffer.size(), 4);
+        _buffer.append(snapshot->buffer);
+    }
+    return _buffer.size() < local_flushSize || this->flush();
+}
+
+bool RoomArchive::write(const OperationInfo& op, const bool isDropped) {
+    // DevNote: a dropped operation only keeps its IDs (See OperationLog::drop).
+    OperationInfo dropped;
+    if (isDropped) {
+        dropped.roomID = op.roomID;
+        dropped.userID = op.userID;
+        dropped.opTypeID = op.opTypeID;
+    }
+    const OperationInfo& written = isDropped ? dropped : op;
+    const std::size_t offset = _buffer.size();
+    _buffer.resize(offset + 1 + LogRecord::getEncodedSize(written));
+    _buffer[offset] = isDropped ? 1 : 0;
+    LogRecord::encode(written, &_buffer[offset + 1]);
+    return _buffer.size() < local_flushSize || this->flush();
+}
+
+bool RoomArchive::commit() {
+    // DevNote: not synced, history in memory is lost with the process
+    // anyway. Rename only makes sure a partial archive is never opened.
+    const bool isWritten = this->flush();
+    const bool isClosed = ::close(_fd) == 0;
+    _fd = -1;
+    if (!isWritten || !isClosed || ::rename(_tmpPath.c_str(), _path.c_str()) != 0) {
+        LOG << "Failed to write archive " << _tmpPath << ": " << std::strerror(errno) << "\n";
+        return false;  // Temporary file deleted with the archive
+    }
+    _tmpPath.clear();
+    return true;
+}
+
+bool RoomArchive::flush() {
+    const char* data = _buffer.data();
+    std::size_t size = _buffer.size();
+    while (size > 0) {
+        const ssize_t written = ::write(_fd, data, size);
+        if (written < 0 && errno != EINTR) {
+            return false;
+        }
+        if (written > 0) {
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+    _buffer.clear();
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Read
+// -----------------------------------------------------------------------------
+
+bool RoomArchive::readHeader(std::size_t& first, std::size_t& nbOperations, SnapshotInfo& snapshot,
+                             bool& hasSnapshot) {
+    if (_size < local_headerSize || local_readUint(_data, 4) != local_magic) {
+        return false;
+    }
+    first = static_cast<std::size_t>(local_readUint(_data + 4, 8));
+    nbOperations = static_cast<std::size_t>(local_readUint(_data + 12, 8));
+    hasSnapshot = _data[20] != 0;
+    _offset = local_headerSize;
+    if (first > nbOperations) {
+        return false;
+    }
+    if (!hasSnapshot) {
+        return true;
+    }
+
+    if (_size - _offset < local_snapshotHeaderSize) {
+        return false;
+    }
+    const char* header = _data + _offset;
+    snapshot.position = static_cast<std::size_t>(local_readUint(header, 8));
+    snapshot.roomID = static_cast<unsigned int>(local_readUint(header + 8, 4));
+    snapshot.userID = static_cast<unsigned int>(local_readUint(header + 12, 4));
+    const std::size_t bufferSize = static_cast<std::size_t>(local_readUint(header + 16, 4));
+    _offset += local_snapshotHeaderSize;
+    if (_size - _offset < bufferSize) {
+        return false;
+    }
+    snapshot.buffer.assign(_data + _offset, bufferSize);
+    _offset += bufferSize;
+    return true;
+}
+
+bool RoomArchive::read(OperationInfo& op, bool& isDropped) {
+    LogRecord record;
+    std::size_t recordSize = 0;
+    if (_offset >= _size || !LogRecord::decode(_data + _offset + 1, _size - _offset - 1, record, recordSize)) {
+        return false;
+    }
+    isDropped = _data[_offset] != 0;
+    op.roomID = record.roomID;
+    op.userID = record.userID;
+    op.opTypeID = record.opTypeID;
+    op.buffer.assign(record.buffer, record.bufferSize);
+    _offset += 1 + recordSize;
+    return true;
+}
+
+}  // namespace collabserver
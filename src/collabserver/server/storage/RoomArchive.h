@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <string>
+
+#include "collabserver/server/room/OperationInfo.h"
+#include "collabserver/server/room/SnapshotInfo.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * History of a room kept in memory, saved in one file while the room is
+ * unloaded (See CollabServer::hibernateIdleRooms).
+ *
+ * An archive is written once (See create, then commit) and read once (See
+ * open) when the room is loaded again. Unlike a RoomLog, operations dropped
+ * by coalescing are kept (flagged, empty buffer) so that indexes and
+ * sequence numbers don't change.
+ *
+ * \par Layout (little endian)
+ *  - magic (u32), index of the first operation (u64), number of operations (u64)
+ *  - snapshot flag (u8), then if set: position (u64), roomID, userID, buffer size (u32), buffer
+ *  - each operation from the first one: dropped flag (u8), LogRecord
+ *
+ * \par Files
+ *  - <directory>/room-<roomID>.archive
+ */
+class RoomArchive {
+   private:
+    std::string _path;
+    std::string _tmpPath;     // Where it is written, until committed (Written archive)
+    int _fd = -1;             // Temporary file (Written archive) or archive (Opened archive)
+    std::string _buffer;      // Data not written yet (Written archive)
+    char* _data = nullptr;    // File mapping (Opened archive)
+    std::size_t _size = 0;    // Size of the mapping
+    std::size_t _offset = 0;  // Next byte to read
+
+   private:
+    RoomArchive() = default;
+
+   public:
+    /**
+     * Close the archive. An archive created but not committed is deleted.
+     */
+    ~RoomArchive();
+
+    RoomArchive(const RoomArchive& other) = delete;
+    RoomArchive& operator=(const RoomArchive& other) = delete;
+
+    /**
+     * Start writing the archive of a room. Written aside, the previous
+     * archive (if any) is only replaced by commit.
+     *
+     * \param directory Directory with the archives (Created if doesn't exist).
+     * \param roomID ID of the room.
+     * \return The archive or nullptr if failed.
+     */
+    static RoomArchive* create(const std::string& directory, const unsigned int roomID);
+
+    /**
+     * Open the archive of a room for reading.
+     *
+     * \param directory Directory with the archives.
+     * \param roomID ID of the room.
+     * \return The archive or nullptr if failed (e.g., no archive).
+     */
+    static RoomArchive* open(const std::string& directory, const unsigned int roomID);
+
+    /**
+     * Delete the archive of a room.
+     *
+     * \param directory Directory with the archives.
+     * \param roomID ID of the room.
+     * \return True if deleted, otherwise, return false.
+     */
+    static bool remove(const std::string& directory, const unsigned int roomID);
+
+    // -------------------------------------------------------------------------
+    // Write
+    // -------------------------------------------------------------------------
+
+   public:
+    /**
+     * Write the header. Must be called first, followed by exactly
+     * nbOperations - first operations.
+     *
+     * \param first Index of the first operation.
+     * \param nbOperations Index after the last operation.
+     * \param snapshot Snapshot of the room (nullptr: none).
+     * \return True if written, otherwise, return false.
+     */
+    bool writeHeader(const std::size_t first, const std::size_t nbOperations, const SnapshotInfo* snapshot);
+
+    /**
+     * Write the next operation.
+     *
+     * \param op Operation to write (Buffer not written if dropped).
+     * \param isDropped True if dropped by coalescing.
+     * \return True if written, otherwise, return false (e.g., disk full).
+     */
+    bool write(const OperationInfo& op, const bool isDropped);
+
+    /**
+     * Finish the archive: it replaces the previous one.
+     *
+     * \return True if succeed, otherwise, return false.
+     */
+    bool commit();
+
+    // -------------------------------------------------------------------------
+    // Read
+    // -------------------------------------------------------------------------
+
+   public:
+    /**
+     * Read the header. Must be called first.
+     *
+     * \param first Set with the index of the first operation.
+     * \param nbOperations Set with the index after the last operation.
+     * \param snapshot Set with the snapshot (If any).
+     * \param hasSnapshot Set to true if has a snapshot, otherwise, to false.
+     * \return True if read, otherwise, return false (Corrupted archive).
+     */
+    bool readHeader(std::size_t& first, std::size_t& nbOperations, SnapshotInfo& snapshot, bool& hasSnapshot);
+
+    /**
+     * Read the next operation. Its sequence number is not set.
+     *
+     * \param op Set with the operation.
+     * \param isDropped Set to true if dropped by coalescing, otherwise, to false.
+     * \return True if read, otherwise, return false (Corrupted archive).
+     */
+    bool read(OperationInfo& op, bool& isDropped);
+
+   private:
+    bool flush();
+};
+
+}  // namespace collabserver
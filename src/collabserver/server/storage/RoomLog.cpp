@@ -0,0 +1,370 @@
+#include "collabserver/server/storage/RoomLog.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>  // std::sort, std::upper_bound
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "collabserver/server/utils/Log.h"
+
+namespace collabserver {
+
+const std::size_t RoomLog::DEFAULT_SEGMENT_SIZE;
+
+static const char* const local_roomPrefix = "room-";
+static const char* const local_segmentSuffix = ".seg";
+static const char* const local_staleSuffix = ".stale";  // Segments after a gap (See open)
+static const char* const local_snapshotName = "snapshot";
+static const std::size_t local_snapshotHeaderSize = 20;  // position (u64), roomID, userID, buffer size (u32)
+
+static std::string local_roomDirectory(const std::string& storageDir, const unsigned int roomID) {
+    return storageDir + "/" + local_roomPrefix + std::to_string(roomID);
+}
+
+static std::string local_segmentPath(const std::string& directory, const uint64_t firstIndex) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020llu", static_cast<unsigned long long>(firstIndex));
+    return directory + "/" + name + local_segmentSuffix;
+}
+
+// Flush the entries of a directory (files created, renamed) to disk.
+static bool local_syncDirectory(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    const bool isSynced = fd >= 0 && ::fsync(fd) == 0;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    return isSynced;
+}
+
+// Create a directory if doesn't exist. Its parent is synced if created, so
+// that the files written in it later are not lost with it.
+static bool local_makeDirectory(const std::string& path) {
+    if (::mkdir(path.c_str(), 0755) != 0) {
+        if (errno == EEXIST) {
+            return true;
+        }
+        LOG << "Failed to create directory " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    const std::size_t slash = path.find_last_of('/');
+    const std::string parent = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    if (!local_syncDirectory(parent)) {
+        LOG << "Failed to sync directory " << parent << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+static void local_writeUint(char* out, const uint64_t value, const int nbBytes) {
+    for (int k = 0; k < nbBytes; ++k) {
+        out[k] = static_cast<char>((value >> (8 * k)) & 0xff);
+    }
+}
+
+static uint64_t local_readUint(const char* data, const int nbBytes) {
+    uint64_t value = 0;
+    for (int k = 0; k < nbBytes; ++k) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[k])) << (8 * k);
+    }
+    return value;
+}
+
+static bool local_writeAll(const int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno != EINTR) {
+            return false;
+        }
+        if (written > 0) {
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+    return true;
+}
+
+static bool local_readAll(const int fd, char* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t nbRead = ::read(fd, data, size);
+        if (nbRead == 0 || (nbRead < 0 && errno != EINTR)) {
+            return false;
+        }
+        if (nbRead > 0) {
+            data += nbRead;
+            size -= static_cast<std::size_t>(nbRead);
+        }
+    }
+    return true;
+}
+
+// Read the snapshot header (and its buffer if withBuffer).
+static bool local_readSnapshot(const std::string& directory, SnapshotInfo& snapshot, const bool withBuffer) {
+    const int fd = ::open((directory + "/" + local_snapshotName).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char header[local_snapshotHeaderSize];
+    bool isRead = local_readAll(fd, header, sizeof(header));
+    if (isRead) {
+        snapshot.position = static_cast<std::size_t>(local_readUint(header, 8));
+        snapshot.roomID = static_cast<unsigned int>(local_readUint(header + 8, 4));
+        snapshot.userID = static_cast<unsigned int>(local_readUint(header + 12, 4));
+        if (withBuffer) {
+            snapshot.buffer.resize(static_cast<std::size_t>(local_readUint(header + 16, 4)));
+            isRead = local_readAll(fd, &snapshot.buffer[0], snapshot.buffer.size());
+        }
+    }
+    ::close(fd);
+    return isRead;
+}
+
+// Parse "<prefix><number><suffix>". Return false if name doesn't match.
+static bool local_parseName(const char* name, const char* prefix, const char* suffix, unsigned long long& number) {
+    const std::size_t prefixSize = std::strlen(prefix);
+    const std::size_t suffixSize = std::strlen(suffix);
+    const std::size_t size = std::strlen(name);
+    if (size <= prefixSize + suffixSize || std::strncmp(name, prefix, prefixSize) != 0 ||
+        std::strcmp(name + size - suffixSize, suffix) != 0) {
+        return false;
+    }
+    char* end = nullptr;
+    number = std::strtoull(name + prefixSize, &end, 10);
+    return end == name + size - suffixSize;
+}
+
+// Rename the segments from the given one (no longer taken for segments).
+static void local_quarantineSegments(const std::string& directory, const std::vector<uint64_t>& firstIndexes,
+                                     const std::size_t from) {
+    for (std::size_t k = from; k < firstIndexes.size(); ++k) {
+        const std::string path = local_segmentPath(directory, firstIndexes[k]);
+        if (::rename(path.c_str(), (path + local_staleSuffix).c_str()) != 0) {
+            LOG << "Failed to move aside log segment " << path << ": " << std::strerror(errno) << "\n";
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Open
+// -----------------------------------------------------------------------------
+
+RoomLog* RoomLog::open(const std::string& storageDir, const unsigned int roomID, const std::size_t segmentSize) {
+    const std::string directory = local_roomDirectory(storageDir, roomID);
+    if (!local_makeDirectory(storageDir) || !local_makeDirectory(directory)) {
+        return nullptr;
+    }
+
+    std::vector<uint64_t> firstIndexes;
+    DIR* dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+        LOG << "Failed to open directory " << directory << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+    while (struct dirent* entry = ::readdir(dir)) {
+        unsigned long long firstIndex = 0;
+        if (local_parseName(entry->d_name, "", local_segmentSuffix, firstIndex)) {
+            firstIndexes.push_back(firstIndex);
+        }
+    }
+    ::closedir(dir);
+    std::sort(firstIndexes.begin(), firstIndexes.end());
+
+    RoomLog* log = new RoomLog();
+    log->_directory = directory;
+    log->_segmentSize = segmentSize;
+
+    // DevNote: segments before the snapshot are deleted after it is saved. A
+    // crash in between leaves some of them, they are skipped.
+    SnapshotInfo snapshot;
+    log->_hasSnapshot = local_readSnapshot(directory, snapshot, false);
+    log->_first = log->_hasSnapshot ? snapshot.position : 0;
+    log->_size = firstIndexes.empty() ? log->_first : static_cast<std::size_t>(firstIndexes.front());
+    for (std::size_t k = 0; k < firstIndexes.size(); ++k) {
+        const uint64_t firstIndex = firstIndexes[k];
+        if (firstIndex != log->_size) {
+            // DevNote: a crash may tear the end of a segment. Records after
+            // the gap are unreachable (would break the log order). Their
+            // segments are moved aside: next appends reuse these indexes,
+            // a stale segment would make the next open stop here again.
+            LOG << "Log of room " << roomID << " has a gap before segment " << firstIndex << " (moved aside)\n";
+            local_quarantineSegments(directory, firstIndexes, k);
+            break;
+        }
+        LogSegment* segment = LogSegment::open(local_segmentPath(directory, firstIndex), firstIndex);
+        if (segment == nullptr) {
+            delete log;
+            return nullptr;
+        }
+        log->_size += segment->getNbRecords();
+        log->_segments.emplace_back(segment);
+    }
+    const bool hasMissingRecords =
+        log->_size < log->_first || (!log->_segments.empty() && log->_segments.front()->getFirstIndex() > log->_first);
+    if (hasMissingRecords) {
+        LOG << "Log of room " << roomID << " misses records after its snapshot\n";
+        delete log;
+        return nullptr;
+    }
+    log->truncate(log->_first);
+    return log;
+}
+
+RoomLog* RoomLog::createTemporary(const std::string& directory, const std::size_t firstIndex,
+                                  const std::size_t segmentSize) {
+    if (!local_makeDirectory(directory)) {
+        return nullptr;
+    }
+    RoomLog* log = new RoomLog();
+    log->_directory = directory;
+    log->_segmentSize = segmentSize;
+    log->_first = firstIndex;
+    log->_size = firstIndex;
+    log->_isTemporary = true;
+    return log;
+}
+
+bool RoomLog::exists(const std::string& storageDir, const unsigned int roomID) {
+    struct stat info;
+    return ::stat(local_roomDirectory(storageDir, roomID).c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+std::vector<unsigned int> RoomLog::listRoomIDs(const std::string& storageDir) {
+    std::vector<unsigned int> roomIDs;
+    DIR* dir = ::opendir(storageDir.c_str());
+    if (dir == nullptr) {
+        return roomIDs;
+    }
+    while (struct dirent* entry = ::readdir(dir)) {
+        unsigned long long roomID = 0;
+        if (local_parseName(entry->d_name, local_roomPrefix, "", roomID) && roomID > 0) {
+            roomIDs.push_back(static_cast<unsigned int>(roomID));
+        }
+    }
+    ::closedir(dir);
+    return roomIDs;
+}
+
+// -----------------------------------------------------------------------------
+// Records
+// -----------------------------------------------------------------------------
+
+bool RoomLog::append(const OperationInfo& op) {
+    if (_segments.empty() || !_segments.back()->append(op)) {
+        if (!this->addSegment(LogRecord::getEncodedSize(op)) || !_segments.back()->append(op)) {
+            return false;
+        }
+    }
+    ++_size;
+    return true;
+}
+
+bool RoomLog::installSnapshot(const SnapshotInfo& snapshot) {
+    if (_isTemporary || snapshot.position < _first || snapshot.position > _size) {
+        return false;
+    }
+
+    // DevNote: written aside then renamed, so that a crash never leaves a
+    // partial snapshot. Directory is synced for the rename.
+    const std::string path = _directory + "/" + local_snapshotName;
+    const std::string tmpPath = path + ".tmp";
+    char header[local_snapshotHeaderSize];
+    local_writeUint(header, snapshot.position, 8);
+    local_writeUint(header + 8, snapshot.roomID, 4);
+    local_writeUint(header + 12, snapshot.userID, 4);
+    local_writeUint(header + 16, snapshot.buffer.size(), 4);
+
+    const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool isSaved = fd >= 0 && local_writeAll(fd, header, sizeof(header)) &&
+                   local_writeAll(fd, snapshot.buffer.data(), snapshot.buffer.size()) && ::fsync(fd) == 0;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    isSaved = isSaved && ::rename(tmpPath.c_str(), path.c_str()) == 0;
+    isSaved = isSaved && local_syncDirectory(_directory);
+    if (!isSaved) {
+        LOG << "Failed to save snapshot in " << _directory << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    _hasSnapshot = true;
+    this->truncate(snapshot.position);
+    return true;
+}
+
+bool RoomLog::loadSnapshot(SnapshotInfo& snapshot) const {
+    return _hasSnapshot && local_readSnapshot(_directory, snapshot, true);
+}
+
+bool RoomLog::discard(const std::size_t position) {
+    if (!_isTemporary || position < _first || position > _size) {
+        return false;
+    }
+    this->truncate(position);
+    return true;
+}
+
+void RoomLog::truncate(const std::size_t position) {
+    // Segments with only discarded records (Last one is kept, it is appended)
+    while (_segments.size() > 1 && _segments[1]->getFirstIndex() <= position) {
+        if (!_isTemporary) {
+            ::unlink(_segments.front()->getPath().c_str());
+        }
+        _segments.erase(_segments.begin());
+        _firstUnsynced = (_firstUnsynced > 0) ? _firstUnsynced - 1 : 0;
+    }
+    _first = position;
+}
+
+bool RoomLog::sync(const bool isBlocking) {
+    // DevNote: records of a new segment file are lost with its entry if the
+    // directory isn't on disk (power loss), whatever the records sync.
+    if (_isDirectoryUnsynced) {
+        if (!local_syncDirectory(_directory)) {
+            LOG << "Failed to sync directory " << _directory << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        _isDirectoryUnsynced = false;
+    }
+    for (std::size_t k = _firstUnsynced; k < _segments.size(); ++k) {
+        if (!_segments[k]->sync(isBlocking)) {
+            _firstUnsynced = k;
+            return false;
+        }
+    }
+    _firstUnsynced = _segments.empty() ? 0 : _segments.size() - 1;
+    return true;
+}
+
+std::size_t RoomLog::findSegment(const std::size_t index) const {
+    auto it = std::upper_bound(
+        _segments.begin(), _segments.end(), index,
+        [](const std::size_t value, const std::unique_ptr<LogSegment>& s) { return value < s->getFirstIndex(); });
+    return static_cast<std::size_t>(it - _segments.begin()) - 1;
+}
+
+bool RoomLog::addSegment(const std::size_t minCapacity) {
+    if (!_segments.empty() && _segments.back()->getNbRecords() == 0) {
+        // Too small for the record, same first index as the new one
+        if (!_isTemporary) {
+            ::unlink(_segments.back()->getPath().c_str());
+        }
+        _segments.pop_back();
+    }
+    const std::size_t capacity = std::max(_segmentSize, minCapacity);
+    LogSegment* segment = _isTemporary ? LogSegment::createTemporary(_directory, _size, capacity)
+                                       : LogSegment::create(local_segmentPath(_directory, _size), _size, capacity);
+    if (segment == nullptr) {
+        return false;
+    }
+    _segments.emplace_back(segment);
+    _isDirectoryUnsynced = !_isTemporary;
+    return true;
+}
+
+}  // namespace collabserver
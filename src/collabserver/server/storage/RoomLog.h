@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>  // std::size_t
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "collabserver/server/room/OperationInfo.h"
+#include "collabserver/server/room/SnapshotInfo.h"
+#include "collabserver/server/storage/LogRecord.h"
+#include "collabserver/server/storage/LogSegment.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Persistent history of a room, stored in a directory of segment files.
+ *
+ * Operations are appended to the last segment. A new segment is created
+ * when it is full. Segments are named after the log index of their first
+ * record, so that a restarted server reloads the whole history in order.
+ * Only the record offsets are kept in memory.
+ *
+ * A snapshot of the room may replace the records before its position (See
+ * installSnapshot). Segments with only replaced records are deleted. Indexes
+ * of the remaining records don't change.
+ *
+ * A temporary log (See createTemporary) uses unnamed files instead: it only
+ * moves records out of the heap and is lost with the process.
+ *
+ * \par Files
+ *  - <storageDir>/room-<roomID>/<firstIndex>.seg
+ *  - <storageDir>/room-<roomID>/snapshot (Latest snapshot, if any)
+ */
+class RoomLog {
+   public:
+    static const std::size_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+   private:
+    std::string _directory;
+    std::size_t _segmentSize = DEFAULT_SEGMENT_SIZE;
+    std::vector<std::unique_ptr<LogSegment>> _segments;  // Ordered by first index
+    std::size_t _first = 0;          // Index of the first record kept
+    std::size_t _size = 0;           // Index of the next record
+    std::size_t _firstUnsynced = 0;  // First segment with records not synced yet
+    bool _hasSnapshot = false;
+    bool _isTemporary = false;          // Unnamed segment files, no snapshot
+    bool _isDirectoryUnsynced = false;  // Segment files created since the previous sync
+
+   private:
+    RoomLog() = default;
+
+   public:
+    /**
+     * Open the log of a room (Created if doesn't exist). Records are loaded
+     * up to the first gap (e.g., segment torn by a crash), the segments after
+     * it are renamed with a ".stale" suffix.
+     *
+     * \param storageDir Directory with the logs of all rooms (Created if doesn't exist).
+     * \param roomID ID of the room.
+     * \param segmentSize Size of the segment files.
+     * \return The log or nullptr if failed.
+     */
+    static RoomLog* open(const std::string& storageDir, const unsigned int roomID,
+                         const std::size_t segmentSize = DEFAULT_SEGMENT_SIZE);
+
+    /**
+     * Create an empty temporary log (Segments are unnamed files, deleted
+     * with the log). Snapshots are not supported.
+     *
+     * \param directory Directory where to create the segment files (Created if doesn't exist).
+     * \param firstIndex Index of the first record.
+     * \param segmentSize Size of the segment files.
+     * \return The log or nullptr if failed.
+     */
+    static RoomLog* createTemporary(const std::string& directory, const std::size_t firstIndex,
+                                    const std::size_t segmentSize = DEFAULT_SEGMENT_SIZE);
+
+    /**
+     * Check whether a room has a log.
+     *
+     * \param storageDir Directory with the logs of all rooms.
+     * \param roomID ID of the room.
+     * \return True if exists, otherwise, return false.
+     */
+    static bool exists(const std::string& storageDir, const unsigned int roomID);
+
+    /**
+     * List the rooms that have a log.
+     *
+     * \param storageDir Directory with the logs of all rooms.
+     * \return ID of the rooms (Not ordered).
+     */
+    static std::vector<unsigned int> listRoomIDs(const std::string& storageDir);
+
+   public:
+    /**
+     * Add an operation at the end of the log.
+     *
+     * \param op Operation to add.
+     * \return True if added, otherwise, return false (e.g., disk full).
+     */
+    bool append(const OperationInfo& op);
+
+    /**
+     * Save a snapshot of the room and discard the records before its
+     * position. Snapshot is on disk when this returns (Even with no
+     * durability), records are discarded after.
+     *
+     * \param snapshot Snapshot to save (Position in [getFirstIndex(), size()]).
+     * \return True if saved, otherwise, return false (Log is unchanged).
+     */
+    bool installSnapshot(const SnapshotInfo& snapshot);
+
+    /**
+     * Read the latest snapshot saved.
+     *
+     * \param snapshot Set with the snapshot.
+     * \return True if read, otherwise, return false (e.g., no snapshot).
+     */
+    bool loadSnapshot(SnapshotInfo& snapshot) const;
+
+    /**
+     * Call a function for each record in [first, last), in log order.
+     * Records point into the file mappings (No copy).
+     *
+     * \param first Position of the first record (At least getFirstIndex()).
+     * \param last Position after the last record (At most size()).
+     * \param function Called with a const reference to each record.
+     */
+    template <typename Function>
+    void forEach(std::size_t first, const std::size_t last, Function function) const {
+        std::size_t k = this->findSegment(first);
+        while (first < last) {
+            const LogSegment& segment = *_segments[k];
+            const std::size_t offset = first - segment.getFirstIndex();
+            std::size_t count = segment.getNbRecords() - offset;
+            if (count > last - first) {
+                count = last - first;
+            }
+            for (std::size_t i = offset; i < offset + count; ++i) {
+                function(segment.getRecord(i));
+            }
+            first += count;
+            ++k;
+        }
+    }
+
+    /**
+     * Flush the records appended since the previous sync to disk, and the
+     * entries of the segment files created meanwhile (directory synced).
+     *
+     * \param isBlocking If true, wait until done, otherwise, only start
+     *                   the writeback.
+     * \return True if succeed, otherwise, return false.
+     */
+    bool sync(const bool isBlocking);
+
+    /**
+     * Check whether some records were appended since the previous sync.
+     *
+     * \return True if not synced, otherwise, return false.
+     */
+    bool hasUnsyncedRecords() const { return !_segments.empty() && _segments.back()->hasUnsyncedRecords(); }
+
+    /**
+     * Number of records appended since the creation of the log (Including
+     * the discarded ones). This is the index of the next record.
+     *
+     * \return Number of records.
+     */
+    std::size_t size() const { return _size; }
+
+    /**
+     * Index of the first record kept (Snapshot position, if any).
+     *
+     * \return Index of the first record.
+     */
+    std::size_t getFirstIndex() const { return _first; }
+
+    /**
+     * Check whether a snapshot was saved.
+     *
+     * \return True if has a snapshot, otherwise, return false.
+     */
+    bool hasSnapshot() const { return _hasSnapshot; }
+
+    /**
+     * Check whether log has no record kept.
+     *
+     * \return True if empty, otherwise, return false.
+     */
+    bool isEmpty() const { return _first == _size; }
+
+    /**
+     * Discard the records before the given position (Temporary log only,
+     * a persistent log is truncated by installSnapshot).
+     *
+     * \param position Index of the first record to keep (In [getFirstIndex(), size()]).
+     * \return True if discarded, otherwise, return false.
+     */
+    bool discard(const std::size_t position);
+
+   private:
+    std::size_t findSegment(const std::size_t index) const;
+    void truncate(const std::size_t position);
+    bool addSegment(const std::size_t minCapacity);
+};
+
+}  // namespace collabserver
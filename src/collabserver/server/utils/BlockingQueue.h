@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>  // std::move
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Unbounded thread safe FIFO queue (mutex + condition variable).
+ *
+ * Any thread may push, pop blocks until an item is available.
+ */
+template <typename T>
+class BlockingQueue {
+   private:
+    std::deque<T> _items;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+
+   public:
+    /**
+     * Push an item at the end of the queue and wake up one waiting thread.
+     *
+     * \param item Item to push.
+     */
+    void push(T item) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _items.push_back(std::move(item));
+        }
+        _condition.notify_one();
+    }
+
+    /**
+     * Pop the first item. Block until an item is available.
+     *
+     * \return The first item of the queue.
+     */
+    T pop() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _condition.wait(lock, [this] { return !_items.empty(); });
+        T item = std::move(_items.front());
+        _items.pop_front();
+        return item;
+    }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,36 @@
+#include "collabserver/server/utils/EventFd.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+namespace collabserver {
+
+EventFd::EventFd() : _fd(eventfd(0, EFD_CLOEXEC)) {
+    if (_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "eventfd");
+    }
+}
+
+EventFd::~EventFd() { close(_fd); }
+
+void EventFd::notify() {
+    const uint64_t value = 1;
+    ssize_t res;
+    do {
+        res = write(_fd, &value, sizeof(value));
+    } while (res < 0 && errno == EINTR);
+}
+
+void EventFd::wait() {
+    uint64_t value = 0;
+    ssize_t res;
+    do {
+        res = read(_fd, &value, sizeof(value));
+    } while (res < 0 && errno == EINTR);
+}
+
+}  // namespace collabserver
@@ -0,0 +1,50 @@
+#pragma once
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Linux eventfd used to wake up a thread.
+ *
+ * The file descriptor may also be polled (e.g., zmq::poll or epoll).
+ */
+class EventFd {
+   private:
+    int _fd;
+
+   public:
+    /**
+     * Create a new eventfd.
+     * Throws std::system_error if eventfd can't be created.
+     */
+    EventFd();
+
+    /**
+     * Close the eventfd.
+     */
+    ~EventFd();
+
+    EventFd(const EventFd& other) = delete;
+    EventFd& operator=(const EventFd& other) = delete;
+
+   public:
+    /**
+     * Wake up the waiting thread (if any, otherwise, next wait returns
+     * immediately).
+     */
+    void notify();
+
+    /**
+     * Block until notified. Consume all pending notifications.
+     */
+    void wait();
+
+    /**
+     * Get the file descriptor (For polling).
+     *
+     * \return File descriptor.
+     */
+    int fd() const { return _fd; }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>  // std::size_t
+#include <utility>  // std::move
+#include <vector>
+
+namespace collabserver {
+
+/**
+ * \brief
+ * Bounded lock-free queue, multiple producers / single consumer.
+ *
+ * Each cell has a sequence number telling whether it is free for the
+ * producers (sequence == position) or ready for the consumer
+ * (sequence == position + 1). Producers reserve a position with a CAS,
+ * the consumer never does any CAS (single consumer).
+ *
+ * Capacity is rounded up to the next power of two.
+ *
+ * \warning
+ * tryPop, popBatch and isEmpty must always be called by the same thread.
+ */
+template <typename T>
+class MPSCQueue {
+   private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    // DevNote: positions are padded to be on their own cache line to avoid
+    // false sharing between producers and consumer. (No alignas: over-aligned
+    // new requires C++17.)
+    std::vector<Cell> _cells;
+    std::size_t _mask;
+    char _pad0[64];
+    std::atomic<std::size_t> _enqueuePos;
+    char _pad1[64];
+    std::size_t _dequeuePos;
+    char _pad2[64];
+
+   public:
+    /**
+     * Create an empty queue.
+     *
+     * \param capacity Max number of items (Rounded up to a power of two).
+     */
+    explicit MPSCQueue(const std::size_t capacity) : _enqueuePos(0), _dequeuePos(0) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _cells = std::vector<Cell>(size);
+        _mask = size - 1;
+        for (std::size_t k = 0; k < size; ++k) {
+            _cells[k].sequence.store(k, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue& other) = delete;
+    MPSCQueue& operator=(const MPSCQueue& other) = delete;
+
+   public:
+    /**
+     * Push an item at the end of the queue. Thread safe.
+     *
+     * \param item Item to push (Moved only if successfully pushed).
+     * \return True if pushed, false if queue is full.
+     */
+    bool tryPush(T& item) {
+        std::size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = _cells[pos & _mask];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(item);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Pop the first item. Consumer thread only.
+     *
+     * \param item Set with the popped item.
+     * \return True if an item was popped, false if queue is empty.
+     */
+    bool tryPop(T& item) {
+        Cell& cell = _cells[_dequeuePos & _mask];
+        const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (seq != _dequeuePos + 1) {
+            return false;  // Empty (or producer not done yet)
+        }
+        item = std::move(cell.data);
+        cell.sequence.store(_dequeuePos + _mask + 1, std::memory_order_release);
+        ++_dequeuePos;
+        return true;
+    }
+
+    /**
+     * Pop up to max items at once. Consumer thread only.
+     *
+     * \param items Array where to place popped items (At least max items).
+     * \param max Max number of items to pop.
+     * \return Number of popped items.
+     */
+    std::size_t popBatch(T* items, const std::size_t max) {
+        std::size_t count = 0;
+        while (count < max && this->tryPop(items[count])) {
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * Check whether no item is ready to pop. Consumer thread only.
+     *
+     * \return True if next tryPop would fail, otherwise, return false.
+     */
+    bool isEmpty() const {
+        const Cell& cell = _cells[_dequeuePos & _mask];
+        return cell.sequence.load(std::memory_order_acquire) != _dequeuePos + 1;
+    }
+
+    /**
+     * Max number of items in the queue.
+     *
+     * \return Queue capacity.
+     */
+    std::size_t capacity() const { return _mask + 1; }
+};
+
+}  // namespace collabserver
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <poll.h>
+
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <thread>
+#include <utility>  // std::move
+
+#include "EventFd.h"
+#include "MPSCQueue.h"
+
+namespace collabserver {
+
+/**
+ * \brief
+ * MPSCQueue with a blocking consumer side, woken up by an eventfd.
+ *
+ * Producers only do the eventfd syscall when the consumer is actually
+ * sleeping. While the consumer is busy, a push is a lock-free enqueue and
+ * nothing else.
+ */
+template <typename T>
+class Mailbox {
+   private:
+    MPSCQueue<T> _queue;
+    EventFd _event;
+    std::atomic<bool> _isSleeping;
+
+   public:
+    /**
+     * Create an empty mailbox.
+     *
+     * \param capacity Max number of pending items (See MPSCQueue).
+     */
+    explicit Mailbox(const std::size_t capacity) : _queue(capacity), _isSleeping(false) {}
+
+    Mailbox(const Mailbox& other) = delete;
+    Mailbox& operator=(const Mailbox& other) = delete;
+
+   public:
+    /**
+     * Push an item and wake up the consumer if needed. Thread safe.
+     *
+     * \param item Item to push (Moved only if successfully pushed).
+     * \return True if pushed, false if mailbox is full.
+     */
+    bool tryPush(T& item) {
+        if (!_queue.tryPush(item)) {
+            return false;
+        }
+        // Pairs with the fence in prepareWait: either consumer sees the item
+        // or we see it sleeping.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_isSleeping.load(std::memory_order_relaxed) && _isSleeping.exchange(false)) {
+            _event.notify();
+        }
+        return true;
+    }
+
+    /**
+     * Push an item. If mailbox is full, yield until there is room.
+     * Thread safe.
+     *
+     * \param item Item to push.
+     */
+    void push(T item) {
+        while (!this->tryPush(item)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * Pop up to max items at once. Block until at least one item is available.
+     * Consumer thread only.
+     *
+     * \param items Array where to place popped items (At least max items).
+     * \param max Max number of items to pop.
+     * \return Number of popped items (At least 1).
+     */
+    std::size_t waitBatch(T* items, const std::size_t max) {
+        while (true) {
+            const std::size_t count = _queue.popBatch(items, max);
+            if (count > 0) {
+                return count;
+            }
+            if (this->prepareWait()) {
+                _event.wait();
+                this->finishWait(false);
+            }
+        }
+    }
+
+    /**
+     * Pop up to max items at once. Block until at least one item is
+     * available, or until timeout. Consumer thread only.
+     *
+     * \param items Array where to place popped items (At least max items).
+     * \param max Max number of items to pop.
+     * \param timeoutMs Max time to wait, in milliseconds.
+     * \return Number of popped items (0 if timed out).
+     */
+    std::size_t waitBatch(T* items, const std::size_t max, const int timeoutMs) {
+        const std::size_t count = _queue.popBatch(items, max);
+        if (count > 0) {
+            return count;
+        }
+        if (this->prepareWait()) {
+            struct pollfd item = {_event.fd(), POLLIN, 0};
+            const bool isNotified = ::poll(&item, 1, timeoutMs) > 0 && (item.revents & POLLIN) != 0;
+            this->finishWait(isNotified);
+        }
+        return _queue.popBatch(items, max);
+    }
+
+    /**
+     * Pop up to max items at once. Never blocks. Consumer thread only.
+     *
+     * \param items Array where to place popped items (At least max items).
+     * \param max Max number of items to pop.
+     * \return Number of popped items.
+     */
+    std::size_t tryPopBatch(T* items, const std::size_t max) { return _queue.popBatch(items, max); }
+
+    /**
+     * Tell producers the consumer is about to wait on fd() (e.g., with
+     * zmq::poll). Consumer thread only. Must be followed by finishWait.
+     *
+     * \return True if consumer may wait, false if items are already available.
+     */
+    bool prepareWait() {
+        _isSleeping.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in tryPush: either consumer sees the item
+        // or producer sees it sleeping.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!_queue.isEmpty()) {
+            // Producer may have already cleared the flag and notified,
+            // next wait then returns immediately (harmless).
+            _isSleeping.store(false, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * End a wait started with prepareWait. Consumer thread only.
+     *
+     * \param isNotified True if fd() was polled readable (notification is
+     *                   then consumed).
+     */
+    void finishWait(const bool isNotified) {
+        _isSleeping.store(false, std::memory_order_relaxed);
+        if (isNotified) {
+            _event.wait();  // Readable: doesn't block
+        }
+    }
+
+    /**
+     * File descriptor readable once an item is pushed while consumer waits.
+     *
+     * \return File descriptor.
+     */
+    int fd() const { return _event.fd(); }
+};
+
+}  // namespace collabserver
@@ -2,4 +2,22 @@
 
 #define COLLAB_DEFAULT_SERVER_PORT  4242
 #define COLLAB_SOCKET_SUB_PORT      4243
+#define COLLAB_DEFAULT_DATA_PORT    4244
 
+// Port of the second publisher (others follow), first one on COLLAB_SOCKET_SUB_PORT
+#define COLLAB_EXTRA_PUB_PORT  4245
+
+// Max number of history operations sent at once to joining users
+#define COLLAB_CATCH_UP_SLICE_SIZE  256
+
+// Max size of the operation buffers of a history page (MsgRoomHistoryPage)
+#define COLLAB_HISTORY_PAGE_MAX_BYTES  (1024 * 1024)
+
+// Max number of history operations read for one history page
+#define COLLAB_HISTORY_PAGE_MAX_OPS  4096
+
+// Max number of history operations coalesced at once (between requests)
+#define COLLAB_COALESCING_SLICE_SIZE  1024
+
+// Period of the checks for idle rooms to unload (hibernation), in milliseconds
+#define COLLAB_HIBERNATION_CHECK_MS  1000
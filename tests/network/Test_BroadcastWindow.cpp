@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "collabserver/server/network/BroadcastWindow.h"
+
+namespace collabserver {
+
+struct RecordSink {
+    std::vector<unsigned int> roomIDs;  // One per flush
+    std::vector<std::size_t> sizes;     // Number of operations per flush
+
+    BroadcastWindow::Sink make() {
+        return [this](const unsigned int roomID, std::vector<OperationInfo>& operations) {
+            roomIDs.push_back(roomID);
+            sizes.push_back(operations.size());
+        };
+    }
+};
+
+static OperationInfo local_makeOperation(const unsigned int roomID, const std::size_t size) {
+    OperationInfo op;
+    op.roomID = roomID;
+    op.userID = 1;
+    op.opTypeID = 0;
+    op.buffer = std::string(size, 'x');
+    return op;
+}
+
+TEST(BroadcastWindow, flushAll_oneFlushPerRoom) {
+    RecordSink sink;
+    BroadcastWindowConfig config;
+    config.delayUs = 1000000;
+    BroadcastWindow window(config, sink.make());
+
+    window.add(local_makeOperation(1, 10));
+    window.add(local_makeOperation(2, 10));
+    window.add(local_makeOperation(1, 10));
+    ASSERT_FALSE(window.isEmpty());
+    ASSERT_TRUE(sink.sizes.empty());
+
+    window.flushAll();
+    ASSERT_TRUE(window.isEmpty());
+    ASSERT_EQ(sink.roomIDs, std::vector<unsigned int>({1, 2}));
+    ASSERT_EQ(sink.sizes, std::vector<std::size_t>({2, 1}));
+}
+
+TEST(BroadcastWindow, add_flushOnceMaxBytesReached) {
+    RecordSink sink;
+    BroadcastWindowConfig config;
+    config.delayUs = 1000000;
+    config.maxBytes = 1000;
+    BroadcastWindow window(config, sink.make());
+
+    window.add(local_makeOperation(1, 400));
+    window.add(local_makeOperation(1, 400));
+    ASSERT_TRUE(sink.sizes.empty());
+    window.add(local_makeOperation(1, 400));
+    ASSERT_EQ(sink.sizes, std::vector<std::size_t>({3}));
+    ASSERT_TRUE(window.isEmpty());
+}
+
+TEST(BroadcastWindow, flushExpired_onlyOldRooms) {
+    RecordSink sink;
+    BroadcastWindowConfig config;
+    config.delayUs = 20000;
+    BroadcastWindow window(config, sink.make());
+
+    window.add(local_makeOperation(1, 10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    window.add(local_makeOperation(2, 10));
+
+    window.flushExpired();
+    ASSERT_EQ(sink.roomIDs, std::vector<unsigned int>({1}));
+    ASSERT_FALSE(window.isEmpty());
+
+    window.flushRoom(2);
+    ASSERT_TRUE(window.isEmpty());
+    window.flushExpired();  // Stale entries only
+    ASSERT_EQ(sink.roomIDs, std::vector<unsigned int>({1, 2}));
+}
+
+}  // namespace collabserver
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>  // SIZE_MAX
+#include <sstream>
+#include <string>
+
+#include "collabserver/server/network/CatchUpBundle.h"
+#include "collabserver/server/network/MsgRoomOperationBatch.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+static OperationInfo local_makeOperation(const std::size_t sequence) {
+    OperationInfo op;
+    op.roomID = 7;
+    op.userID = 100;
+    op.opTypeID = static_cast<unsigned int>(sequence);
+    op.buffer = std::string(sequence % 5, 'x');
+    op.sequence = sequence;
+    return op;
+}
+
+// Decode a frame built by CatchUpBundle::encode (as MessageCodec would).
+static bool local_decode(const std::string& frame, MsgRoomOperationBatch& msg) {
+    if (frame.empty() || static_cast<unsigned char>(frame[0]) != MSG_ROOM_OPERATION_BATCH) {
+        return false;
+    }
+    std::stringstream buffer(frame.substr(1));
+    return msg.unserialize(buffer);
+}
+
+TEST(CatchUpBundle, encode_sameAsBatchAcrossBlocks) {
+    CatchUpBundle bundle(7, SIZE_MAX);
+    for (std::size_t sequence = 1; sequence <= 3 * CatchUpBundle::BLOCK_SIZE; ++sequence) {
+        bundle.append(local_makeOperation(sequence));
+    }
+    ASSERT_EQ(bundle.getFirstIndex(), 0);
+    ASSERT_EQ(bundle.size(), 3 * CatchUpBundle::BLOCK_SIZE);
+
+    std::string frame;
+    const std::size_t first = CatchUpBundle::BLOCK_SIZE - 10;
+    const std::size_t last = 2 * CatchUpBundle::BLOCK_SIZE + 10;
+    ASSERT_TRUE(bundle.encode(first, last, frame));
+    MsgRoomOperationBatch msg;
+    ASSERT_TRUE(local_decode(frame, msg));
+    ASSERT_EQ(msg.getRoomID(), 7);
+    ASSERT_EQ(msg.getOperations().size(), last - first);
+    for (std::size_t k = 0; k < msg.getOperations().size(); ++k) {
+        const OperationInfo expected = local_makeOperation(first + k + 1);
+        ASSERT_EQ(msg.getOperations()[k].sequence, expected.sequence);
+        ASSERT_EQ(msg.getOperations()[k].userID, expected.userID);
+        ASSERT_EQ(msg.getOperations()[k].opTypeID, expected.opTypeID);
+        ASSERT_EQ(msg.getOperations()[k].buffer, expected.buffer);
+    }
+
+    // Byte for byte what the message would be
+    std::stringstream buffer;
+    buffer.put(static_cast<char>(MSG_ROOM_OPERATION_BATCH));
+    ASSERT_TRUE(msg.serialize(buffer));
+    ASSERT_EQ(frame, buffer.str());
+
+    ASSERT_FALSE(bundle.encode(10, 10, frame));
+    ASSERT_FALSE(bundle.encode(10, bundle.size() + 1, frame));
+}
+
+TEST(CatchUpBundle, append_oldestBlocksReleasedOverMaxBytes) {
+    CatchUpBundle bundle(7, 1000);
+    for (std::size_t sequence = 1; sequence <= 4 * CatchUpBundle::BLOCK_SIZE; ++sequence) {
+        bundle.append(local_makeOperation(sequence));
+    }
+    ASSERT_EQ(bundle.getFirstIndex(), 3 * CatchUpBundle::BLOCK_SIZE);  // The block being filled stays
+    ASSERT_EQ(bundle.size(), 4 * CatchUpBundle::BLOCK_SIZE);
+    ASSERT_FALSE(bundle.covers(0, bundle.size()));
+    ASSERT_TRUE(bundle.covers(bundle.getFirstIndex(), bundle.size()));
+}
+
+TEST(CatchUpBundle, append_gapStartsOver) {
+    CatchUpBundle bundle(7, SIZE_MAX);
+    for (std::size_t sequence = 1; sequence <= 10; ++sequence) {
+        bundle.append(local_makeOperation(sequence));
+    }
+    bundle.append(local_makeOperation(300));
+    ASSERT_EQ(bundle.getFirstIndex(), 299);
+    ASSERT_EQ(bundle.size(), 300);
+    ASSERT_FALSE(bundle.covers(0, 10));
+
+    bundle.append(local_makeOperation(301));  // Next block
+    std::string frame;
+    ASSERT_TRUE(bundle.encode(299, 301, frame));
+    MsgRoomOperationBatch msg;
+    ASSERT_TRUE(local_decode(frame, msg));
+    ASSERT_EQ(msg.getOperations().size(), 2);
+    ASSERT_EQ(msg.getOperations()[1].opTypeID, 301);
+}
+
+TEST(CatchUpBundle, discard_snapshotPosition) {
+    CatchUpBundle bundle(7, SIZE_MAX);
+    for (std::size_t sequence = 1; sequence <= 2 * CatchUpBundle::BLOCK_SIZE; ++sequence) {
+        bundle.append(local_makeOperation(sequence));
+    }
+    const std::size_t bytes = bundle.getBytes();
+    bundle.discard(CatchUpBundle::BLOCK_SIZE + 5);
+    ASSERT_EQ(bundle.getFirstIndex(), CatchUpBundle::BLOCK_SIZE + 5);
+    ASSERT_LT(bundle.getBytes(), bytes);
+    std::string frame;
+    ASSERT_TRUE(bundle.encode(CatchUpBundle::BLOCK_SIZE + 5, bundle.size(), frame));
+
+    bundle.discard(bundle.size());
+    ASSERT_EQ(bundle.getBytes(), 0);
+    bundle.append(local_makeOperation(bundle.size() + 1));
+    ASSERT_TRUE(bundle.covers(bundle.size() - 1, bundle.size()));
+}
+
+}  // namespace collabserver
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "collabserver/server/network/MsgPack.h"
+#include "collabserver/server/network/MsgRoomCatchUpDone.h"
+#include "collabserver/server/network/MsgRoomHistoryPage.h"
+#include "collabserver/server/network/MsgRoomHistoryRequest.h"
+#include "collabserver/server/network/MsgRoomOperationAck.h"
+#include "collabserver/server/network/MsgRoomOperationBatch.h"
+#include "collabserver/server/network/MsgRoomResumeRequest.h"
+#include "collabserver/server/network/MsgRoomSnapshot.h"
+#include "collabserver/server/network/ServerMessages.h"
+
+namespace collabserver {
+
+TEST(MsgPack, uint_roundTripAllFormats) {
+    const uint64_t values[] = {0, 1, 0x7f, 0x80, 0xff, 0x100, 0xffff, 0x10000, 0xffffffff, 0x100000000};
+    std::stringstream buffer;
+    for (const uint64_t value : values) {
+        MsgPack::packUint(buffer, value);
+    }
+    for (const uint64_t value : values) {
+        uint64_t read = 0;
+        ASSERT_TRUE(MsgPack::unpackUint(buffer, read));
+        ASSERT_EQ(read, value);
+    }
+    uint64_t read = 0;
+    ASSERT_FALSE(MsgPack::unpackUint(buffer, read));
+}
+
+TEST(MsgPack, uint_smallestFormat) {
+    std::stringstream buffer;
+    MsgPack::packUint(buffer, 42);
+    ASSERT_EQ(buffer.str(), std::string(1, 42));
+
+    buffer.str("");
+    MsgPack::packUint(buffer, 0x1234);
+    ASSERT_EQ(buffer.str(), std::string("\xcd\x12\x34", 3));
+}
+
+TEST(MsgPack, str_roundTripAllFormats) {
+    const std::string values[] = {"", "abc", std::string(31, 'a'), std::string(32, 'b'), std::string(300, 'c'),
+                                  std::string(70000, 'd')};
+    std::stringstream buffer;
+    for (const std::string& value : values) {
+        MsgPack::packStr(buffer, value);
+    }
+    for (const std::string& value : values) {
+        std::string read;
+        ASSERT_TRUE(MsgPack::unpackStr(buffer, read));
+        ASSERT_EQ(read, value);
+    }
+}
+
+TEST(MsgPack, str_truncated) {
+    std::stringstream buffer;
+    MsgPack::packStr(buffer, "Hello world");
+    std::stringstream truncated(buffer.str().substr(0, 5));
+    std::string read;
+    ASSERT_FALSE(MsgPack::unpackStr(truncated, read));
+}
+
+// -----------------------------------------------------------------------------
+// MsgRoomOperationBatch
+// -----------------------------------------------------------------------------
+
+TEST(MsgRoomOperationBatch, serialize_roundTrip) {
+    std::vector<OperationInfo> operations(3);
+    for (unsigned int k = 0; k < operations.size(); ++k) {
+        operations[k].roomID = 7;
+        operations[k].userID = 100 + k;
+        operations[k].opTypeID = k;
+        operations[k].buffer = std::string(k * 100, 'x');
+        operations[k].sequence = 41 + k;
+    }
+    MsgRoomOperationBatch msg(7, operations);
+    ASSERT_EQ(msg.getType(), MSG_ROOM_OPERATION_BATCH);
+
+    std::stringstream buffer;
+    ASSERT_TRUE(msg.serialize(buffer));
+
+    MsgRoomOperationBatch read;
+    ASSERT_TRUE(read.unserialize(buffer));
+    ASSERT_EQ(read.getRoomID(), 7);
+    ASSERT_EQ(read.getOperations().size(), 3);
+    for (unsigned int k = 0; k < operations.size(); ++k) {
+        ASSERT_EQ(read.getOperations()[k].roomID, 7);
+        ASSERT_EQ(read.getOperations()[k].userID, 100 + k);
+        ASSERT_EQ(read.getOperations()[k].opTypeID, k);
+        ASSERT_EQ(read.getOperations()[k].buffer, operations[k].buffer);
+        ASSERT_EQ(read.getOperations()[k].sequence, 41 + k);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// MsgRoomSnapshot
+// -----------------------------------------------------------------------------
+
+TEST(MsgRoomSnapshot, serialize_roundTrip) {
+    SnapshotInfo snapshot;
+    snapshot.roomID = 7;
+    snapshot.userID = 100;
+    snapshot.position = 0x100000000;
+    snapshot.buffer = std::string("\0state\0", 7);
+    MsgRoomSnapshot msg(snapshot);
+    ASSERT_EQ(msg.getType(), MSG_ROOM_SNAPSHOT);
+
+    std::stringstream buffer;
+    ASSERT_TRUE(msg.serialize(buffer));
+
+    MsgRoomSnapshot read;
+    ASSERT_TRUE(read.unserialize(buffer));
+    ASSERT_EQ(read.getSnapshot().roomID, 7);
+    ASSERT_EQ(read.getSnapshot().userID, 100);
+    ASSERT_EQ(read.getSnapshot().position, snapshot.position);
+    ASSERT_EQ(read.getSnapshot().buffer, snapshot.buffer);
+}
+
+// -----------------------------------------------------------------------------
+// MsgRoomResumeRequest
+// -----------------------------------------------------------------------------
+
+TEST(MsgRoomResumeRequest, serialize_roundTrip) {
+    MsgRoomResumeRequest msg(100, 7, 0x100000000);
+    ASSERT_EQ(msg.getType(), MSG_ROOM_RESUME_REQUEST);
+
+    std::stringstream buffer;
+    ASSERT_TRUE(msg.serialize(buffer));
+
+    MsgRoomResumeRequest read;
+    ASSERT_TRUE(read.unserialize(buffer));
+    ASSERT_EQ(read.getUserID(), 100);
+    ASSERT_EQ(read.getRoomID(), 7);
+    ASSERT_EQ(read.getSequence(), 0x100000000);
+}
+
+// -----------------------------------------------------------------------------
+// MsgRoomHistoryRequest / MsgRoomHistoryPage
+// -----------------------------------------------------------------------------
+
+TEST(MsgRoomHistoryRequest, serialize_roundTrip) {
+    MsgRoomHistoryRequest msg(100, 7, 42, 0x100000000, 65536);
+    ASSERT_EQ(msg.getType(), MSG_ROOM_HISTORY_REQUEST);
+
+    std::stringstream buffer;
+    ASSERT_TRUE(msg.serialize(buffer));
+
+    MsgRoomHistoryRequest read;
+    ASSERT_TRUE(read.unserialize(buffer));
+    ASSERT_EQ(read.getUserID(), 100);
+    ASSERT_EQ(read.getRoomID(), 7);
+    ASSERT_EQ(read.getFromSequence(), 42);
+    ASSERT_EQ(read.getToSequence(), 0x100000000);
+    ASSERT_EQ(read.getMaxBytes(), 65536);
+}
+
+TEST(MsgRoomHistoryPage, serialize_roundTrip) {
+    const std::string data("\0op\0", 4);
+    const std::string large(300, 'x');
+    LogRecord record;
+    record.roomID = 7;
+    record.userID = 100;
+    record.opTypeID = 3;
+    record.buffer = data.data();
+    record.bufferSize = data.size();
+
+    MsgRoomHistoryPage msg(7, 10, 500);
+    ASSERT_EQ(msg.getType(), MSG_ROOM_HISTORY_PAGE);
+    msg.addOperation(11, record);
+    record.buffer = large.data();
+    record.bufferSize = large.size();
+    msg.addOperation(13, record);  // 12 dropped
+    msg.setNextSequence(14);
+    ASSERT_EQ(msg.getNbOperations(), 2);
+
+    std::stringstream buffer;
+    ASSERT_TRUE(msg.serialize(buffer));
+
+    MsgRoomHistoryPage read;
+    ASSERT_TRUE(read.unserialize(buffer));
+    ASSERT_EQ(read.getRoomID(), 7);
+    ASSERT_EQ(read.getFirstSequence(), 10);
+    ASSERT_EQ(read.getLastSequence(), 500);
+    ASSERT_EQ(read.getNextSequence(), 14);
+    ASSERT_EQ(read.getOperations().size(), 2);
+    ASSERT_EQ(read.getOperations()[0].sequence, 11);
+    ASSERT_EQ(read.getOperations()[0].userID, 100);
+    ASSERT_EQ(read.getOperations()[0].opTypeID, 3);
+    ASSERT_EQ(read.getOperations()[0].buffer, data);
+    ASSERT_EQ(read.getOperations()[1].sequence, 13);
+    ASSERT_EQ(read.getOperations()[1].buffer, large);
+}
+
+// -----------------------------------------------------------------------------
+// MsgRoomOperationAck
+// -----------------------------------------------------------------------------
+
+TEST(MsgRoomOperationAck, serialize_roundTrip) {
+    MsgRoomOperationAck msg(7, 0x100000000);
+    ASSERT_EQ(msg.getType(), MSG_ROOM_OPERATION_ACK);
+
+    std::stringstream buffer;
+    ASSERT_TRUE(msg.serialize(buffer));
+
+    MsgRoomOperationAck read;
+    ASSERT_TRUE(read.unserialize(buffer));
+    ASSERT_EQ(read.getRoomID(), 7);
+    ASSERT_EQ(read.getSequence(), 0x100000000);
+}
+
+// -----------------------------------------------------------------------------
+// MsgRoomCatchUpDone
+// -----------------------------------------------------------------------------
+
+TEST(MsgRoomCatchUpDone, serialize_roundTrip) {
+    MsgRoomCatchUpDone msg(7, 42, 0x100000000);
+    ASSERT_EQ(msg.getType(), MSG_ROOM_CATCH_UP_DONE);
+
+    std::stringstream buffer;
+    ASSERT_TRUE(msg.serialize(buffer));
+
+    MsgRoomCatchUpDone read;
+    ASSERT_TRUE(read.unserialize(buffer));
+    ASSERT_EQ(read.getRoomID(), 7);
+    ASSERT_EQ(read.getUserID(), 42);
+    ASSERT_EQ(read.getSequence(), 0x100000000);
+}
+
+}  // namespace collabserver
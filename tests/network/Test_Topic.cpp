@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "collabserver/server/network/Topic.h"
+
+namespace collabserver {
+
+static bool local_isPrefix(const std::string& prefix, const std::string& topic) {
+    return topic.compare(0, prefix.size(), prefix) == 0;
+}
+
+TEST(Topic, user_fixedSizeAndUnique) {
+    ASSERT_EQ(Topic::user(1).size(), 5);
+    ASSERT_EQ(Topic::user(4242).size(), 5);
+    ASSERT_EQ(Topic::user(1), Topic::user(1));
+    ASSERT_NE(Topic::user(1), Topic::user(256));
+    ASSERT_NE(Topic::user(1), Topic::user(1u << 24));
+}
+
+TEST(Topic, room_differsFromUserWithSameID) {
+    ASSERT_EQ(Topic::room(4242).size(), 5);
+    ASSERT_NE(Topic::room(4242), Topic::room(4243));
+    ASSERT_NE(Topic::room(4242), Topic::user(4242));
+}
+
+TEST(Topic, catchUp_differsFromRoomWithSameID) {
+    ASSERT_EQ(Topic::catchUp(4242).size(), 5);
+    ASSERT_NE(Topic::catchUp(4242), Topic::room(4242));
+    ASSERT_NE(Topic::catchUp(4242), Topic::user(4242));
+}
+
+TEST(Topic, getID_sameAsMade) {
+    ASSERT_EQ(Topic::getID(Topic::user(4242)), 4242);
+    ASSERT_EQ(Topic::getID(Topic::room(0xfffffffe)), 0xfffffffe);
+    ASSERT_EQ(Topic::getID(Topic::catchUp(1u << 24)), 1u << 24);
+    ASSERT_EQ(Topic::getID("r42"), 0);
+}
+
+TEST(Topic, noTopicIsPrefixOfAnother) {
+    // Subscriber of a topic must never receive messages of another one
+    ASSERT_FALSE(local_isPrefix(Topic::user(1), Topic::user(12)));
+    ASSERT_FALSE(local_isPrefix(Topic::room(1), Topic::room(12)));
+    ASSERT_FALSE(local_isPrefix(Topic::room(42), Topic::user(42)));
+}
+
+}  // namespace collabserver
@@ -1,6 +1,18 @@
 #include <gtest/gtest.h>
 
+#include <stdlib.h>  // mkdtemp
+
+#include <algorithm>  // std::count, std::find, std::sort
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>  // std::pair
+#include <vector>
+
 #include "collabserver/server/room/Broadcaster.h"
+#include "collabserver/server/room/CoalescingRegistry.h"
 #include "collabserver/server/room/CollabServer.h"
 
 namespace collabserver {
@@ -10,9 +22,93 @@ class MockBroadcaster : public Broadcaster {
     void sendOperationToUser(const OperationInfo& op, const unsigned int userID) override {}
 
     void broadcastOperationToRoom(const OperationInfo& op, const unsigned int roomID) override {}
+
+    void sendSnapshotToUser(const SnapshotInfo& snapshot, const unsigned int userID) override {}
+
+    void sendOperationToStream(const OperationInfo& op, const unsigned int roomID) override {}
+
+    void sendSnapshotToStream(const SnapshotInfo& snapshot, const unsigned int roomID) override {}
 };
 static MockBroadcaster local_mockBroadcaster;
 
+class RecordBroadcaster : public Broadcaster {
+   public:
+    std::vector<unsigned int> sentOpTypes;     // Operations sent to a user (catch-up)
+    std::vector<std::size_t> sentSnapshots;    // Position of the snapshots sent to a user
+    std::vector<std::size_t> streamSequences;  // Operations sent to the shared catch-up
+    std::vector<std::size_t> streamSnapshots;  // Position of the snapshots sent to the shared catch-up
+    std::size_t nbBroadcasts = 0;
+    std::map<unsigned int, std::size_t> userDone;    // End of the catch-up of each user (own topic)
+    std::map<unsigned int, std::size_t> streamDone;  // End of the catch-up of each user (shared catch-up)
+
+    void sendOperationToUser(const OperationInfo& op, const unsigned int userID) override {
+        sentOpTypes.push_back(op.opTypeID);
+    }
+
+    void broadcastOperationToRoom(const OperationInfo& op, const unsigned int roomID) override { ++nbBroadcasts; }
+
+    void sendSnapshotToUser(const SnapshotInfo& snapshot, const unsigned int userID) override {
+        sentSnapshots.push_back(snapshot.position);
+    }
+
+    void sendOperationToStream(const OperationInfo& op, const unsigned int roomID) override {
+        streamSequences.push_back(op.sequence);
+    }
+
+    void sendSnapshotToStream(const SnapshotInfo& snapshot, const unsigned int roomID) override {
+        streamSnapshots.push_back(snapshot.position);
+    }
+
+    void sendCatchUpDoneToUser(unsigned int roomID, std::size_t end, unsigned int userID) override {
+        userDone[userID] = end;  // Latest join
+    }
+
+    void sendCatchUpDoneToStream(unsigned int userID, std::size_t end, unsigned int roomID) override {
+        streamDone[userID] = end;
+    }
+};
+
+class EncodedBroadcaster : public RecordBroadcaster {
+   public:
+    std::size_t encodedFirst = 0;                               // Operations before are not encoded
+    std::vector<std::pair<std::size_t, std::size_t>> sentRuns;  // Operations sent at once
+
+    bool sendOperationsToUser(unsigned int roomID, std::size_t first, std::size_t last, unsigned int id) override {
+        if (first < encodedFirst) {
+            return false;
+        }
+        sentRuns.emplace_back(first, last);
+        return true;
+    }
+};
+
+class UserRecordBroadcaster : public RecordBroadcaster {
+   public:
+    std::map<unsigned int, std::vector<std::size_t>> userSequences;  // Operations sent to each user on its own
+
+    void sendOperationToUser(const OperationInfo& op, const unsigned int userID) override {
+        RecordBroadcaster::sendOperationToUser(op, userID);
+        userSequences[userID].push_back(op.sequence);
+    }
+};
+
+static std::vector<std::size_t> local_sequences(const std::size_t first, const std::size_t last) {
+    std::vector<std::size_t> sequences;
+    for (std::size_t sequence = first; sequence <= last; ++sequence) {
+        sequences.push_back(sequence);
+    }
+    return sequences;
+}
+
+static OperationInfo local_makeOperation(const unsigned int roomID, const unsigned int userID,
+                                         const unsigned int opTypeID) {
+    OperationInfo op;
+    op.roomID = roomID;
+    op.userID = userID;
+    op.opTypeID = opTypeID;
+    return op;
+}
+
 TEST(CollabServer, constructor) { CollabServer server = CollabServer(local_mockBroadcaster); }
 
 // -----------------------------------------------------------------------------
@@ -114,4 +210,930 @@ TEST(CollabServer, isUserInRoom) {
     ASSERT_TRUE(server.isUserInRoom(u1->getUserID(), r1->getRoomID()));
 }
 
+// -----------------------------------------------------------------------------
+// RegisterUser / CreateNewRoom (with ID)
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, registerUser_keepsID) {
+    CollabServer server = CollabServer(local_mockBroadcaster);
+
+    const User* u1 = server.registerUser(4242);
+    ASSERT_TRUE(u1 != nullptr);
+    ASSERT_EQ(u1->getUserID(), 4242);
+    ASSERT_TRUE(server.hasUser(4242));
+    ASSERT_TRUE(server.registerUser(4242) == nullptr);
+    ASSERT_EQ(server.getNbUsers(), 1);
+}
+
+TEST(CollabServer, createNewRoom_withID) {
+    CollabServer server = CollabServer(local_mockBroadcaster);
+
+    const Room* r1 = server.createNewRoom(4242);
+    ASSERT_TRUE(r1 != nullptr);
+    ASSERT_EQ(r1->getRoomID(), 4242);
+    ASSERT_TRUE(server.createNewRoom(4242) == nullptr);
+    ASSERT_EQ(server.getNbRooms(), 1);
+
+    const User* u1 = server.registerUser(64);
+    ASSERT_TRUE(server.userJoinRoom(u1->getUserID(), 4242));
+    ASSERT_TRUE(server.isUserInRoom(64, 4242));
+}
+
+// -----------------------------------------------------------------------------
+// Join catch-up
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, continueCatchUps_historySentBySlices) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    ASSERT_FALSE(server.hasPendingCatchUps());  // Empty history
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+
+    // Join doesn't send anything by itself
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_TRUE(broadcaster.sentOpTypes.empty());
+    ASSERT_TRUE(server.hasPendingCatchUps());
+
+    ASSERT_EQ(server.continueCatchUps(4), 4);
+    ASSERT_EQ(broadcaster.sentOpTypes.size(), 4);
+
+    // Committed after the join: broadcasted live, not part of the catch-up
+    OperationInfo op = local_makeOperation(1000, 1, 10);
+    ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    ASSERT_EQ(broadcaster.nbBroadcasts, 11);
+
+    ASSERT_EQ(server.continueCatchUps(100), 6);
+    ASSERT_FALSE(server.hasPendingCatchUps());
+    ASSERT_EQ(server.continueCatchUps(100), 0);
+    ASSERT_EQ(broadcaster.sentOpTypes.size(), 10);
+    for (unsigned int k = 0; k < 10; ++k) {
+        ASSERT_EQ(broadcaster.sentOpTypes[k], k);
+    }
+}
+
+TEST(CollabServer, continueCatchUps_doneAfterLastSlice) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    ASSERT_EQ(broadcaster.userDone[1], 0);  // Nothing to catch up: told at once
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_EQ(server.continueCatchUps(4), 4);
+    OperationInfo op = local_makeOperation(1000, 1, 10);  // Live
+    ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    ASSERT_EQ(broadcaster.userDone.count(2), 0);
+    ASSERT_EQ(server.continueCatchUps(100), 6);
+    ASSERT_EQ(broadcaster.userDone[2], 10);
+    ASSERT_TRUE(broadcaster.streamDone.empty());
+}
+
+TEST(CollabServer, continueCatchUps_leaveStopsCatchUp) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_EQ(server.continueCatchUps(3), 3);
+    ASSERT_TRUE(server.userLeaveCurrentRoom(2));
+    ASSERT_EQ(server.continueCatchUps(100), 0);
+    ASSERT_FALSE(server.hasPendingCatchUps());
+    ASSERT_EQ(broadcaster.sentOpTypes.size(), 3);
+}
+
+// -----------------------------------------------------------------------------
+// Storage
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, restoreRooms_historySentAfterRestart) {
+    char storageDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(storageDir) != nullptr);
+    {
+        CollabServer server = CollabServer(local_mockBroadcaster);
+        server.enableStorage(storageDir);
+        ASSERT_TRUE(server.createNewRoom(1000) != nullptr);
+        server.registerUser(1);
+        ASSERT_TRUE(server.userJoinRoom(1, 1000));
+        for (unsigned int k = 0; k < 10; ++k) {
+            OperationInfo op = local_makeOperation(1000, 1, k);
+            ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+        }
+    }
+
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.enableStorage(storageDir);
+    ASSERT_EQ(server.restoreRooms(), 1);
+    ASSERT_TRUE(server.hasRoom(1000));
+    ASSERT_GE(Room::ROOM_ID_COUNTER, 1000);
+    const CollabServer& restored = server;
+    ASSERT_EQ(restored.findRoom(1000)->getNbOperations(), 10);
+
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_EQ(server.continueCatchUps(100), 10);
+    for (unsigned int k = 0; k < 10; ++k) {
+        ASSERT_EQ(broadcaster.sentOpTypes[k], k);
+    }
+}
+
+TEST(CollabServer, syncRooms_groupsCommits) {
+    char storageDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(storageDir) != nullptr);
+    CollabServer server = CollabServer(local_mockBroadcaster);
+    server.enableStorage(storageDir, Durability::GROUP_SYNC);
+    ASSERT_TRUE(server.createNewRoom(1000) != nullptr);
+    ASSERT_TRUE(server.createNewRoom(1001) != nullptr);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    ASSERT_TRUE(server.userJoinRoom(2, 1001));
+    ASSERT_FALSE(server.hasUnsyncedRooms());
+
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op1000 = local_makeOperation(1000, 1, k);
+        OperationInfo op1001 = local_makeOperation(1001, 2, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op1000, 1000));
+        ASSERT_TRUE(server.commitOperationInRoom(op1001, 1001));
+    }
+    ASSERT_TRUE(server.hasUnsyncedRooms());
+    const CollabServer& synced = server;
+    ASSERT_TRUE(synced.findRoom(1000)->hasUnsyncedOperations());
+
+    ASSERT_TRUE(server.syncRooms());
+    ASSERT_FALSE(server.hasUnsyncedRooms());
+    ASSERT_FALSE(synced.findRoom(1000)->hasUnsyncedOperations());
+    ASSERT_FALSE(synced.findRoom(1001)->hasUnsyncedOperations());
+}
+
+// -----------------------------------------------------------------------------
+// Snapshot
+// -----------------------------------------------------------------------------
+
+static SnapshotInfo local_makeSnapshot(const unsigned int roomID, const unsigned int userID,
+                                       const std::size_t position) {
+    SnapshotInfo snapshot;
+    snapshot.roomID = roomID;
+    snapshot.userID = userID;
+    snapshot.position = position;
+    snapshot.buffer = "state";
+    return snapshot;
+}
+
+TEST(CollabServer, installSnapshotInRoom_joinReceivesSnapshotThenTail) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+
+    ASSERT_FALSE(server.installSnapshotInRoom(local_makeSnapshot(1000, 2, 6), 1000));  // Not in room
+    ASSERT_FALSE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 11), 1000));
+    ASSERT_TRUE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 6), 1000));
+    ASSERT_FALSE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 5), 1000));  // Before current one
+
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_EQ(server.continueCatchUps(100), 5);
+    ASSERT_EQ(broadcaster.sentSnapshots, std::vector<std::size_t>({6}));
+    ASSERT_EQ(broadcaster.sentOpTypes, std::vector<unsigned int>({6, 7, 8, 9}));
+}
+
+TEST(CollabServer, installSnapshotInRoom_duringCatchUp) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_EQ(server.continueCatchUps(3), 3);
+
+    // Operations 3 to 7 are replaced by the snapshot
+    ASSERT_TRUE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 8), 1000));
+    server.continueCatchUps(100);
+    ASSERT_FALSE(server.hasPendingCatchUps());
+    ASSERT_EQ(broadcaster.sentSnapshots, std::vector<std::size_t>({8}));
+    ASSERT_EQ(broadcaster.sentOpTypes, std::vector<unsigned int>({0, 1, 2, 8, 9}));
+}
+
+// -----------------------------------------------------------------------------
+// History budget
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, setHistoryBudget_roomSpillsOldOperations) {
+    char spillDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(spillDir) != nullptr);
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    HistoryBudget budget;
+    budget.spillDir = spillDir;
+    budget.roomMaxOps = 300;
+    server.setHistoryBudget(budget);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 1000; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    const CollabServer& tiered = server;
+    ASSERT_LE(tiered.findRoom(1000)->getNbHotOperations(), 300);
+    ASSERT_EQ(tiered.findRoom(1000)->getNbOperations(), 1000);
+    ASSERT_EQ(server.getHistoryBytes(), tiered.findRoom(1000)->getHistoryBytes());
+
+    // Spilled part is read back from the files
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_EQ(server.continueCatchUps(2000), 1000);
+    for (unsigned int k = 0; k < 1000; ++k) {
+        ASSERT_EQ(broadcaster.sentOpTypes[k], k);
+    }
+    const HistoryStats stats = server.getHistoryStats();
+    ASSERT_EQ(stats.hotReads, tiered.findRoom(1000)->getNbHotOperations());
+    ASSERT_EQ(stats.hotReads + stats.coldReads, 1000);
+    ASSERT_LT(stats.getHitRate(), 0.5);
+}
+
+TEST(CollabServer, setHistoryBudget_serverSpillsLargestRoom) {
+    char spillDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(spillDir) != nullptr);
+    CollabServer server = CollabServer(local_mockBroadcaster);
+    HistoryBudget budget;
+    budget.spillDir = spillDir;
+    budget.serverMaxBytes = 64 * 1024;
+    server.setHistoryBudget(budget);
+    server.createNewRoom(1000);
+    server.createNewRoom(1001);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    ASSERT_TRUE(server.userJoinRoom(2, 1001));
+
+    OperationInfo small = local_makeOperation(1001, 2, 0);
+    ASSERT_TRUE(server.commitOperationInRoom(small, 1001));
+    for (unsigned int k = 0; k < 2000; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        op.buffer = std::string(100, 'x');
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+        ASSERT_LE(server.getHistoryBytes(), budget.serverMaxBytes);
+    }
+    const CollabServer& tiered = server;
+    ASSERT_EQ(tiered.findRoom(1001)->getNbHotOperations(), 1);  // Never the largest one
+    ASSERT_LT(tiered.findRoom(1000)->getNbHotOperations(), 2000);
+}
+
+TEST(CollabServer, setHistoryBudget_sharedCounterKeepsHotTails) {
+    char spillDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(spillDir) != nullptr);
+    std::shared_ptr<std::atomic<std::size_t>> historyBytes = std::make_shared<std::atomic<std::size_t>>(0);
+    HistoryBudget budget;
+    budget.spillDir = spillDir;
+    budget.serverMaxBytes = 64 * 1024;
+    CollabServer large = CollabServer(local_mockBroadcaster);
+    CollabServer small = CollabServer(local_mockBroadcaster);
+    large.setHistoryBudget(budget, historyBytes);
+    small.setHistoryBudget(budget, historyBytes);
+    large.createNewRoom(1000);
+    small.createNewRoom(1001);
+    large.registerUser(1);
+    small.registerUser(2);
+    ASSERT_TRUE(large.userJoinRoom(1, 1000));
+    ASSERT_TRUE(small.userJoinRoom(2, 1001));
+    const CollabServer& largeView = large;
+    const CollabServer& smallView = small;
+
+    // Large one holds the bytes (over budget on its own, within one chunk)
+    for (unsigned int k = 0; k < 250; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        op.buffer = std::string(300, 'x');
+        ASSERT_TRUE(large.commitOperationInRoom(op, 1000));
+    }
+    const std::size_t largeBytes = largeView.findRoom(1000)->getHistoryBytes();
+    ASSERT_GT(largeBytes, budget.serverMaxBytes);
+    ASSERT_EQ(largeView.findRoom(1000)->getNbHotOperations(), 250);
+
+    // Small one commits while over budget: its hot tail stays in memory
+    for (unsigned int k = 0; k < 600; ++k) {
+        OperationInfo op = local_makeOperation(1001, 2, k);
+        ASSERT_TRUE(small.commitOperationInRoom(op, 1001));
+    }
+    ASSERT_EQ(smallView.findRoom(1001)->getNbHotOperations(), 600 % OperationLog::CHUNK_SIZE);
+    ASSERT_EQ(smallView.findRoom(1001)->getNbOperations(), 600);
+    ASSERT_EQ(largeView.findRoom(1000)->getHistoryBytes(), largeBytes);
+
+    // Large one spills its older chunk once it starts a new one
+    for (unsigned int k = 250; k < 260; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        op.buffer = std::string(300, 'x');
+        ASSERT_TRUE(large.commitOperationInRoom(op, 1000));
+    }
+    ASSERT_EQ(largeView.findRoom(1000)->getNbHotOperations(), 260 - OperationLog::CHUNK_SIZE);
+    ASSERT_LT(historyBytes->load(), largeBytes);
+}
+
+TEST(CollabServer, setHistoryBudget_snapshotDiscardsSpilledOperations) {
+    char spillDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(spillDir) != nullptr);
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    HistoryBudget budget;
+    budget.spillDir = spillDir;
+    budget.roomMaxOps = 1;
+    server.setHistoryBudget(budget);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 600; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+
+    // Snapshot inside the spilled part, then after it
+    ASSERT_TRUE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 100), 1000));
+    const CollabServer& tiered = server;
+    ASSERT_EQ(tiered.findRoom(1000)->getFirstOperationIndex(), 100);
+    ASSERT_TRUE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 599), 1000));
+    ASSERT_EQ(tiered.findRoom(1000)->getFirstOperationIndex(), 599);
+    for (unsigned int k = 600; k < 1000; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    server.continueCatchUps(2000);
+    ASSERT_EQ(broadcaster.sentSnapshots, std::vector<std::size_t>({599}));
+    ASSERT_EQ(broadcaster.sentOpTypes.size(), 401);
+    for (unsigned int k = 0; k < 401; ++k) {
+        ASSERT_EQ(broadcaster.sentOpTypes[k], 599 + k);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Coalescing
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, continueCoalescing_dropsSupersededOperations) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    std::shared_ptr<CoalescingRegistry> registry = std::make_shared<CoalescingRegistry>();
+    registry->registerRule(1, CoalescingRegistry::byPrefix(1));
+    server.setCoalescing(registry);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+
+    // Type 1 sets the attribute named by its first byte, type 2 has no rule
+    const std::vector<std::pair<unsigned int, std::string>> operations = {
+        {1, "a1"}, {2, "z"}, {1, "b1"}, {1, "a2"}, {2, "z"}, {1, "b2"}, {1, "a3"}};
+    for (const auto& type_buffer : operations) {
+        OperationInfo op = local_makeOperation(1000, 1, type_buffer.first);
+        op.buffer = type_buffer.second;
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    ASSERT_EQ(broadcaster.nbBroadcasts, operations.size());  // Live broadcast not concerned
+    ASSERT_TRUE(server.hasPendingCoalescing());
+    ASSERT_EQ(server.continueCoalescing(100), operations.size());
+    ASSERT_FALSE(server.hasPendingCoalescing());
+    ASSERT_EQ(server.getHistoryStats().dropped, 3);
+
+    // Sequence numbers don't change
+    const CollabServer& coalesced = server;
+    ASSERT_EQ(coalesced.findRoom(1000)->getNbOperations(), operations.size());
+    ASSERT_TRUE(server.userJoinRoom(2, 1000, 1));
+    ASSERT_EQ(server.continueCatchUps(100), operations.size() - 1);
+    ASSERT_EQ(broadcaster.sentOpTypes, std::vector<unsigned int>({2, 2, 1, 1}));
+}
+
+TEST(CollabServer, continueCoalescing_spilledOperationsStayDropped) {
+    char spillDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(spillDir) != nullptr);
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    HistoryBudget budget;
+    budget.spillDir = spillDir;
+    budget.roomMaxOps = 300;
+    server.setHistoryBudget(budget);
+    std::shared_ptr<CoalescingRegistry> registry = std::make_shared<CoalescingRegistry>();
+    registry->registerRule(1, CoalescingRegistry::byType());
+    server.setCoalescing(registry);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 1000; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k % 2);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+        server.continueCoalescing(100);
+    }
+    const CollabServer& tiered = server;
+    ASSERT_LE(tiered.findRoom(1000)->getNbHotOperations(), 300);
+    ASSERT_EQ(server.getHistoryStats().dropped, 499);
+
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    server.continueCatchUps(2000);
+    ASSERT_EQ(broadcaster.sentOpTypes.size(), 501);
+    ASSERT_EQ(std::count(broadcaster.sentOpTypes.begin(), broadcaster.sentOpTypes.end(), 1), 1);
+    ASSERT_EQ(broadcaster.sentOpTypes.back(), 1);
+}
+
+// -----------------------------------------------------------------------------
+// Buffer deduplication
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, setBufferPool_sharedAcrossRooms) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    std::shared_ptr<BufferPool> pool = std::make_shared<BufferPool>();
+    server.setBufferPool(pool);
+    server.createNewRoom(1000);
+    server.createNewRoom(1001);
+    server.registerUser(1);
+    server.registerUser(2);
+    server.registerUser(3);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    ASSERT_TRUE(server.userJoinRoom(2, 1001));
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        op.buffer = "pasted block";
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    OperationInfo op = local_makeOperation(1001, 2, 0);
+    op.buffer = "pasted block";
+    ASSERT_TRUE(server.commitOperationInRoom(op, 1001));
+    ASSERT_EQ(pool->getNbBuffers(), 1);
+
+    const CollabServer& deduplicated = server;
+    ASSERT_EQ(deduplicated.findRoom(1000)->getDedupStats().savedBytes, 9 * op.buffer.size());
+    ASSERT_DOUBLE_EQ(deduplicated.findRoom(1000)->getDedupStats().getRatio(), 10.0);
+    ASSERT_EQ(deduplicated.findRoom(1001)->getDedupStats().savedBytes, op.buffer.size());
+    ASSERT_EQ(server.getDedupStats().bufferBytes, 11 * op.buffer.size());
+
+    // History is sent with the buffers
+    ASSERT_TRUE(server.userJoinRoom(3, 1000));
+    ASSERT_EQ(server.continueCatchUps(100), 10);
+    ASSERT_EQ(broadcaster.sentOpTypes.size(), 10);
+}
+
+// -----------------------------------------------------------------------------
+// History compression
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, setHistoryCompression_historyReadBack) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    CollabServer raw = CollabServer(local_mockBroadcaster);
+    server.setHistoryCompression(true);
+    server.createNewRoom(1000);
+    raw.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    raw.registerUser(1);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    ASSERT_TRUE(raw.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 2000; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        op.buffer = "{\"insert\":{\"position\":" + std::to_string(k) + ",\"text\":\"lorem ipsum dolor\"}}";
+        OperationInfo copy = op;
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+        ASSERT_TRUE(raw.commitOperationInRoom(copy, 1000));
+    }
+    ASSERT_LT(server.getHistoryBytes() * 3, raw.getHistoryBytes());
+
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_EQ(server.continueCatchUps(5000), 2000);
+    ASSERT_EQ(broadcaster.sentOpTypes.size(), 2000);
+    for (unsigned int k = 0; k < 2000; ++k) {
+        ASSERT_EQ(broadcaster.sentOpTypes[k], k);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Sequence numbers
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, commitOperationInRoom_setsSequence) {
+    CollabServer server = CollabServer(local_mockBroadcaster);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 3; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+        ASSERT_EQ(op.sequence, k + 1);
+    }
+}
+
+TEST(CollabServer, userJoinRoom_resumeAfterSequence) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+
+    ASSERT_FALSE(server.userJoinRoom(2, 1000, 11));  // Ahead of the room
+    ASSERT_TRUE(server.userJoinRoom(2, 1000, 7));
+    ASSERT_EQ(server.continueCatchUps(100), 3);
+    ASSERT_EQ(broadcaster.sentOpTypes, std::vector<unsigned int>({7, 8, 9}));
+
+    // Up to date: nothing to catch up
+    ASSERT_TRUE(server.userLeaveCurrentRoom(2));
+    ASSERT_TRUE(server.userJoinRoom(2, 1000, 10));
+    ASSERT_FALSE(server.hasPendingCatchUps());
+}
+
+TEST(CollabServer, userJoinRoom_resumeBeforeSnapshot) {
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    ASSERT_TRUE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 6), 1000));
+
+    // Operations the user misses were discarded: snapshot first
+    ASSERT_TRUE(server.userJoinRoom(2, 1000, 2));
+    server.continueCatchUps(100);
+    ASSERT_EQ(broadcaster.sentSnapshots, std::vector<std::size_t>({6}));
+    ASSERT_EQ(broadcaster.sentOpTypes, std::vector<unsigned int>({6, 7, 8, 9}));
+
+    // After the snapshot: no snapshot
+    broadcaster.sentSnapshots.clear();
+    broadcaster.sentOpTypes.clear();
+    ASSERT_TRUE(server.userLeaveCurrentRoom(2));
+    ASSERT_TRUE(server.userJoinRoom(2, 1000, 8));
+    server.continueCatchUps(100);
+    ASSERT_TRUE(broadcaster.sentSnapshots.empty());
+    ASSERT_EQ(broadcaster.sentOpTypes, std::vector<unsigned int>({8, 9}));
+}
+
+TEST(CollabServer, continueCatchUps_encodedRunsSentAtOnce) {
+    EncodedBroadcaster broadcaster;
+    broadcaster.encodedFirst = 2;
+    CollabServer server = CollabServer(broadcaster);
+    std::shared_ptr<CoalescingRegistry> registry = std::make_shared<CoalescingRegistry>();
+    registry->registerRule(1, CoalescingRegistry::byType());
+    server.setCoalescing(registry);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    const std::vector<unsigned int> opTypes = {0, 1, 2, 1, 4, 5, 6, 7, 8, 9};
+    for (const unsigned int opTypeID : opTypes) {
+        OperationInfo op = local_makeOperation(1000, 1, opTypeID);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    server.continueCoalescing(100);  // Drops the operation at index 1
+
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    server.continueCatchUps(100);
+    ASSERT_EQ(broadcaster.sentOpTypes, std::vector<unsigned int>({0}));  // Not encoded
+    ASSERT_EQ(broadcaster.sentRuns.size(), 1);
+    ASSERT_EQ(broadcaster.sentRuns[0].first, 2);
+    ASSERT_EQ(broadcaster.sentRuns[0].second, 10);
+    ASSERT_EQ(server.getHistoryStats().encodedReads, 8);
+    ASSERT_EQ(server.getHistoryStats().hotReads, 1);
+}
+
+// -----------------------------------------------------------------------------
+// Shared catch-ups
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, sharedCatchUps_lateJoinersGetMissingPartAlone) {
+    UserRecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.setSharedCatchUps(true);
+    server.createNewRoom(1000);
+    for (unsigned int userID = 1; userID <= 4; ++userID) {
+        server.registerUser(userID);
+    }
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 300; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));  // Starts the stream
+    ASSERT_EQ(server.continueCatchUps(64), 64);
+    ASSERT_TRUE(server.userJoinRoom(3, 1000));  // Attaches at 64
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    ASSERT_EQ(server.continueCatchUps(64), 64);  // Stream first: up to 128
+    ASSERT_TRUE(server.userJoinRoom(4, 1000));   // Attaches later, misses the last ones too
+    while (server.hasPendingCatchUps()) {
+        server.continueCatchUps(100);
+    }
+
+    ASSERT_EQ(broadcaster.streamSequences, local_sequences(1, 300));  // Sent once
+    ASSERT_EQ(broadcaster.userSequences.count(2), 0);
+    ASSERT_EQ(broadcaster.userSequences[3], local_sequences(1, 64));
+    std::vector<std::size_t> expected = local_sequences(1, 128);
+    const std::vector<std::size_t> committedSince = local_sequences(301, 310);
+    expected.insert(expected.end(), committedSince.begin(), committedSince.end());
+    std::sort(broadcaster.userSequences[4].begin(), broadcaster.userSequences[4].end());  // Two parts, round robin
+    ASSERT_EQ(broadcaster.userSequences[4], expected);
+    ASSERT_GT(server.getHistoryStats().sharedReads, 0);
+
+    // Each user told after its last part (Shared or its own), with the end of all its parts
+    ASSERT_EQ(broadcaster.streamDone.size(), 1);
+    ASSERT_EQ(broadcaster.streamDone[2], 300);
+    ASSERT_EQ(broadcaster.userDone.size(), 3);
+    ASSERT_EQ(broadcaster.userDone[1], 0);
+    ASSERT_EQ(broadcaster.userDone[3], 300);
+    ASSERT_EQ(broadcaster.userDone[4], 310);
+}
+
+TEST(CollabServer, sharedCatchUps_snapshotSentOnceToStream) {
+    UserRecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.setSharedCatchUps(true);
+    server.createNewRoom(1000);
+    for (unsigned int userID = 1; userID <= 4; ++userID) {
+        server.registerUser(userID);
+    }
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 300; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_EQ(server.continueCatchUps(64), 64);
+    ASSERT_TRUE(server.userJoinRoom(3, 1000));
+    ASSERT_TRUE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 100), 1000));
+    ASSERT_TRUE(server.userJoinRoom(4, 1000, 200));  // Has more than the snapshot: on its own
+    ASSERT_TRUE(server.userLeaveCurrentRoom(2));       // Stream goes on for user 3
+    while (server.hasPendingCatchUps()) {
+        server.continueCatchUps(100);
+    }
+
+    ASSERT_EQ(broadcaster.streamSnapshots, std::vector<std::size_t>({100}));
+    ASSERT_TRUE(broadcaster.sentSnapshots.empty());
+    std::vector<std::size_t> expected = local_sequences(1, 64);
+    const std::vector<std::size_t> afterSnapshot = local_sequences(101, 300);
+    expected.insert(expected.end(), afterSnapshot.begin(), afterSnapshot.end());
+    ASSERT_EQ(broadcaster.streamSequences, expected);
+    ASSERT_EQ(broadcaster.userSequences.count(3), 0);
+    ASSERT_EQ(broadcaster.userSequences[4], local_sequences(201, 300));
+
+    // Stream stops with its last user
+    ASSERT_TRUE(server.userLeaveCurrentRoom(3));
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    ASSERT_TRUE(server.userLeaveCurrentRoom(2));
+    ASSERT_FALSE(server.hasPendingCatchUps() && server.continueCatchUps(100) > 0);
+}
+
+// -----------------------------------------------------------------------------
+// Hibernation
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, hibernateRoom_historyReloadedOnJoin) {
+    char directory[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(directory) != nullptr);
+    RecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    HistoryBudget budget;
+    budget.spillDir = directory;
+    budget.roomMaxOps = 300;
+    server.setHistoryBudget(budget);
+    std::shared_ptr<CoalescingRegistry> registry = std::make_shared<CoalescingRegistry>();
+    registry->registerRule(1, CoalescingRegistry::byType());
+    server.setCoalescing(registry);
+    server.setHibernation(directory, std::chrono::milliseconds(0));
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 1000; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k % 2 == 0 ? k : 1);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+        server.continueCoalescing(100);
+    }
+    ASSERT_TRUE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 10), 1000));
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    server.continueCatchUps(2000);
+    const std::vector<unsigned int> expected = broadcaster.sentOpTypes;
+    broadcaster.sentOpTypes.clear();
+    broadcaster.sentSnapshots.clear();
+
+    ASSERT_FALSE(server.hibernateRoom(1000));  // Not empty
+    ASSERT_TRUE(server.userLeaveCurrentRoom(1));
+    ASSERT_TRUE(server.userLeaveCurrentRoom(2));
+    ASSERT_TRUE(server.hibernateRoom(1000));
+    ASSERT_FALSE(server.hasRoom(1000));
+    ASSERT_EQ(server.getHistoryBytes(), 0);
+    ASSERT_FALSE(server.userJoinRoom(2, 1000));
+
+    // Same history, same sequence numbers
+    const Room* room = server.restoreRoom(1000);
+    ASSERT_TRUE(room != nullptr);
+    ASSERT_EQ(room->getNbOperations(), 1000);
+    ASSERT_EQ(room->getFirstOperationIndex(), 10);
+    ASSERT_LE(room->getNbHotOperations(), 300);
+    ASSERT_TRUE(server.userJoinRoom(2, 1000));
+    server.continueCatchUps(2000);
+    ASSERT_EQ(broadcaster.sentSnapshots, std::vector<std::size_t>({10}));
+    ASSERT_EQ(broadcaster.sentOpTypes, expected);
+
+    ASSERT_TRUE(server.userJoinRoom(1, 1000, 1000));
+    OperationInfo op = local_makeOperation(1000, 1, 1);
+    ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    ASSERT_EQ(op.sequence, 1001);
+    ASSERT_TRUE(server.restoreRoom(1000) == nullptr);  // Already loaded
+}
+
+TEST(CollabServer, adoptHibernatedRoom_restoredFromArchive) {
+    char directory[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(directory) != nullptr);
+    CollabServer server = CollabServer(local_mockBroadcaster);
+    server.setHibernation(directory, std::chrono::milliseconds(0));
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    ASSERT_TRUE(server.userLeaveCurrentRoom(1));
+    ASSERT_TRUE(server.hibernateRoom(1000));
+
+    // e.g., room worker of the room destroyed once unloaded, then a new one
+    CollabServer other = CollabServer(local_mockBroadcaster);
+    other.setHibernation(directory, std::chrono::milliseconds(0));
+    ASSERT_TRUE(other.restoreRoom(1000) == nullptr);  // Unknown
+    other.adoptHibernatedRoom(1000);
+    const Room* room = other.restoreRoom(1000);
+    ASSERT_TRUE(room != nullptr);
+    ASSERT_EQ(room->getNbOperations(), 10);
+}
+
+TEST(CollabServer, hibernateIdleRooms_emptyRoomsOnly) {
+    char directory[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(directory) != nullptr);
+    CollabServer server = CollabServer(local_mockBroadcaster);
+    ASSERT_EQ(server.hibernateIdleRooms(), 0);  // Disabled
+    server.setHibernation(directory, std::chrono::milliseconds(0));
+    server.createNewRoom(1000);
+    server.createNewRoom(1001);
+    server.registerUser(1);
+    ASSERT_TRUE(server.userJoinRoom(1, 1001));
+
+    ASSERT_EQ(server.hibernateIdleRooms(), 1);
+    ASSERT_FALSE(server.hasRoom(1000));
+    ASSERT_TRUE(server.hasRoom(1001));
+    ASSERT_TRUE(server.restoreRoom(1000) != nullptr);
+    ASSERT_EQ(server.getNbRooms(), 2);
+}
+
+TEST(CollabServer, hibernateRoom_persistedRoomReopened) {
+    char storageDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(storageDir) != nullptr);
+    CollabServer server = CollabServer(local_mockBroadcaster);
+    server.enableStorage(storageDir);
+    server.setHibernation("", std::chrono::milliseconds(0));  // No archive needed
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 10; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    ASSERT_TRUE(server.userLeaveCurrentRoom(1));
+    ASSERT_EQ(server.hibernateIdleRooms(), 1);
+    ASSERT_FALSE(server.hasRoom(1000));
+
+    const Room* room = server.restoreRoom(1000);
+    ASSERT_TRUE(room != nullptr);
+    ASSERT_EQ(room->getNbOperations(), 10);
+}
+
+// -----------------------------------------------------------------------------
+// History pages
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, readHistoryInRoom_pagesByBytes) {
+    char spillDir[] = "/tmp/collabserver-test-XXXXXX";
+    ASSERT_TRUE(::mkdtemp(spillDir) != nullptr);
+    MockBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    HistoryBudget budget;
+    budget.spillDir = spillDir;
+    budget.roomMaxOps = 300;
+    server.setHistoryBudget(budget);
+    std::shared_ptr<CoalescingRegistry> registry = std::make_shared<CoalescingRegistry>();
+    registry->registerRule(7777, CoalescingRegistry::byType());
+    server.setCoalescing(registry);
+    server.createNewRoom(1000);
+    server.registerUser(1);
+    server.registerUser(2);
+    ASSERT_TRUE(server.userJoinRoom(1, 1000));
+    for (unsigned int k = 0; k < 1000; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1, (k == 900 || k == 950) ? 7777 : k);
+        op.buffer = "abcd";
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+    }
+    server.continueCoalescing(1000);  // Drops the operation at index 900
+    ASSERT_TRUE(server.installSnapshotInRoom(local_makeSnapshot(1000, 1, 50), 1000));
+
+    // Pages from the spilled part, then from memory, without the dropped one
+    std::vector<std::size_t> sequences;
+    std::size_t nbPages = 0;
+    std::size_t next = 0;
+    std::size_t fromSequence = 1;
+    while (fromSequence <= 1000) {
+        const std::size_t pageFirst = sequences.size();
+        ASSERT_TRUE(server.readHistoryInRoom(
+            1, 1000, fromSequence, 0, 400,
+            [&sequences](const std::size_t index, const LogRecord& record) {
+                ASSERT_EQ(std::string(record.buffer, record.bufferSize), "abcd");
+                sequences.push_back(index + 1);
+            },
+            next));
+        ASSERT_LE(sequences.size() - pageFirst, 100);
+        fromSequence = next + 1;
+        ++nbPages;
+    }
+    std::vector<std::size_t> expected = local_sequences(51, 1000);
+    expected.erase(std::find(expected.begin(), expected.end(), 901));
+    ASSERT_EQ(sequences, expected);
+    ASSERT_EQ(nbPages, 10);
+
+    // A page holds at least one operation, and only the asked range
+    sequences.clear();
+    auto record = [&sequences](const std::size_t index, const LogRecord&) { sequences.push_back(index + 1); };
+    ASSERT_TRUE(server.readHistoryInRoom(1, 1000, 900, 902, 1, record, next));
+    ASSERT_EQ(sequences, std::vector<std::size_t>({900}));
+    ASSERT_TRUE(server.readHistoryInRoom(1, 1000, next + 1, 902, 1, record, next));
+    ASSERT_EQ(sequences, std::vector<std::size_t>({900, 902}));
+    ASSERT_EQ(next, 902);
+
+    // Only the users of the room
+    ASSERT_FALSE(server.readHistoryInRoom(2, 1000, 1, 0, 400, [](const std::size_t, const LogRecord&) {}, next));
+}
+
+// -----------------------------------------------------------------------------
+// Echo suppression
+// -----------------------------------------------------------------------------
+
+TEST(CollabServer, setEchoSuppression_senderSkipped) {
+    UserRecordBroadcaster broadcaster;
+    CollabServer server = CollabServer(broadcaster);
+    server.setEchoSuppression(true);
+    server.createNewRoom(1000);
+    for (unsigned int userID = 1; userID <= 3; ++userID) {
+        server.registerUser(userID);
+        ASSERT_TRUE(server.userJoinRoom(userID, 1000));
+    }
+    for (unsigned int k = 0; k < 4; ++k) {
+        OperationInfo op = local_makeOperation(1000, 1 + k % 2, k);
+        ASSERT_TRUE(server.commitOperationInRoom(op, 1000));
+        ASSERT_EQ(op.sequence, k + 1);  // For the acknowledgement
+    }
+
+    ASSERT_EQ(broadcaster.nbBroadcasts, 0);
+    ASSERT_EQ(broadcaster.userSequences[1], std::vector<std::size_t>({2, 4}));
+    ASSERT_EQ(broadcaster.userSequences[2], std::vector<std::size_t>({1, 3}));
+    ASSERT_EQ(broadcaster.userSequences[3], local_sequences(1, 4));
+}
+
 }  // namespace collabserver
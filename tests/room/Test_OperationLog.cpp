@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "collabserver/server/room/OperationLog.h"
+
+namespace collabserver {
+
+static OperationInfo local_makeOperation(const unsigned int opTypeID) {
+    OperationInfo op;
+    op.roomID = 1;
+    op.userID = 1;
+    op.opTypeID = opTypeID;
+    op.buffer = "op";
+    return op;
+}
+
+TEST(OperationLog, append_indexAcrossChunks) {
+    OperationLog log;
+    ASSERT_TRUE(log.isEmpty());
+
+    const unsigned int nbOps = 3 * OperationLog::CHUNK_SIZE + 7;
+    for (unsigned int k = 0; k < nbOps; ++k) {
+        log.append(local_makeOperation(k));
+    }
+    ASSERT_EQ(log.size(), nbOps);
+    for (unsigned int k = 0; k < nbOps; ++k) {
+        ASSERT_EQ(log[k].opTypeID, k);
+    }
+}
+
+TEST(OperationLog, append_neverMovesOperations) {
+    OperationLog log;
+    log.append(local_makeOperation(0));
+    const OperationInfo* first = &log[0];
+    const char* firstBuffer = log[0].buffer.data();
+
+    for (unsigned int k = 1; k < 10 * OperationLog::CHUNK_SIZE; ++k) {
+        log.append(local_makeOperation(k));
+    }
+    ASSERT_EQ(&log[0], first);
+    ASSERT_EQ(log[0].buffer.data(), firstBuffer);
+}
+
+TEST(OperationLog, forEach_range) {
+    OperationLog log;
+    for (unsigned int k = 0; k < 2 * OperationLog::CHUNK_SIZE; ++k) {
+        log.append(local_makeOperation(k));
+    }
+
+    std::vector<unsigned int> ids;
+    const std::size_t first = OperationLog::CHUNK_SIZE - 3;
+    const std::size_t last = OperationLog::CHUNK_SIZE + 2;
+    log.forEach(first, last, [&ids](const OperationInfo& op) { ids.push_back(op.opTypeID); });
+    ASSERT_EQ(ids.size(), last - first);
+    for (std::size_t k = 0; k < ids.size(); ++k) {
+        ASSERT_EQ(ids[k], first + k);
+    }
+
+    ids.clear();
+    log.forEach(4, 4, [&ids](const OperationInfo& op) { ids.push_back(op.opTypeID); });
+    ASSERT_TRUE(ids.empty());
+}
+
+TEST(OperationLog, truncate_keepsIndexes) {
+    OperationLog log;
+    for (unsigned int k = 0; k < 3 * OperationLog::CHUNK_SIZE; ++k) {
+        log.append(local_makeOperation(k));
+    }
+
+    const std::size_t position = OperationLog::CHUNK_SIZE + 5;
+    log.truncate(position);
+    ASSERT_EQ(log.getFirstIndex(), position);
+    ASSERT_EQ(log.size(), 3 * OperationLog::CHUNK_SIZE);
+    ASSERT_EQ(log[position].opTypeID, position);
+
+    std::vector<unsigned int> ids;
+    log.forEach(log.getFirstIndex(), log.size(), [&ids](const OperationInfo& op) { ids.push_back(op.opTypeID); });
+    ASSERT_EQ(ids.size(), log.size() - position);
+    ASSERT_EQ(ids.front(), position);
+
+    // Truncated up to the end: next operations keep their index
+    log.truncate(log.size());
+    ASSERT_TRUE(log.isEmpty());
+    log.append(local_makeOperation(42));
+    ASSERT_EQ(log[3 * OperationLog::CHUNK_SIZE].opTypeID, 42);
+    ASSERT_EQ(log.getFirstIndex(), 3 * OperationLog::CHUNK_SIZE);
+}
+
+TEST(OperationLog, getBytes_countsKeptOperations) {
+    OperationLog log;
+    OperationInfo op = local_makeOperation(0);
+    op.buffer = std::string(100, 'x');
+    for (unsigned int k = 0; k < 2 * OperationLog::CHUNK_SIZE; ++k) {
+        log.append(op);
+    }
+    ASSERT_EQ(log.getBytes(), 2 * OperationLog::CHUNK_SIZE * OperationLog::getBytes(op));
+
+    log.truncate(OperationLog::CHUNK_SIZE + 10);  // Whole chunk and part of the next one
+    ASSERT_EQ(log.getBytes(), (OperationLog::CHUNK_SIZE - 10) * OperationLog::getBytes(op));
+    log.truncate(log.size());
+    ASSERT_EQ(log.getBytes(), 0);
+}
+
+TEST(OperationLog, drop_keepsIndexes) {
+    OperationLog log;
+    OperationInfo op = local_makeOperation(0);
+    op.buffer = std::string(100, 'x');
+    for (unsigned int k = 0; k < OperationLog::CHUNK_SIZE + 10; ++k) {
+        op.opTypeID = k;
+        log.append(op);
+    }
+    const std::size_t bytes = log.getBytes();
+
+    log.drop(3);
+    log.drop(OperationLog::CHUNK_SIZE + 1);
+    log.drop(3);  // Already dropped
+    ASSERT_TRUE(log.isDropped(3));
+    ASSERT_FALSE(log.isDropped(4));
+    ASSERT_EQ(log.getBytes(), bytes - 2 * op.buffer.size());
+    ASSERT_EQ(log.size(), OperationLog::CHUNK_SIZE + 10);
+    ASSERT_EQ(log[4].opTypeID, 4);
+
+    std::vector<unsigned int> ids;
+    log.forEach(2, 5, [&ids](const OperationInfo& op) { ids.push_back(op.opTypeID); });
+    ASSERT_EQ(ids, std::vector<unsigned int>({2, 4}));
+    ids.clear();
+    log.forEach(0, log.size(), [&ids](const OperationInfo& op) { ids.push_back(op.opTypeID); });
+    ASSERT_EQ(ids.size(), log.size() - 2);
+}
+
+TEST(OperationLog, setBufferPool_identicalBuffersStoredOnce) {
+    std::shared_ptr<BufferPool> pool = std::make_shared<BufferPool>();
+    OperationLog log;
+    OperationLog other;
+    log.setBufferPool(pool);
+    other.setBufferPool(pool);
+    OperationInfo op = local_makeOperation(0);
+    for (unsigned int k = 0; k < OperationLog::CHUNK_SIZE + 10; ++k) {
+        op.opTypeID = k;
+        op.buffer = std::string(100, (k % 2 == 0) ? 'a' : 'b');
+        log.append(op);
+    }
+    other.append(op);
+    ASSERT_EQ(pool->getNbBuffers(), 2);
+    ASSERT_EQ(pool->getBytes(), 200);
+    ASSERT_EQ(log.getDedupStats().bufferBytes, (OperationLog::CHUNK_SIZE + 10) * 100);
+    ASSERT_EQ(log.getDedupStats().savedBytes, (OperationLog::CHUNK_SIZE + 8) * 100);
+    ASSERT_EQ(other.getDedupStats().savedBytes, 100);  // Shared with the other log
+
+    // Operations are rebuilt with their buffer
+    ASSERT_EQ(log[3].opTypeID, 3);
+    ASSERT_EQ(log[3].buffer, std::string(100, 'b'));
+    std::string buffers;
+    log.forEach(0, 2, [&buffers](const OperationInfo& op) { buffers += op.buffer.substr(0, 1); });
+    ASSERT_EQ(buffers, "ab");
+
+    // Buffers freed with their last reference
+    log.truncate(log.size());
+    ASSERT_EQ(log.getDedupStats().bufferBytes, 0);
+    ASSERT_EQ(pool->getNbBuffers(), 1);
+    other.truncate(other.size());
+    ASSERT_EQ(pool->getNbBuffers(), 0);
+    ASSERT_EQ(pool->getBytes(), 0);
+}
+
+TEST(OperationLog, compress_fullChunksReadBack) {
+    OperationLog log;
+    OperationInfo op = local_makeOperation(0);
+    for (unsigned int k = 0; k < 3 * OperationLog::CHUNK_SIZE + 10; ++k) {
+        op.opTypeID = k;
+        op.sequence = k + 1;
+        op.buffer = "{\"attribute\":" + std::to_string(k % 10) + ",\"value\":\"some repeated text\"}";
+        log.append(op);
+    }
+    const std::size_t bytes = log.getBytes();
+
+    // Chunk being filled stays raw
+    ASSERT_EQ(log.compress(log.size()), 3);
+    ASSERT_EQ(log.compress(log.size()), 0);
+    ASSERT_LT(log.getBytes() * 3, bytes);
+    ASSERT_EQ(log[5].opTypeID, 5);
+    ASSERT_EQ(log[5].sequence, 6);
+    ASSERT_EQ(log[5].buffer, "{\"attribute\":5,\"value\":\"some repeated text\"}");
+    ASSERT_EQ(log[3 * OperationLog::CHUNK_SIZE + 1].opTypeID, 3 * OperationLog::CHUNK_SIZE + 1);
+
+    log.drop(7);  // Only flagged in a compressed chunk
+    std::vector<unsigned int> ids;
+    log.forEach(0, log.size(), [&ids](const OperationInfo& op) { ids.push_back(op.opTypeID); });
+    ASSERT_EQ(ids.size(), log.size() - 1);
+    ASSERT_EQ(ids[7], 8);
+    ASSERT_EQ(ids.back(), log.size() - 1);
+
+    log.truncate(OperationLog::CHUNK_SIZE + 3);
+    ASSERT_EQ(log[OperationLog::CHUNK_SIZE + 3].opTypeID, OperationLog::CHUNK_SIZE + 3);
+    log.truncate(log.size());
+    ASSERT_EQ(log.getBytes(), 0);
+}
+
+TEST(OperationLog, start_keepsIndexes) {
+    OperationLog log;
+    log.start(OperationLog::CHUNK_SIZE + 10);
+    ASSERT_TRUE(log.isEmpty());
+    ASSERT_EQ(log.getFirstIndex(), OperationLog::CHUNK_SIZE + 10);
+    ASSERT_EQ(log.size(), OperationLog::CHUNK_SIZE + 10);
+
+    OperationInfo op = local_makeOperation(0);
+    for (unsigned int k = 0; k < OperationLog::CHUNK_SIZE; ++k) {
+        op.opTypeID = k;
+        log.append(op);
+    }
+    ASSERT_EQ(log.getBytes(), OperationLog::CHUNK_SIZE * OperationLog::getBytes(op));
+    ASSERT_EQ(log[OperationLog::CHUNK_SIZE + 10].opTypeID, 0);
+    ASSERT_EQ(log[2 * OperationLog::CHUNK_SIZE + 9].opTypeID, OperationLog::CHUNK_SIZE - 1);
+    ASSERT_EQ(log.compress(log.size()), 1);  // Front chunk is full
+    std::vector<unsigned int> ids;
+    log.forEach(log.getFirstIndex(), log.size(), [&ids](const OperationInfo& op) { ids.push_back(op.opTypeID); });
+    ASSERT_EQ(ids.size(), OperationLog::CHUNK_SIZE);
+    ASSERT_EQ(ids.front(), 0);
+
+    log.truncate(log.size());
+    ASSERT_EQ(log.getBytes(), 0);
+}
+
+}  // namespace collabserver
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>  // std::find
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "collabserver/server/scheduler/Strand.h"
+#include "collabserver/server/scheduler/TaskScheduler.h"
+
+namespace collabserver {
+
+// -----------------------------------------------------------------------------
+// TaskScheduler
+// -----------------------------------------------------------------------------
+
+TEST(TaskScheduler, stop_runsAllSubmittedTasks) {
+    std::atomic<int> counter(0);
+    TaskScheduler scheduler(4);
+    scheduler.start();
+    for (int k = 0; k < 1000; ++k) {
+        scheduler.submit([&counter] { counter.fetch_add(1); });
+    }
+    scheduler.stop();
+    ASSERT_EQ(counter.load(), 1000);
+}
+
+TEST(TaskScheduler, submit_fromWorkerThread) {
+    std::atomic<int> counter(0);
+    TaskScheduler scheduler(2);
+    scheduler.start();
+    for (int k = 0; k < 100; ++k) {
+        scheduler.submit([&scheduler, &counter] {
+            scheduler.submit([&counter] { counter.fetch_add(1); });
+        });
+    }
+    scheduler.stop();
+    ASSERT_EQ(counter.load(), 100);
+}
+
+// -----------------------------------------------------------------------------
+// Strand
+// -----------------------------------------------------------------------------
+
+TEST(Strand, post_tasksRunInOrderAndOneAtATime) {
+    const int nbStrands = 8;
+    const int nbTasks = 500;
+    TaskScheduler scheduler(4);
+
+    std::vector<Strand*> strands;
+    std::vector<std::vector<int>> results(nbStrands);
+    std::vector<std::atomic<int>> running(nbStrands);
+    std::atomic<int> nbOverlaps(0);
+    for (int s = 0; s < nbStrands; ++s) {
+        strands.push_back(new Strand(scheduler));
+        running[s].store(0);
+    }
+
+    scheduler.start();
+    for (int k = 0; k < nbTasks; ++k) {
+        for (int s = 0; s < nbStrands; ++s) {
+            strands[s]->post([&, s, k] {
+                if (running[s].fetch_add(1) != 0) {
+                    nbOverlaps.fetch_add(1);
+                }
+                results[s].push_back(k);
+                running[s].fetch_sub(1);
+            });
+        }
+    }
+    scheduler.stop();
+
+    ASSERT_EQ(nbOverlaps.load(), 0);
+    for (int s = 0; s < nbStrands; ++s) {
+        ASSERT_EQ(results[s].size(), nbTasks);
+        for (int k = 0; k < nbTasks; ++k) {
+            ASSERT_EQ(results[s][k], k);
+        }
+        delete strands[s];
+    }
+}
+
+TEST(Strand, run_busyStrandYieldsToOthers) {
+    TaskScheduler scheduler(1);
+    Strand busy(scheduler);
+    Strand other(scheduler);
+    std::vector<int> results;
+
+    // First task of the busy strand wakes up the other one (same worker)
+    busy.post([&] { other.post([&results] { results.push_back(-1); }); });
+    for (int k = 0; k < 1000; ++k) {
+        busy.post([&results, k] { results.push_back(k); });
+    }
+    scheduler.start();
+    scheduler.stop();
+
+    ASSERT_EQ(results.size(), 1001);
+    const std::size_t position = std::find(results.begin(), results.end(), -1) - results.begin();
+    ASSERT_LT(position, 100);  // After one budget of the busy strand, not after all its tasks
+}
+
+TEST(Strand, run_busyStrandProgressesDuringExternalSubmits) {
+    const int nbSubmits = 100;
+    TaskScheduler scheduler(1);
+    Strand busy(scheduler);
+    std::atomic<bool> isDone(false);
+    std::atomic<int> nbBusyTasks(0);
+
+    // Busy strand always has a pending task, until the end
+    std::function<void()> busyTask;
+    busyTask = [&] {
+        nbBusyTasks.fetch_add(1);
+        if (!isDone.load()) {
+            busy.post(busyTask);
+        }
+    };
+    busy.post(busyTask);
+
+    // Steady stream from outside the pool: each task waits for the next one,
+    // so that the worker never runs out of new tasks.
+    std::atomic<int> nbSubmitted(0);
+    std::atomic<int> nbStarted(0);
+    std::vector<int> busyCounts(nbSubmits);
+    scheduler.start();
+    std::thread submitter([&] {
+        for (int k = 0; k < nbSubmits; ++k) {
+            scheduler.submit([&, k] {
+                busyCounts[k] = nbBusyTasks.load();
+                nbStarted.fetch_add(1);
+                while (k + 1 < nbSubmits && nbSubmitted.load() < k + 2) {
+                }
+            });
+            nbSubmitted.fetch_add(1);
+            while (nbStarted.load() < k + 1) {
+            }
+        }
+    });
+    submitter.join();
+    isDone.store(true);
+    scheduler.stop();
+
+    // Busy strand runs between the external tasks, not only once they stop
+    ASSERT_GE(busyCounts[nbSubmits - 1] - busyCounts[0], (nbSubmits / 2) * 32);
+}
+
+TEST(Strand, isIdle_onceAllTasksRan) {
+    TaskScheduler scheduler(2);
+    Strand strand(scheduler);
+    ASSERT_TRUE(strand.isIdle());
+    std::atomic<int> counter(0);
+    for (int k = 0; k < 100; ++k) {
+        strand.post([&counter] { counter.fetch_add(1); });
+    }
+    ASSERT_FALSE(strand.isIdle());  // Not started yet
+
+    scheduler.start();
+    while (!strand.isIdle()) {
+    }
+    ASSERT_EQ(counter.load(), 100);
+    scheduler.stop();
+}
+
+}  // namespace collabserver
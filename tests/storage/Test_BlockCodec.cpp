@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>  // std::rand
+#include <string>
+
+#include "collabserver/server/storage/BlockCodec.h"
+
+namespace collabserver {
+
+static std::string local_roundtrip(const std::string& data, std::size_t& compressedSize) {
+    std::string block;
+    BlockCodec::compress(data.data(), data.size(), block);
+    compressedSize = block.size();
+    std::string decompressed;
+    EXPECT_TRUE(BlockCodec::decompress(block.data(), block.size(), decompressed));
+    return decompressed;
+}
+
+TEST(BlockCodec, roundtrip_emptyAndShort) {
+    std::size_t compressedSize = 0;
+    ASSERT_EQ(local_roundtrip("", compressedSize), "");
+    ASSERT_EQ(local_roundtrip("abc", compressedSize), "abc");
+    ASSERT_EQ(local_roundtrip("abcabcabc", compressedSize), "abcabcabc");
+}
+
+TEST(BlockCodec, roundtrip_repetitiveDataShrinks) {
+    std::string data;
+    for (unsigned int k = 0; k < 2000; ++k) {
+        data += "{\"op\":\"setStyle\",\"id\":" + std::to_string(k % 50) + ",\"bold\":true}";
+    }
+    data += std::string(1000, 'x');  // Long match (Length over 255)
+    std::size_t compressedSize = 0;
+    ASSERT_EQ(local_roundtrip(data, compressedSize), data);
+    ASSERT_LT(compressedSize * 10, data.size());
+}
+
+TEST(BlockCodec, roundtrip_randomData) {
+    std::string data(100000, '\0');
+    std::srand(42);
+    for (char& byte : data) {
+        byte = static_cast<char>(std::rand() & 0xff);  // Long literals
+    }
+    std::size_t compressedSize = 0;
+    ASSERT_EQ(local_roundtrip(data, compressedSize), data);
+    ASSERT_LT(compressedSize, data.size() + data.size() / 100);
+}
+
+TEST(BlockCodec, decompress_rejectsCorruptedBlock) {
+    const std::string data = std::string(500, 'a') + "bcd" + std::string(500, 'a');
+    std::string block;
+    BlockCodec::compress(data.data(), data.size(), block);
+    std::string decompressed;
+
+    ASSERT_FALSE(BlockCodec::decompress(block.data(), 3, decompressed));                 // No size
+    ASSERT_FALSE(BlockCodec::decompress(block.data(), block.size() - 1, decompressed));  // Truncated
+    std::string badOffset = block;
+    badOffset[6] = static_cast<char>(0xff);  // Offset of the first match, before the start
+    badOffset[7] = static_cast<char>(0xff);
+    ASSERT_FALSE(BlockCodec::decompress(badOffset.data(), badOffset.size(), decompressed));
+}
+
+}  // namespace collabserver
@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+
+#include <dirent.h>
+#include <stdlib.h>  // mkdtemp
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>  // std::sort
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "collabserver/server/storage/RoomLog.h"
+
+namespace collabserver {
+
+static std::string local_makeStorageDir() {
+    char path[] = "/tmp/collabserver-test-XXXXXX";
+    return ::mkdtemp(path) != nullptr ? std::string(path) : std::string();
+}
+
+static OperationInfo local_makeOperation(const unsigned int opTypeID, const std::string& buffer) {
+    OperationInfo op;
+    op.roomID = 42;
+    op.userID = 7;
+    op.opTypeID = opTypeID;
+    op.buffer = buffer;
+    return op;
+}
+
+static std::vector<unsigned int> local_readOpTypes(const RoomLog& log, std::size_t first, std::size_t last) {
+    std::vector<unsigned int> opTypes;
+    log.forEach(first, last, [&opTypes](const LogRecord& record) { opTypes.push_back(record.opTypeID); });
+    return opTypes;
+}
+
+TEST(RoomLog, append_readRecords) {
+    const std::string storageDir = local_makeStorageDir();
+    std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42));
+    ASSERT_TRUE(log != nullptr);
+    ASSERT_TRUE(log->isEmpty());
+
+    ASSERT_TRUE(log->append(local_makeOperation(1, "first")));
+    ASSERT_TRUE(log->append(local_makeOperation(2, std::string("\0bin\0", 5))));
+    ASSERT_TRUE(log->append(local_makeOperation(3, "")));
+    ASSERT_EQ(log->size(), 3);
+
+    std::vector<std::string> buffers;
+    log->forEach(0, log->size(), [&buffers](const LogRecord& record) {
+        ASSERT_EQ(record.roomID, 42);
+        ASSERT_EQ(record.userID, 7);
+        buffers.emplace_back(record.buffer, record.bufferSize);
+    });
+    ASSERT_EQ(buffers.size(), 3);
+    ASSERT_EQ(buffers[0], "first");
+    ASSERT_EQ(buffers[1], std::string("\0bin\0", 5));
+    ASSERT_EQ(buffers[2], "");
+}
+
+TEST(RoomLog, append_segmentBlocksAllocated) {
+    // Writes through the mapping must never fault on a full disk (SIGBUS)
+    const std::string storageDir = local_makeStorageDir();
+    const std::size_t segmentSize = 64 * 1024;
+    std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42, segmentSize));
+    ASSERT_TRUE(log != nullptr);
+    ASSERT_TRUE(log->append(local_makeOperation(1, "first")));
+
+    struct stat info;
+    ASSERT_EQ(::stat((storageDir + "/room-42/00000000000000000000.seg").c_str(), &info), 0);
+    ASSERT_EQ(info.st_size, static_cast<off_t>(segmentSize));
+    ASSERT_GE(static_cast<std::size_t>(info.st_blocks) * 512, segmentSize);
+}
+
+TEST(RoomLog, open_restoresRecordsAcrossSegments) {
+    const std::string storageDir = local_makeStorageDir();
+    const std::size_t segmentSize = 4096;
+    const std::string buffer(100, 'x');
+    {
+        std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42, segmentSize));
+        ASSERT_TRUE(log != nullptr);
+        for (unsigned int k = 0; k < 200; ++k) {  // About 6 segments
+            ASSERT_TRUE(log->append(local_makeOperation(k, buffer)));
+        }
+        ASSERT_TRUE(log->append(local_makeOperation(200, std::string(3 * segmentSize, 'y'))));  // Own segment
+        ASSERT_TRUE(log->append(local_makeOperation(201, buffer)));
+    }
+
+    std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42, segmentSize));
+    ASSERT_TRUE(log != nullptr);
+    ASSERT_EQ(log->size(), 202);
+    const std::vector<unsigned int> opTypes = local_readOpTypes(*log, 0, log->size());
+    for (unsigned int k = 0; k < opTypes.size(); ++k) {
+        ASSERT_EQ(opTypes[k], k);
+    }
+
+    const std::vector<unsigned int> range = local_readOpTypes(*log, 37, 201);
+    ASSERT_EQ(range.size(), 201 - 37);
+    ASSERT_EQ(range.front(), 37);
+    ASSERT_EQ(range.back(), 200);
+}
+
+TEST(RoomLog, open_ignoresTornRecord) {
+    const std::string storageDir = local_makeStorageDir();
+    {
+        std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42));
+        ASSERT_TRUE(log != nullptr);
+        ASSERT_TRUE(log->append(local_makeOperation(1, "kept")));
+        ASSERT_TRUE(log->append(local_makeOperation(2, "torn")));
+    }
+
+    // Corrupt the last byte of the second record (as if crash during write)
+    const std::string path = storageDir + "/room-42/00000000000000000000.seg";
+    FILE* file = std::fopen(path.c_str(), "r+b");
+    ASSERT_TRUE(file != nullptr);
+    const long offset = static_cast<long>(2 * LogRecord::HEADER_SIZE + 4 + 3);
+    std::fseek(file, offset, SEEK_SET);
+    std::fputc('!', file);
+    std::fclose(file);
+
+    std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42));
+    ASSERT_TRUE(log != nullptr);
+    ASSERT_EQ(log->size(), 1);
+    ASSERT_TRUE(log->append(local_makeOperation(3, "next")));
+    ASSERT_EQ(local_readOpTypes(*log, 0, log->size()), std::vector<unsigned int>({1, 3}));
+}
+
+TEST(RoomLog, open_segmentsAfterGapMovedAside) {
+    const std::string storageDir = local_makeStorageDir();
+    const std::size_t segmentSize = 4096;
+    const std::string buffer(100, 'x');
+    std::vector<uint64_t> firstIndexes;
+    {
+        std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42, segmentSize));
+        ASSERT_TRUE(log != nullptr);
+        for (unsigned int k = 0; k < 100; ++k) {  // About 3 segments
+            ASSERT_TRUE(log->append(local_makeOperation(k, buffer)));
+        }
+    }
+
+    // Second segment lost (as if torn by a crash): third one is after a gap
+    DIR* dir = ::opendir((storageDir + "/room-42").c_str());
+    ASSERT_TRUE(dir != nullptr);
+    std::vector<std::string> names;
+    while (struct dirent* entry = ::readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            names.push_back(entry->d_name);
+        }
+    }
+    ::closedir(dir);
+    std::sort(names.begin(), names.end());
+    ASSERT_GE(names.size(), 3);
+    ASSERT_EQ(::unlink((storageDir + "/room-42/" + names[1]).c_str()), 0);
+
+    std::size_t size = 0;
+    {
+        std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42, segmentSize));
+        ASSERT_TRUE(log != nullptr);
+        ASSERT_LT(log->size(), 100);
+        for (unsigned int k = 0; k < 100; ++k) {  // Over the indexes of the stale segments
+            ASSERT_TRUE(log->append(local_makeOperation(1000 + k, buffer)));
+        }
+        size = log->size();
+    }
+    ASSERT_EQ(::access((storageDir + "/room-42/" + names[2] + ".stale").c_str(), F_OK), 0);
+
+    // Records appended after the gap are all restored
+    std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42, segmentSize));
+    ASSERT_TRUE(log != nullptr);
+    ASSERT_EQ(log->size(), size);
+    ASSERT_EQ(local_readOpTypes(*log, size - 1, size), std::vector<unsigned int>({1099}));
+}
+
+TEST(RoomLog, installSnapshot_deletesOldSegments) {
+    const std::string storageDir = local_makeStorageDir();
+    const std::size_t segmentSize = 4096;
+    const std::string buffer(100, 'x');
+    {
+        std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42, segmentSize));
+        ASSERT_TRUE(log != nullptr);
+        for (unsigned int k = 0; k < 100; ++k) {
+            ASSERT_TRUE(log->append(local_makeOperation(k, buffer)));
+        }
+
+        SnapshotInfo snapshot;
+        snapshot.roomID = 42;
+        snapshot.userID = 7;
+        snapshot.position = 101;
+        ASSERT_FALSE(log->installSnapshot(snapshot));  // After the last record
+        snapshot.position = 90;
+        snapshot.buffer = "state";
+        ASSERT_TRUE(log->installSnapshot(snapshot));
+        ASSERT_EQ(log->getFirstIndex(), 90);
+        ASSERT_EQ(log->size(), 100);
+        ASSERT_TRUE(log->append(local_makeOperation(100, buffer)));
+    }
+
+    std::unique_ptr<RoomLog> log(RoomLog::open(storageDir, 42, segmentSize));
+    ASSERT_TRUE(log != nullptr);
+    ASSERT_TRUE(log->hasSnapshot());
+    ASSERT_EQ(log->getFirstIndex(), 90);
+    ASSERT_EQ(log->size(), 101);
+    ASSERT_EQ(local_readOpTypes(*log, 90, 101).front(), 90);
+
+    SnapshotInfo snapshot;
+    ASSERT_TRUE(log->loadSnapshot(snapshot));
+    ASSERT_EQ(snapshot.position, 90);
+    ASSERT_EQ(snapshot.userID, 7);
+    ASSERT_EQ(snapshot.buffer, "state");
+
+    // Segments before the snapshot are gone (First one started at 0)
+    const std::string firstSegment = storageDir + "/room-42/00000000000000000000.seg";
+    ASSERT_NE(::access(firstSegment.c_str(), F_OK), 0);
+}
+
+TEST(RoomLog, createTemporary_noFileLeft) {
+    const std::string directory = local_makeStorageDir();
+    std::unique_ptr<RoomLog> log(RoomLog::createTemporary(directory, 1000, 4096));
+    ASSERT_TRUE(log != nullptr);
+    ASSERT_EQ(log->getFirstIndex(), 1000);
+    const std::string buffer(100, 'x');
+    for (unsigned int k = 1000; k < 1100; ++k) {
+        ASSERT_TRUE(log->append(local_makeOperation(k, buffer)));
+    }
+    ASSERT_EQ(log->size(), 1100);
+    ASSERT_EQ(local_readOpTypes(*log, 1098, 1100), std::vector<unsigned int>({1098, 1099}));
+    ASSERT_EQ(::rmdir(directory.c_str()), 0);  // Segment files are unnamed
+
+    ASSERT_FALSE(log->discard(1101));
+    ASSERT_TRUE(log->discard(1090));
+    ASSERT_EQ(log->getFirstIndex(), 1090);
+    ASSERT_EQ(local_readOpTypes(*log, 1090, 1092), std::vector<unsigned int>({1090, 1091}));
+    ASSERT_FALSE(log->installSnapshot(SnapshotInfo()));
+}
+
+TEST(RoomLog, listRoomIDs) {
+    const std::string storageDir = local_makeStorageDir();
+    ASSERT_TRUE(RoomLog::listRoomIDs(storageDir).empty());
+    ASSERT_FALSE(RoomLog::exists(storageDir, 3));
+
+    std::unique_ptr<RoomLog> log3(RoomLog::open(storageDir, 3));
+    std::unique_ptr<RoomLog> log12(RoomLog::open(storageDir, 12));
+    ASSERT_TRUE(RoomLog::exists(storageDir, 3));
+
+    std::vector<unsigned int> roomIDs = RoomLog::listRoomIDs(storageDir);
+    std::sort(roomIDs.begin(), roomIDs.end());
+    ASSERT_EQ(roomIDs, std::vector<unsigned int>({3, 12}));
+}
+
+}  // namespace collabserver
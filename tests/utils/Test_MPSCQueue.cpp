@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <poll.h>
+
+#include <thread>
+#include <vector>
+
+#include "collabserver/server/utils/MPSCQueue.h"
+#include "collabserver/server/utils/Mailbox.h"
+
+namespace collabserver {
+
+// -----------------------------------------------------------------------------
+// MPSCQueue
+// -----------------------------------------------------------------------------
+
+TEST(MPSCQueue, capacity_roundedUpToPowerOfTwo) {
+    MPSCQueue<int> q1(1);
+    MPSCQueue<int> q2(5);
+    MPSCQueue<int> q3(64);
+    ASSERT_EQ(q1.capacity(), 2);
+    ASSERT_EQ(q2.capacity(), 8);
+    ASSERT_EQ(q3.capacity(), 64);
+}
+
+TEST(MPSCQueue, tryPushTryPop_fifoOrder) {
+    MPSCQueue<int> queue(8);
+    int value = 0;
+    ASSERT_FALSE(queue.tryPop(value));
+
+    for (int k = 0; k < 8; ++k) {
+        int item = k;
+        ASSERT_TRUE(queue.tryPush(item));
+    }
+    int extra = 42;
+    ASSERT_FALSE(queue.tryPush(extra));  // Full
+
+    for (int k = 0; k < 8; ++k) {
+        ASSERT_TRUE(queue.tryPop(value));
+        ASSERT_EQ(value, k);
+    }
+    ASSERT_FALSE(queue.tryPop(value));
+}
+
+TEST(MPSCQueue, popBatch_wrapAround) {
+    MPSCQueue<int> queue(4);
+    int items[4];
+    int next = 0;
+    int expected = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (int k = 0; k < 3; ++k) {
+            int item = next++;
+            ASSERT_TRUE(queue.tryPush(item));
+        }
+        ASSERT_EQ(queue.popBatch(items, 2), 2);
+        ASSERT_EQ(queue.popBatch(items + 2, 4), 1);
+        for (int k = 0; k < 3; ++k) {
+            ASSERT_EQ(items[k], expected++);
+        }
+    }
+}
+
+TEST(MPSCQueue, multipleProducers_noLossAndPerProducerOrder) {
+    const int nbProducers = 4;
+    const int nbItems = 20000;
+    MPSCQueue<int> queue(64);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < nbProducers; ++p) {
+        producers.emplace_back([&queue, p, nbItems] {
+            for (int k = 0; k < nbItems; ++k) {
+                int item = p * nbItems + k;
+                while (!queue.tryPush(item)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> last(nbProducers, -1);
+    int count = 0;
+    int item = 0;
+    while (count < nbProducers * nbItems) {
+        if (queue.tryPop(item)) {
+            const int producer = item / nbItems;
+            ASSERT_LT(last[producer], item % nbItems);
+            last[producer] = item % nbItems;
+            ++count;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    ASSERT_FALSE(queue.tryPop(item));
+}
+
+// -----------------------------------------------------------------------------
+// Mailbox
+// -----------------------------------------------------------------------------
+
+TEST(Mailbox, waitBatch_wakesUpSleepingConsumer) {
+    const int nbItems = 10000;
+    Mailbox<int> mailbox(16);
+
+    std::thread producer([&mailbox, nbItems] {
+        for (int k = 1; k <= nbItems; ++k) {
+            mailbox.push(k);
+        }
+    });
+
+    int items[8];
+    int expected = 1;
+    while (expected <= nbItems) {
+        const std::size_t count = mailbox.waitBatch(items, 8);
+        ASSERT_GE(count, 1);
+        for (std::size_t k = 0; k < count; ++k) {
+            ASSERT_EQ(items[k], expected++);
+        }
+    }
+    producer.join();
+}
+
+TEST(Mailbox, prepareWait_pollFdWakesUpOnPush) {
+    Mailbox<int> mailbox(16);
+    int item = 1;
+    int items[4];
+
+    // Not empty: consumer must not wait
+    ASSERT_TRUE(mailbox.tryPush(item));
+    ASSERT_FALSE(mailbox.prepareWait());
+    mailbox.finishWait(false);
+    ASSERT_EQ(mailbox.tryPopBatch(items, 4), 1);
+
+    // Empty: a push while waiting makes the fd readable
+    ASSERT_TRUE(mailbox.prepareWait());
+    std::thread producer([&mailbox] { mailbox.push(42); });
+    struct pollfd pfd = {mailbox.fd(), POLLIN, 0};
+    ASSERT_EQ(poll(&pfd, 1, 5000), 1);
+    producer.join();
+    mailbox.finishWait(true);
+    ASSERT_EQ(mailbox.tryPopBatch(items, 4), 1);
+    ASSERT_EQ(items[0], 42);
+
+    // Notification consumed: fd is not readable anymore
+    ASSERT_EQ(poll(&pfd, 1, 0), 0);
+}
+
+}  // namespace collabserver